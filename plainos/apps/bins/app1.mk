@@ -24,3 +24,5 @@ C_SRCS += $(APPS_DIR)/bins/app1.c
 C_SRCS += $(APPS_DIR)/bins/pl_ls.c
 C_SRCS += $(APPS_DIR)/bins/pl_clear.c
 C_SRCS += $(APPS_DIR)/bins/pl_reboot.c
+C_SRCS += $(APPS_DIR)/bins/pl_irqstat.c
+C_SRCS += $(APPS_DIR)/bins/pl_meminfo.c
@@ -0,0 +1,30 @@
+#include <types.h>
+#include <appcall.h>
+#include <kernel/irq.h>
+#include <kernel/syslog.h>
+
+/**************************************************************************************
+ * @brief: Lists the statistics of all threaded interrupts.
+ *
+ * @param argc: The count of arguments, unused.
+ * @param argv: The arguments, unused.
+ * @return: Always 0.
+ *************************************************************************************/
+static int plsh_irqstat(int argc, char *argv[])
+{
+	USED(argc);
+	USED(argv);
+	struct pl_irq_desc *desc;
+	struct pl_irq_stats stats;
+
+	pl_syslog("irq\tprio\tcount\tthread\ttop_max\tlat_max\tname\r\n");
+	for (desc = pl_irq_next_desc(NULL); desc != NULL; desc = pl_irq_next_desc(desc)) {
+		pl_irq_get_stats(desc, &stats);
+		pl_syslog("%u\t%u\t%u\t%u\t%u\t%u\t%s\r\n", desc->irq, desc->prio,
+		          stats.count, stats.thread_count, stats.top_max_cycles,
+		          stats.thread_max_latency, desc->name);
+	}
+
+	return 0;
+}
+pl_app_register(plsh_irqstat, "irqstat");
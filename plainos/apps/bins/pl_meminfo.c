@@ -0,0 +1,150 @@
+#include <config.h>
+#include <types.h>
+#include <appcall.h>
+#include <kernel/task.h>
+#include <kernel/mempool.h>
+#include <kernel/arena.h>
+#include <kernel/syslog.h>
+
+#define MEMINFO_MAX_OWNERS                (16)
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+struct meminfo_owner {
+	void *owner;
+	size_t bytes;
+	size_t count;
+};
+
+/* the pool is locked in the callback, only the static table is touched */
+static struct meminfo_owner meminfo_owners[MEMINFO_MAX_OWNERS];
+static size_t meminfo_nr_owners;
+
+/**************************************************************************************
+ * @brief: Adds an allocation to the usage of its owner.
+ *
+ * @param p: The address of memory, unused.
+ * @param size: The usable size of memory.
+ * @param owner: The task which allocated the memory, NULL for system.
+ * @param arg: Unused.
+ *************************************************************************************/
+static void meminfo_count_owner(void *p, size_t size, void *owner, void *arg)
+{
+	size_t i;
+
+	USED(p);
+	USED(arg);
+	for (i = 0; i < meminfo_nr_owners; i++) {
+		if (meminfo_owners[i].owner == owner)
+			break;
+	}
+
+	if (i == meminfo_nr_owners) {
+		if (meminfo_nr_owners == MEMINFO_MAX_OWNERS)
+			return;
+
+		meminfo_owners[i].owner = owner;
+		meminfo_owners[i].bytes = 0;
+		meminfo_owners[i].count = 0;
+		meminfo_nr_owners++;
+	}
+
+	meminfo_owners[i].bytes += size;
+	meminfo_owners[i].count++;
+}
+
+/**************************************************************************************
+ * @brief: Lists the memory usage of each task.
+ *************************************************************************************/
+static void meminfo_show_owners(void)
+{
+	size_t i;
+	const char *name;
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+	struct pl_mempool_region region;
+#endif
+
+	meminfo_nr_owners = 0;
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+	for (i = 0; pl_mempool_get_region(i, &region) == 0; i++)
+		pl_mempool_walk(region.mempool, meminfo_count_owner, NULL);
+#else
+	pl_mempool_walk(g_pl_default_mempool, meminfo_count_owner, NULL);
+#endif
+
+	pl_syslog("\r\nbytes\tallocs\towner\r\n");
+	for (i = 0; i < meminfo_nr_owners; i++) {
+		name = pl_task_get_name(meminfo_owners[i].owner);
+		pl_syslog("%u\t%u\t%s\r\n", (u32_t)meminfo_owners[i].bytes,
+		          (u32_t)meminfo_owners[i].count, name != NULL ? name : "system");
+	}
+}
+#endif
+
+/**************************************************************************************
+ * @brief: Shows a row of the statistics of a memory pool.
+ *
+ * @param mempool: The memory pool.
+ * @return: 0 on success, less than 0 on failure.
+ *************************************************************************************/
+static int meminfo_show_pool(pl_mempool_handle_t mempool)
+{
+	int ret;
+	struct pl_mempool_stats stats;
+
+	ret = pl_mempool_get_stats(mempool, &stats);
+	if (ret < 0)
+		return ret;
+
+	pl_syslog("%u\t%u\t%u\t%u\t%u\t%u\t%u", (u32_t)stats.total_bytes,
+	          (u32_t)stats.free_bytes, (u32_t)stats.largest_free,
+	          (u32_t)stats.free_frags, (u32_t)stats.peak_used,
+	          (u32_t)stats.nr_allocs, (u32_t)stats.nr_fails);
+	return 0;
+}
+
+/**************************************************************************************
+ * @brief: Shows the statistics of the default memory pool, or of each region.
+ *
+ * @param argc: The count of arguments, unused.
+ * @param argv: The arguments, unused.
+ * @return: 0 on success, less than 0 on failure.
+ *************************************************************************************/
+static int plsh_meminfo(int argc, char *argv[])
+{
+	USED(argc);
+	USED(argv);
+	int ret;
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+	size_t i;
+	struct pl_mempool_region region;
+
+	pl_syslog("total\tfree\tlargest\tfrags\tpeak\tallocs\tfails\tregion\r\n");
+	for (i = 0; pl_mempool_get_region(i, &region) == 0; i++) {
+		ret = meminfo_show_pool(region.mempool);
+		if (ret < 0)
+			return ret;
+
+		pl_syslog("\t%c%c%c\r\n", (region.flags & PL_MEMPOOL_FAST) ? 'F' : '-',
+		          (region.flags & PL_MEMPOOL_DMA) ? 'D' : '-',
+		          (region.flags & PL_MEMPOOL_LARGE) ? 'L' : '-');
+	}
+#else
+	pl_syslog("total\tfree\tlargest\tfrags\tpeak\tallocs\tfails\r\n");
+	ret = meminfo_show_pool(g_pl_default_mempool);
+	if (ret < 0)
+		return ret;
+
+	pl_syslog("\r\n");
+#endif
+
+#ifdef CONFIG_PL_BOOT_ARENA
+	pl_syslog("boot arena: %u of %u bytes used\r\n",
+	          (u32_t)pl_arena_get_used_bytes(), (u32_t)pl_arena_get_size());
+#endif
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	meminfo_show_owners();
+#endif
+	return 0;
+}
+pl_app_register(plsh_meminfo, "meminfo");
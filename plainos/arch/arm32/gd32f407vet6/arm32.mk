@@ -22,5 +22,6 @@ ASM_SRCS += $(ARCH_DIR)/arm32/gd32f407vet6/startup_gd32f407vet6.S
 C_SRCS += $(ARCH_DIR)/arm32/gd32f407vet6/system_stm32f4xx.c
 C_SRCS += $(ARCH_DIR)/arm32/gd32f407vet6/stm32f4xx_it.c
 C_SRCS += $(ARCH_DIR)/arm32/gd32f407vet6/early_setup/early_uart.c
+C_SRCS += $(ARCH_DIR)/arm32/gd32f407vet6/gd32f407vet6_region.c
 
 LINK_SCRIPT := $(ARCH_DIR)/arm32/gd32f407vet6/gd32f407vet6.ld
@@ -0,0 +1,32 @@
+#include <config.h>
+#include <errno.h>
+#include <kernel/initcall.h>
+#include <kernel/mempool.h>
+
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+/* declared in gd32f407vet6.ld, the part of CCM RAM after .ccmram */
+extern char _pl_ccm_heap_start[];
+extern char _pl_ccm_heap_end[];
+
+/*************************************************************************************
+ * Function Name: gd32f407vet6_region_init
+ * Description: add the 64KB CCM RAM as a FAST region, the task stacks are put
+ *              in it and DMA buffers are kept in the main SRAM.
+ *
+ * Parameters:
+ *   none
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+static int gd32f407vet6_region_init(void)
+{
+	size_t size = (size_t)(_pl_ccm_heap_end - _pl_ccm_heap_start);
+
+	if (pl_mempool_add_region(_pl_ccm_heap_start, size, PL_MEMPOOL_FAST) == NULL)
+		return -ENOMEM;
+
+	return OK;
+}
+pl_early_initcall(gd32f407vet6_region_init);
+#endif
@@ -23,23 +23,46 @@ SOFTWARE.
 
 #include <errno.h>
 #include <types.h>
+#include <config.h>
 #include <kernel/initcall.h>
+#include <kernel/irq.h>
 #include <kernel/syslog.h>
 #include <drivers/serial/serial.h>
 #include "../stm32f10x_it.h"
 
 static struct pl_serial_desc stm32f10x_serial_desc;
+static struct pl_irq_desc stm32f10x_serial_irq_desc;
 static u32_t recv_fifo[256];
 
-void USART1_IRQHandler(void)
+static int stm32f10x_serial_top_half(struct pl_irq_desc *irq_desc)
 {
-	char recv_char;
+	char *recv_buff;
+
+	USED(irq_desc);
+	if((USART1->SR & (1 << 5)) == 0)
+		return PL_IRQ_NONE;
 
-	if(USART1->SR & (1 << 5)) {
-		recv_char = USART1->DR;
+	/* receive straight into the fifo, the char is dropped if it is full */
+	if (pl_serial_callee_recv_reserve(&stm32f10x_serial_desc, &recv_buff) == 0) {
+		(void)USART1->DR;
+		return PL_IRQ_HANDLED;
 	}
 
-	pl_serial_callee_recv_handler(&stm32f10x_serial_desc, &recv_char, 1);
+	*recv_buff = USART1->DR;
+	return pl_serial_callee_recv_commit(&stm32f10x_serial_desc, 1);
+}
+
+static void stm32f10x_serial_thread(struct pl_irq_desc *irq_desc)
+{
+	USED(irq_desc);
+	pl_serial_callee_recv_thread(&stm32f10x_serial_desc);
+}
+
+void USART1_IRQHandler(void)
+{
+	/* RXNE is enabled by the early console, drain DR until the top half is ready */
+	if (pl_irq_callee_handle(&stm32f10x_serial_irq_desc) == PL_IRQ_NONE)
+		(void)USART1->DR;
 }
 
 static struct pl_serial_ops stm32f10x_serial_ops = {
@@ -69,6 +92,14 @@ static int stm32f10x_serial_init(void)
 		return ret;
 	}
 
+	ret = pl_irq_request_threaded(&stm32f10x_serial_irq_desc, USART1_IRQn, "usart1",
+	                              stm32f10x_serial_top_half, stm32f10x_serial_thread,
+	                              CONFIG_PL_SERIAL_IRQ_THREAD_PRIORITY, NULL);
+	if (ret < 0) {
+		pl_syslog_err("stm32f10x serial irq request failed, ret:%d\r\n", ret);
+		return ret;
+	}
+
 	pl_syslog_info("stm32f10x serial init done\r\n");
 	return 0;
 }
@@ -71,11 +71,20 @@ int pl_port_systick_init(void)
 	/* 设置PendSV为最低优先级 */
 	*((volatile uint32_t *)(0xE000ED22)) = 0xff;
 	__asm__ volatile("cpsid	i\n\t");     /*< 关中断 */
+	/* enable DWT cycle counter used by pl_port_cpu_cycles */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 	SysTick_Config(CONFIG_PL_SYSTICK_TIME_SLICE_US * 72); // 1us 1900: 12.5us,  1800:25us,   3600:50us,   72000:1ms
 	__asm__ volatile("cpsie	i\n\t");     /*< 开中断 */
 	return 0;
 }
 
+u32_t pl_port_cpu_cycles(void)
+{
+	return DWT->CYCCNT;
+}
+
 void SysTick_Handler(void);
 void SysTick_Handler(void)
 {
@@ -4,6 +4,7 @@
 #include <avr/interrupt.h>
 
 static volatile int pl_critical_ref = 0;
+static volatile u16_t pl_cycles_hi = 0;
 
 static usart USART1={
 	.ux_cofg = {
@@ -52,9 +53,40 @@ int pl_port_systick_init(void)
 
 ISR(TIMER1_OVF_vect)
 {
+	++pl_cycles_hi;
 	pl_callee_systick_expiration();
 }
 
+u32_t pl_port_cpu_cycles(void)
+{
+	u16_t hi;
+	u16_t lo;
+
+	pl_port_enter_critical();
+	hi = pl_cycles_hi;
+	lo = TCNT1;
+	/* overflow is pending but not handled yet */
+	if ((TIFR1 & (u8_t)(1<<0)) && lo < 0x8000)
+		++hi;
+	pl_port_exit_critical();
+
+	return ((u32_t)hi << 16) | lo;
+}
+
+/* avr has no exclusive access, the interrupts are disabled a few cycles */
+uint_t pl_port_atomic_cmpxchg(volatile uint_t *ptr, uint_t old, uint_t val)
+{
+	uint_t curr;
+
+	pl_port_enter_critical();
+	curr = *ptr;
+	if (curr == old)
+		*ptr = val;
+	pl_port_exit_critical();
+
+	return curr;
+}
+
 /*************************************************************************************
  * Function Name: void pl_port_enter_critical(void)
  * Description: enter critical area.
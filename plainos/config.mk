@@ -21,6 +21,13 @@ PL_SHELL_CMD_EXEC_TASK_STACK_SIZE = (1024)
 PL_SYSTICK_TIME_SLICE_US = (15)
 PL_DEFAULT_MEMPOOL_SIZE = (14*1024)
 PL_DEFAULT_MEMPOOL_GRAIN_ORDER = (5)
+PL_MEMPOOL_INDEX = y
+PL_MEMPOOL_TLSF = n
+PL_MEMPOOL_OWNER = n
+PL_BOOT_ARENA = y
+PL_BOOT_ARENA_SIZE = (3*1024)
+PL_BOOT_ARENA_SEAL = y
+PL_MEMPOOL_REGIONS = y
 PL_MAX_TASKS_NUM = (900u)
 PL_SYS_RSVD_HIGHEST_PRIOTITY = (2u)
 PL_TASK_PRIORITIES_MAX = (99u)
@@ -28,11 +35,17 @@ PL_INIT_TASK_STACK_SIZE = (512)
 PL_IDLE_TASK_STACK_SIZE = (512)
 PL_CPU_RATE_INTERVAL_TICKS = (102400)
 PL_SOFTTIMER_DAEMON_TASK_STACK_SIZE = (512)
+PL_SOFTTIMER_WHEEL_SLOT_BITS = (5)
+PL_SOFTTIMER_WHEEL_LEVELS = (4)
 PL_HI_WORKQUEUE_TASK_STACK_SIZE = (512)
 PL_HI_WORKQUEUE_FIFO_CAPACITY = (128)
 PL_LO_WORKQUEUE_TASK_STACK_SIZE = (1024)
 PL_LO_WORKQUEUE_TASK_PRIORITY = (CONFIG_PL_TASK_PRIORITIES_MAX)
 PL_LO_WORKQUEUE_FIFO_CAPACITY = (128)
+PL_HI_WORKQUEUE_WORKERS_MAX = (2)
+PL_LO_WORKQUEUE_WORKERS_MAX = (2)
+PL_IRQ_THREAD_STACK_SIZE = (512)
+PL_SERIAL_IRQ_THREAD_PRIORITY = (1)
 PL_SYSLOG_ANSI_COLOR = n
 PL_OS_TEST := n
 PL_OS_TEST_MEMPOOL := y
@@ -40,3 +53,7 @@ PL_OS_TEST_TASK := y
 PL_OS_TEST_SOFTTIMER := y
 PL_OS_TEST_KFIFO := y
 PL_OS_TEST_WORKQUEUE := y
+PL_OS_TEST_TASKLET := y
+PL_OS_TEST_BITOPS := n
+PL_OS_TEST_KMEM_CACHE := n
+PL_OS_TEST_PIPE := y
@@ -23,7 +23,7 @@ SOFTWARE.
 
 #include <types.h>
 #include <errno.h>
-#include <string.h>
+#include <lib/string.h>
 #include <kernel/list.h>
 #include <kernel/initcall.h>
 #include <kernel/syslog.h>
@@ -99,7 +99,7 @@ struct gpio_desc *pl_gpio_desc_find_by_name(const char *name)
 		return NULL;
 
 	list_for_each_entry(pos, &pl_gpio_desc_list, struct gpio_desc, node) {
-		if (strcmp(pos->name, name) == 0) {
+		if (pl_strcmp(pos->name, name) == 0) {
 			return pos;
 		}
 	}
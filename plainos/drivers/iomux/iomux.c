@@ -23,7 +23,7 @@ SOFTWARE.
 
 #include <config.h>
 #include <errno.h>
-#include <string.h>
+#include <lib/string.h>
 #include <kernel/list.h>
 #include <kernel/initcall.h>
 #include <kernel/syslog.h>
@@ -102,7 +102,7 @@ struct iomux_desc *pl_iomux_desc_find_by_name(const char *name)
 		return NULL;
 
 	list_for_each_entry(pos, &pl_iomux_desc_list, struct iomux_desc, node) {
-		if (strcmp(pos->name, name) == 0) {
+		if (pl_strcmp(pos->name, name) == 0) {
 			return pos;
 		}
 	}
@@ -27,6 +27,7 @@ SOFTWARE.
 #include <kernel/kernel.h>
 #include <kernel/list.h>
 #include <kernel/mempool.h>
+#include <kernel/ring.h>
 #include <kernel/initcall.h>
 #include <kernel/syslog.h>
 #include <drivers/serial/serial.h>
@@ -151,27 +152,145 @@ int pl_serial_callee_recv_handler(struct pl_serial_desc *desc,
                                 char *chars, uint_t chars_len)
 {
 	int ret;
+
+	ret = pl_serial_callee_recv_top_half(desc, chars, chars_len);
+	if (ret != PL_IRQ_WAKE_THREAD)
+		return ret < 0 ? ret : OK;
+
+	/* call callbcak */
+	ret = pl_work_add(g_pl_sys_hiwq_handle, &desc->recv_info.cb_work);
+	return ret;
+}
+
+/*************************************************************************************
+ * Function Name: serial_recv_process
+ * Description: call the process of receiving characters, they are in the fifo.
+ *
+ * Param:
+ *   @desc: serial description.
+ *   @chars: characters received.
+ *   @chars_len: length of characters received.
+ *
+ * Return:
+ *   PL_IRQ_WAKE_THREAD if the callback need to be called in the interrupt thread,
+ *   PL_IRQ_HANDLED if not.
+ ************************************************************************************/
+static int serial_recv_process(struct pl_serial_desc *desc,
+                               char *chars, uint_t chars_len)
+{
 	pl_serial_recv_process_t process;
 
+	/* setup process for receiving characters */
+	process = desc->recv_info.process;
+	if (process == NULL)
+		return PL_IRQ_HANDLED;
+
+	if (process(&desc->recv_info.fifo, chars, chars_len) == 0)
+		return PL_IRQ_HANDLED;
+
+	/* check call callbcak */
+	if (desc->recv_info.callback == NULL)
+		return PL_IRQ_HANDLED;
+
+	return PL_IRQ_WAKE_THREAD;
+}
+
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_top_half
+ * Description: the top half of threaded serial interrupt when received characters,
+ *              the characters are copied into the fifo.
+ *
+ * Param:
+ *   @desc: serial description.
+ *   @chars: characters received.
+ *   @chars_len: length of characters received.
+ *
+ * Return:
+ *   PL_IRQ_WAKE_THREAD if the callback need to be called in the interrupt thread,
+ *   PL_IRQ_HANDLED if not, less than 0 on failure.
+ ************************************************************************************/
+int pl_serial_callee_recv_top_half(struct pl_serial_desc *desc,
+                                   char *chars, uint_t chars_len)
+{
 	if (desc == NULL)
 		return -EFAULT;
 
-	/* setup process for receiving characters */
-	process = desc->recv_info.process;
-	if (process != NULL) {
-		if (process(&desc->recv_info.fifo, chars, chars_len) == 0)
-			return OK;
+	chars_len = pl_kfifo_put(&desc->recv_info.fifo, chars, chars_len);
+	if (chars_len == 0)
+		return PL_IRQ_HANDLED;
 
-		/* check call callbcak */
-		if (desc->recv_info.callback == NULL)
-			return OK;
+	return serial_recv_process(desc, chars, chars_len);
+}
 
-		/* call callbcak */
-		ret = pl_work_add(g_pl_sys_hiwq_handle, &desc->recv_info.cb_work);
-		return ret;
-	}
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_reserve
+ * Description: get the free span of receiving fifo.
+ *
+ * Param:
+ *   @desc: serial description.
+ *   @buff: start of span.
+ *
+ * Return:
+ *   The length of span, 0 if the fifo is full.
+ ************************************************************************************/
+uint_t pl_serial_callee_recv_reserve(struct pl_serial_desc *desc, char **buff)
+{
+	if (desc == NULL)
+		return 0;
 
-	return OK;
+	return pl_kfifo_reserve(&desc->recv_info.fifo, buff);
+}
+
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_commit
+ * Description: the top half of threaded serial interrupt when the characters are
+ *              received into the reserved span, nothing is copied.
+ *
+ * Param:
+ *   @desc: serial description.
+ *   @chars_len: length of characters received.
+ *
+ * Return:
+ *   PL_IRQ_WAKE_THREAD if the callback need to be called in the interrupt thread,
+ *   PL_IRQ_HANDLED if not, less than 0 on failure.
+ ************************************************************************************/
+int pl_serial_callee_recv_commit(struct pl_serial_desc *desc, uint_t chars_len)
+{
+	char *chars;
+	struct pl_kfifo *fifo;
+
+	if (desc == NULL)
+		return -EFAULT;
+
+	fifo = &desc->recv_info.fifo;
+	chars = fifo->buff + pl_ring_idx_off(fifo->in, fifo->size);
+	chars_len = pl_kfifo_commit(fifo, chars_len);
+	if (chars_len == 0)
+		return PL_IRQ_HANDLED;
+
+	return serial_recv_process(desc, chars, chars_len);
+}
+
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_thread
+ * Description: the threaded handler of serial interrupt, it calls the callback.
+ *
+ * Param:
+ *   @desc: serial description.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_serial_callee_recv_thread(struct pl_serial_desc *desc)
+{
+	pl_serial_recv_callback_t callback;
+
+	if (desc == NULL)
+		return;
+
+	callback = desc->recv_info.callback;
+	if (callback != NULL)
+		callback(&desc->recv_info.fifo);
 }
 
 /*************************************************************************************
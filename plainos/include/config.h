@@ -14,6 +14,11 @@
 #define CONFIG_PL_SYSTICK_TIME_SLICE_US (15)
 #define CONFIG_PL_DEFAULT_MEMPOOL_SIZE (14*1024)
 #define CONFIG_PL_DEFAULT_MEMPOOL_GRAIN_ORDER (5)
+#define CONFIG_PL_MEMPOOL_INDEX
+#define CONFIG_PL_BOOT_ARENA
+#define CONFIG_PL_BOOT_ARENA_SIZE (3*1024)
+#define CONFIG_PL_BOOT_ARENA_SEAL
+#define CONFIG_PL_MEMPOOL_REGIONS
 #define CONFIG_PL_MAX_TASKS_NUM (900u)
 #define CONFIG_PL_SYS_RSVD_HIGHEST_PRIOTITY (2u)
 #define CONFIG_PL_TASK_PRIORITIES_MAX (99u)
@@ -21,10 +26,16 @@
 #define CONFIG_PL_IDLE_TASK_STACK_SIZE (512)
 #define CONFIG_PL_CPU_RATE_INTERVAL_TICKS (102400)
 #define CONFIG_PL_SOFTTIMER_DAEMON_TASK_STACK_SIZE (512)
+#define CONFIG_PL_SOFTTIMER_WHEEL_SLOT_BITS (5)
+#define CONFIG_PL_SOFTTIMER_WHEEL_LEVELS (4)
 #define CONFIG_PL_HI_WORKQUEUE_TASK_STACK_SIZE (512)
 #define CONFIG_PL_HI_WORKQUEUE_FIFO_CAPACITY (128)
 #define CONFIG_PL_LO_WORKQUEUE_TASK_STACK_SIZE (1024)
 #define CONFIG_PL_LO_WORKQUEUE_TASK_PRIORITY (CONFIG_PL_TASK_PRIORITIES_MAX)
 #define CONFIG_PL_LO_WORKQUEUE_FIFO_CAPACITY (128)
+#define CONFIG_PL_HI_WORKQUEUE_WORKERS_MAX (2)
+#define CONFIG_PL_LO_WORKQUEUE_WORKERS_MAX (2)
+#define CONFIG_PL_IRQ_THREAD_STACK_SIZE (512)
+#define CONFIG_PL_SERIAL_IRQ_THREAD_PRIORITY (1)
 
 #endif /* __PLAINOS_CONFIG_H__ */
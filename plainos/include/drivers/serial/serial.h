@@ -28,6 +28,7 @@ SOFTWARE.
 #include <kernel/list.h>
 #include <kernel/kfifo.h>
 #include <kernel/workqueue.h>
+#include <kernel/irq.h>
 #include <kernel/semaphore.h>
 #include <kernel/kfifo.h>
 
@@ -38,8 +39,8 @@ struct pl_serial_desc;
  * Description:
  *   @recv_process: callback function will be called when call_condition return
  *                    equal to or greater 0.
- *   @recv_fifo: fifo of receiving characters.
- *   @chars: recevied characters at the moment.
+ *   @recv_fifo: fifo of receiving characters, the characters are already in it.
+ *   @chars: recevied characters at the moment, they may be in the fifo buffer.
  *   @chars_len: the length of recevied characters at the moment.
  *   @callback: callback function will be called when call_condition return equal to
  *              or greater 0.
@@ -162,6 +163,64 @@ int pl_serial_desc_register(struct pl_serial_desc *desc);
 int pl_serial_callee_recv_handler(struct pl_serial_desc *desc,
                                 char *chars, uint_t chars_len);
 
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_top_half
+ * Description: the top half of threaded serial interrupt when received characters.
+ *
+ * Param:
+ *   @desc: serial description.
+ *   @chars: characters received.
+ *   @chars_len: length of characters received.
+ *
+ * Return:
+ *   PL_IRQ_WAKE_THREAD if the callback need to be called in the interrupt thread,
+ *   PL_IRQ_HANDLED if not, less than 0 on failure.
+ ************************************************************************************/
+int pl_serial_callee_recv_top_half(struct pl_serial_desc *desc,
+                                   char *chars, uint_t chars_len);
+
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_reserve
+ * Description: get the free span of receiving fifo, the interrupt or DMA of serial
+ *              writes the characters straight into it, then calls
+ *              pl_serial_callee_recv_commit().
+ *
+ * Param:
+ *   @desc: serial description.
+ *   @buff: start of span.
+ *
+ * Return:
+ *   The length of span, 0 if the fifo is full.
+ ************************************************************************************/
+uint_t pl_serial_callee_recv_reserve(struct pl_serial_desc *desc, char **buff);
+
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_commit
+ * Description: the top half of threaded serial interrupt when the characters are
+ *              received into the reserved span.
+ *
+ * Param:
+ *   @desc: serial description.
+ *   @chars_len: length of characters received.
+ *
+ * Return:
+ *   PL_IRQ_WAKE_THREAD if the callback need to be called in the interrupt thread,
+ *   PL_IRQ_HANDLED if not, less than 0 on failure.
+ ************************************************************************************/
+int pl_serial_callee_recv_commit(struct pl_serial_desc *desc, uint_t chars_len);
+
+/*************************************************************************************
+ * Function Name: pl_serial_callee_recv_thread
+ * Description: the threaded handler of serial interrupt, it calls the callback.
+ *
+ * Param:
+ *   @desc: serial description.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_serial_callee_recv_thread(struct pl_serial_desc *desc);
+
 
 /*================================== Client Driver =================================*/
 /*************************************************************************************
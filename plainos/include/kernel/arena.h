@@ -0,0 +1,96 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_ARENA_H__
+#define __KERNEL_ARENA_H__
+
+#include <types.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*************************************************************************************
+ * Function Name: pl_arena_alloc
+ *
+ * Description:
+ *   Allocate memory which is never freed from the boot arena, such as the objects
+ *   created by initcalls. The memory is carved linearly without header, it can't
+ *   be allocated after the arena is sealed.
+ *
+ * Parameters:
+ *  @size: memory size to require.
+ *
+ * Return:
+ *  address of memory, NULL if the arena is full or sealed.
+ ************************************************************************************/
+void *pl_arena_alloc(size_t size);
+
+/*************************************************************************************
+ * Function Name: pl_arena_contains
+ *
+ * Description:
+ *   Check whether memory is in the boot arena.
+ *
+ * Parameters:
+ *  @p: memory address.
+ *
+ * Return:
+ *  true if p is in the arena.
+ ************************************************************************************/
+bool pl_arena_contains(const void *p);
+
+/*************************************************************************************
+ * Function Name: pl_arena_get_used_bytes
+ *
+ * Description:
+ *   Get the bytes allocated from the boot arena.
+ *
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  used bytes of arena.
+ ************************************************************************************/
+size_t pl_arena_get_used_bytes(void);
+
+/*************************************************************************************
+ * Function Name: pl_arena_get_size
+ *
+ * Description:
+ *   Get the size of the boot arena.
+ *
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  size of arena.
+ ************************************************************************************/
+size_t pl_arena_get_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_ARENA_H__ */
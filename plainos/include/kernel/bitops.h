@@ -0,0 +1,224 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_BITOPS_H__
+#define __KERNEL_BITOPS_H__
+
+#include <types.h>
+#include <limits.h>
+
+/*************************************************************************************
+ * Description: arch selection.
+ *   The CPUs with a count leading zeros instruction (ARMv7-M CLZ, x86 BSR, AArch64
+ *   CLZ) use compiler builtins, the others (AVR, ARMv6-M) use the generic code,
+ *   the builtins would be calls into libgcc there.
+ ************************************************************************************/
+#if defined(__GNUC__) && (UINTPTR_MAX == ULONG_MAX) && \
+    (defined(__ARM_FEATURE_CLZ) || defined(__x86_64__) || \
+     defined(__i386__) || defined(__aarch64__))
+#define PL_BITOPS_BUILTIN_CLZ
+#endif
+
+#if defined(__GNUC__) && (UINTPTR_MAX == ULONG_MAX) && \
+    (defined(__POPCNT__) || defined(__aarch64__))
+#define PL_BITOPS_BUILTIN_POPCOUNT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*************************************************************************************
+ * Function Name: pl_ctz
+ *
+ * Description:
+ *   Count trailing zeros of x.
+ *
+ * Parameters:
+ *  @x: value.
+ *
+ * Return:
+ *  index of the lowest set bit, UINTPTR_T_BITS if x is 0.
+ ************************************************************************************/
+static inline uchar_t pl_ctz(uintptr_t x)
+{
+#ifdef PL_BITOPS_BUILTIN_CLZ
+	return (x == 0) ? UINTPTR_T_BITS : (uchar_t)__builtin_ctzl(x);
+#else
+	uchar_t n = 0;
+	uchar_t shift = UINTPTR_T_BITS >> 1;
+
+	if (x == 0)
+		return UINTPTR_T_BITS;
+
+	for (; shift != 0; shift >>= 1) {
+		if ((x & (((uintptr_t)1 << shift) - 1)) == 0) {
+			n += shift;
+			x >>= shift;
+		}
+	}
+
+	return n;
+#endif
+}
+
+/*************************************************************************************
+ * Function Name: pl_clz
+ *
+ * Description:
+ *   Count leading zeros of x.
+ *
+ * Parameters:
+ *  @x: value.
+ *
+ * Return:
+ *  number of zeros above the highest set bit, UINTPTR_T_BITS if x is 0.
+ ************************************************************************************/
+static inline uchar_t pl_clz(uintptr_t x)
+{
+#ifdef PL_BITOPS_BUILTIN_CLZ
+	return (x == 0) ? UINTPTR_T_BITS : (uchar_t)__builtin_clzl(x);
+#else
+	uchar_t n = 0;
+	uchar_t shift = UINTPTR_T_BITS >> 1;
+
+	if (x == 0)
+		return UINTPTR_T_BITS;
+
+	for (; shift != 0; shift >>= 1) {
+		if ((x >> (UINTPTR_T_BITS - shift)) == 0) {
+			n += shift;
+			x <<= shift;
+		}
+	}
+
+	return n;
+#endif
+}
+
+/*************************************************************************************
+ * Function Name: pl_popcount
+ *
+ * Description:
+ *   Count set bits of x.
+ *
+ * Parameters:
+ *  @x: value.
+ *
+ * Return:
+ *  number of set bits.
+ ************************************************************************************/
+static inline uchar_t pl_popcount(uintptr_t x)
+{
+#ifdef PL_BITOPS_BUILTIN_POPCOUNT
+	return (uchar_t)__builtin_popcountl(x);
+#else
+	x = x - ((x >> 1) & (UINTPTR_T_MAX / 3));
+	x = (x & (UINTPTR_T_MAX / 5)) + ((x >> 2) & (UINTPTR_T_MAX / 5));
+	x = (x + (x >> 4)) & (UINTPTR_T_MAX / 17);
+	return (uchar_t)((x * (UINTPTR_T_MAX / 255)) >> (UINTPTR_T_BITS - 8));
+#endif
+}
+
+/*************************************************************************************
+ * Function Name: pl_bits_first_run
+ *
+ * Description:
+ *   Find the first run of at least n set bits. The run is found by shift-and-AND,
+ *   after the loop bit i of x is set only if bits [i, i + n) were all set.
+ *
+ * Parameters:
+ *  @x: value.
+ *  @n: length of run.
+ *
+ * Return:
+ *  index of the first bit of run, UINTPTR_T_BITS if there is no such run.
+ ************************************************************************************/
+static inline uchar_t pl_bits_first_run(uintptr_t x, uchar_t n)
+{
+	uchar_t len = 1;
+	uchar_t shift;
+
+	if (n == 0)
+		return 0;
+
+	while (len < n && x != 0) {
+		shift = (len < n - len) ? len : n - len;
+		x &= x >> shift;
+		len += shift;
+	}
+
+	return pl_ctz(x);
+}
+
+/*************************************************************************************
+ * Function Name: pl_bits_max_run
+ *
+ * Description:
+ *   Get the length of the longest run of set bits. runs[k] marks the bits which
+ *   start a run of at least (1 << k) bits, they are built by shift-and-AND, then
+ *   the length is found by a binary search over them.
+ *
+ * Parameters:
+ *  @x: value.
+ *
+ * Return:
+ *  length of the longest run.
+ ************************************************************************************/
+static inline uchar_t pl_bits_max_run(uintptr_t x)
+{
+	uchar_t k;
+	uchar_t len;
+	uintptr_t y;
+	uintptr_t runs[8];
+
+	if (x == 0 || x == UINTPTR_T_MAX)
+		return (x == 0) ? 0 : UINTPTR_T_BITS;
+
+	runs[0] = x;
+	for (k = 1; ((size_t)1 << k) < UINTPTR_T_BITS; k++) {
+		y = runs[k - 1] & (runs[k - 1] >> (1 << (k - 1)));
+		if (y == 0)
+			break;
+
+		runs[k] = y;
+	}
+
+	len = (uchar_t)(1 << (k - 1));
+	x = runs[k - 1];
+	while (--k > 0) {
+		y = x & (runs[k - 1] >> len);
+		if (y != 0) {
+			x = y;
+			len += (uchar_t)(1 << (k - 1));
+		}
+	}
+
+	return len;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_BITOPS_H__ */
@@ -0,0 +1,203 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef __KERNEL_IRQ_H__
+#define __KERNEL_IRQ_H__
+
+#include <types.h>
+#include <kernel/list.h>
+#include <kernel/kernel.h>
+#include <kernel/task.h>
+
+struct pl_irq_desc;
+
+/*************************************************************************************
+ * Type Name: pl_irq_return
+ * Description: return value of the top half handler.
+ *
+ * Members:
+ *   PL_IRQ_NONE: the interrupt was not from this device.
+ *   PL_IRQ_HANDLED: the interrupt was handled completely by the top half.
+ *   PL_IRQ_WAKE_THREAD: the top half asks to wake the threaded handler.
+ ************************************************************************************/
+enum pl_irq_return {
+	PL_IRQ_NONE = 0,
+	PL_IRQ_HANDLED,
+	PL_IRQ_WAKE_THREAD,
+};
+
+typedef int (*pl_irq_handler_t)(struct pl_irq_desc *desc);
+typedef void (*pl_irq_thread_fun_t)(struct pl_irq_desc *desc);
+
+/*************************************************************************************
+ * Structure Name: pl_irq_stats
+ * Description: statistics of an interrupt.
+ *
+ * Members:
+ *   @count: count of the top half was called.
+ *   @thread_count: count of the threaded handler was called.
+ *   @top_max_cycles: max cycles spent in the top half.
+ *   @thread_max_latency: max cycles from waking to running the threaded handler.
+ ************************************************************************************/
+struct pl_irq_stats {
+	u32_t count;
+	u32_t thread_count;
+	u32_t top_max_cycles;
+	u32_t thread_max_latency;
+};
+
+/*************************************************************************************
+ * Structure Name: pl_irq_desc
+ * Description: description of a threaded interrupt.
+ *
+ * Members:
+ *   @node: list node of all requested interrupts.
+ *   @name: name of the interrupt, it is also the name of its thread.
+ *   @irq: interrupt number.
+ *   @prio: priority of the interrupt thread.
+ *   @handler: top half, it runs in interrupt context and must be short.
+ *   @thread_fun: threaded handler, it runs in the interrupt thread.
+ *   @priv_data: private data.
+ *   @thread: the interrupt thread.
+ *   @wake_cycles: cycles at the moment of waking the thread.
+ *   @stats: statistics of the interrupt.
+ ************************************************************************************/
+struct pl_irq_desc {
+	struct list_node node;
+	const char *name;
+	u16_t irq;
+	u16_t prio;
+	pl_irq_handler_t handler;
+	pl_irq_thread_fun_t thread_fun;
+	void *priv_data;
+	pl_tid_t thread;
+	volatile u32_t wake_cycles;
+	struct pl_irq_stats stats;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*************************************************************************************
+ * Function Name: pl_irq_request_threaded
+ *
+ * Description:
+ *   request a threaded interrupt, a dedicated task will be created for the
+ *   threaded handler if thread_fun is not NULL.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *  @irq: interrupt number.
+ *  @name: name of the interrupt.
+ *  @handler: top half, it must not be NULL, the thread is woken only when it
+ *            returns PL_IRQ_WAKE_THREAD.
+ *  @thread_fun: threaded handler (optional).
+ *  @prio: priority of the interrupt thread.
+ *  @priv_data: private data.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_irq_request_threaded(struct pl_irq_desc *desc, u16_t irq, const char *name,
+                            pl_irq_handler_t handler, pl_irq_thread_fun_t thread_fun,
+                            u16_t prio, void *priv_data);
+
+/*************************************************************************************
+ * Function Name: pl_irq_free
+ *
+ * Description:
+ *   free a threaded interrupt, the interrupt must be disabled before.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_irq_free(struct pl_irq_desc *desc);
+
+/*************************************************************************************
+ * Function Name: pl_irq_callee_handle
+ *
+ * Description:
+ *   the entry of the threaded interrupt, the interrupt vector must call it.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *
+ * Return:
+ *  return value of the top half (enum pl_irq_return), PL_IRQ_NONE if the desc
+ *  has no top half yet.
+ ************************************************************************************/
+int pl_irq_callee_handle(struct pl_irq_desc *desc);
+
+/*************************************************************************************
+ * Function Name: pl_irq_get_private_data
+ *
+ * Description:
+ *   get the private data of interrupt.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *
+ * Return:
+ *   private data of the interrupt.
+ ************************************************************************************/
+void *pl_irq_get_private_data(struct pl_irq_desc *desc);
+
+/*************************************************************************************
+ * Function Name: pl_irq_get_stats
+ *
+ * Description:
+ *   get the statistics of interrupt.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *  @stats: statistics wanted to get.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_irq_get_stats(struct pl_irq_desc *desc, struct pl_irq_stats *stats);
+
+/*************************************************************************************
+ * Function Name: pl_irq_next_desc
+ *
+ * Description:
+ *   iterate the requested interrupts.
+ *
+ * Parameters:
+ *  @desc: current interrupt description, NULL to get the first one.
+ *
+ * Return:
+ *   next interrupt description, NULL if there is no more.
+ ************************************************************************************/
+struct pl_irq_desc *pl_irq_next_desc(struct pl_irq_desc *desc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_IRQ_H__ */
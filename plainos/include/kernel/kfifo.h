@@ -27,6 +27,10 @@ SOFTWARE.
 #include <types.h>
 #include <errno.h>
 
+/* the record mode puts a 2 bytes length before each record */
+#define PL_KFIFO_REC_HDR_SIZE            (2)
+#define PL_KFIFO_REC_MAX_LEN             (0xffff)
+
 struct pl_kfifo {
 	volatile uint_t in;
 	volatile uint_t out;
@@ -34,6 +38,19 @@ struct pl_kfifo {
 	char *buff;
 };
 
+/*************************************************************************************
+ * Structure Name: pl_kfifo_iovec
+ * Description: a contiguous span of the kfifo buffer.
+ *
+ * Members:
+ *   @base: start of span.
+ *   @len: length of span, 0 if the span is empty.
+ ************************************************************************************/
+struct pl_kfifo_iovec {
+	char *base;
+	uint_t len;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -116,6 +133,144 @@ uint_t pl_kfifo_put(struct pl_kfifo *fifo, char *data, uint_t data_len);
  ************************************************************************************/
 uint_t pl_kfifo_get(struct pl_kfifo *fifo, char *data, uint_t data_len);
 
+/*************************************************************************************
+ * Function Name: pl_kfifo_reserve
+ * Description: get the largest contiguous free span at the in index, the producer
+ *              (such as DMA) writes into it and then calls pl_kfifo_commit().
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @buff: start of span.
+ *
+ * Return:
+ *   The length of span, 0 if the kfifo is full.
+ ************************************************************************************/
+uint_t pl_kfifo_reserve(struct pl_kfifo *fifo, char **buff);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_reserve_iov
+ * Description: get all the free space of kfifo as two spans, the second one is at
+ *              the beginning of the buffer if the space wraps.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @iov: two spans.
+ *
+ * Return:
+ *   The length of free space.
+ ************************************************************************************/
+uint_t pl_kfifo_reserve_iov(struct pl_kfifo *fifo, struct pl_kfifo_iovec iov[2]);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_commit
+ * Description: publish the data written into the reserved spans.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @len: length of data written, no more than the free space.
+ *
+ * Return:
+ *   The length of data committed.
+ ************************************************************************************/
+uint_t pl_kfifo_commit(struct pl_kfifo *fifo, uint_t len);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_peek
+ * Description: get the largest contiguous span of data at the out index, the
+ *              consumer reads it in place and then calls pl_kfifo_consume().
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @buff: start of span.
+ *
+ * Return:
+ *   The length of span, 0 if the kfifo is empty.
+ ************************************************************************************/
+uint_t pl_kfifo_peek(struct pl_kfifo *fifo, char **buff);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_peek_iov
+ * Description: get all the data of kfifo as two spans, the second one is at the
+ *              beginning of the buffer if the data wraps.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @iov: two spans.
+ *
+ * Return:
+ *   The length of data.
+ ************************************************************************************/
+uint_t pl_kfifo_peek_iov(struct pl_kfifo *fifo, struct pl_kfifo_iovec iov[2]);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_consume
+ * Description: release the data read from the peeked spans.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @len: length of data read, no more than the data in kfifo.
+ *
+ * Return:
+ *   The length of data consumed.
+ ************************************************************************************/
+uint_t pl_kfifo_consume(struct pl_kfifo *fifo, uint_t len);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_put
+ * Description: put a record to the kfifo, the record is put as a whole or not at
+ *              all. The record functions must not be mixed with the byte functions
+ *              on one kfifo, one producer (such as an ISR) and one consumer need no
+ *              lock.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @data: data of record.
+ *   @data_len: length of record, from 1 to PL_KFIFO_REC_MAX_LEN.
+ *
+ * Return:
+ *   data_len on success, 0 if the record does not fit.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_put(struct pl_kfifo *fifo, const char *data, uint_t data_len);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_get
+ * Description: get exactly one record from the kfifo. If the buffer is too small,
+ *              the record stays in the kfifo, see pl_kfifo_rec_peek_len().
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @data: buffer of record.
+ *   @data_len: length of buffer.
+ *
+ * Return:
+ *   The length of record, 0 if there is no record or the buffer is too small.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_get(struct pl_kfifo *fifo, char *data, uint_t data_len);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_peek_len
+ * Description: get the length of the first record.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *
+ * Return:
+ *   The length of record, 0 if the kfifo has no record.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_peek_len(struct pl_kfifo *fifo);
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_skip
+ * Description: drop the first record.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *
+ * Return:
+ *   The length of record dropped, 0 if the kfifo has no record.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_skip(struct pl_kfifo *fifo);
+
 #ifdef __cplusplus
 }
 #endif
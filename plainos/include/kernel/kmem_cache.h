@@ -0,0 +1,129 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_KMEM_CACHE_H__
+#define __KERNEL_KMEM_CACHE_H__
+
+#include <types.h>
+#include <kernel/list.h>
+#include <kernel/mempool.h>
+
+/*************************************************************************************
+ * Structure Name: pl_kmem_cache
+ * Description: cache of fixed-size objects.
+ *
+ * Members:
+ *   @name: name of cache.
+ *   @mempool: memory pool which the slabs are allocated from.
+ *   @slabs: list of slabs.
+ *   @free_list: free objects, the link is stored in the object itself.
+ *   @obj_size: aligned size of object.
+ *   @slab_size: size of slab (header and objects).
+ *   @objs_per_slab: the number of objects in a slab.
+ *   @nr_slabs: the number of slabs.
+ *   @nr_active: the number of objects in use.
+ ************************************************************************************/
+struct pl_kmem_cache {
+	const char *name;
+	pl_mempool_handle_t mempool;
+	struct list_node slabs;
+	void *free_list;
+	size_t obj_size;
+	size_t slab_size;
+	u16_t objs_per_slab;
+	u16_t nr_slabs;
+	size_t nr_active;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_create
+ *
+ * Description:
+ *   Create a cache of fixed-size objects, the objects have no header, slabs are
+ *   carved from mempool when the cache is empty.
+ *
+ * Parameters:
+ *  @name: name of cache.
+ *  @obj_size: size of object.
+ *  @objs_per_slab: the number of objects in a slab.
+ *  @mempool: memory pool which the cache and slabs are allocated from.
+ *
+ * Return:
+ *  handle of cache, NULL on failure.
+ ************************************************************************************/
+struct pl_kmem_cache *pl_kmem_cache_create(const char *name, size_t obj_size,
+                                           u16_t objs_per_slab,
+                                           pl_mempool_handle_t mempool);
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_alloc
+ *
+ * Description:
+ *   Allocate an object from cache.
+ *
+ * Parameters:
+ *  @cache: handle of cache.
+ *
+ * Return:
+ *  address of object, NULL on failure.
+ ************************************************************************************/
+void *pl_kmem_cache_alloc(struct pl_kmem_cache *cache);
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_free
+ *
+ * Description:
+ *   Free an object to cache, the object must be allocated from the cache.
+ *
+ * Parameters:
+ *  @cache: handle of cache.
+ *  @obj: address of object.
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+void pl_kmem_cache_free(struct pl_kmem_cache *cache, void *obj);
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_destroy
+ *
+ * Description:
+ *   Destroy cache, all slabs are freed to memory pool.
+ *
+ * Parameters:
+ *  @cache: handle of cache.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, -EBUSY if some objects are in use.
+ ************************************************************************************/
+int pl_kmem_cache_destroy(struct pl_kmem_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_KMEM_CACHE_H__ */
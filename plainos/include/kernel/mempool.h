@@ -24,12 +24,87 @@ SOFTWARE.
 #ifndef __KERNEL_MEMPOOL_H__
 #define __KERNEL_MEMPOOL_H__
 
+#include <config.h>
 #include <types.h>
 #include <stddef.h>
 
 typedef void *pl_mempool_handle_t;
 extern pl_mempool_handle_t g_pl_default_mempool;
 
+/*************************************************************************************
+ * Description: lock of memory pool.
+ *   PL_MEMPOOL_LOCK_SEM: semaphore, the pool can't be used in interrupt.
+ *   PL_MEMPOOL_LOCK_CRITICAL: critical section, the pool is ISR-safe.
+ *   PL_MEMPOOL_LOCK_NONE: no lock, the pool is only used by one owner.
+ ************************************************************************************/
+enum pl_mempool_lock {
+	PL_MEMPOOL_LOCK_SEM = 0,
+	PL_MEMPOOL_LOCK_CRITICAL,
+	PL_MEMPOOL_LOCK_NONE,
+};
+
+/*************************************************************************************
+ * Structure Name: pl_mempool_stats
+ * Description: statistics of memory pool.
+ *
+ * Members:
+ *   @total_bytes: bytes which can be allocated when the pool is empty.
+ *   @free_bytes: free bytes.
+ *   @largest_free: the largest contiguous free bytes, headers included.
+ *   @free_frags: the number of free fragments.
+ *   @peak_used: the most bytes in use since init.
+ *   @nr_allocs: the number of allocations in use.
+ *   @nr_fails: the number of failed allocations.
+ ************************************************************************************/
+struct pl_mempool_stats {
+	size_t total_bytes;
+	size_t free_bytes;
+	size_t largest_free;
+	size_t free_frags;
+	size_t peak_used;
+	size_t nr_allocs;
+	size_t nr_fails;
+};
+
+/*************************************************************************************
+ * Description: callback of pl_mempool_walk(), it is called with the pool locked,
+ *              so it must not use the pool.
+ *   @p: memory address.
+ *   @size: usable size of memory.
+ *   @owner: task which allocated the memory, NULL for system.
+ *   @arg: argument of pl_mempool_walk().
+ ************************************************************************************/
+typedef void (*pl_mempool_walk_t)(void *p, size_t size, void *owner, void *arg);
+
+/*************************************************************************************
+ * Description: flags of memory region.
+ *   PL_MEMPOOL_FAST: fast RAM for the CPU, such as CCM, a hint.
+ *   PL_MEMPOOL_DMA: RAM which DMA can access, a requirement.
+ *   PL_MEMPOOL_LARGE: big RAM for large buffers, such as external RAM, a hint.
+ ************************************************************************************/
+enum pl_mempool_flags {
+	PL_MEMPOOL_FAST  = 0x01,
+	PL_MEMPOOL_DMA   = 0x02,
+	PL_MEMPOOL_LARGE = 0x04,
+};
+
+/*************************************************************************************
+ * Structure Name: pl_mempool_region
+ * Description: memory region, a memory pool with flags.
+ *
+ * Members:
+ *   @mempool: memory pool of region.
+ *   @start: start address of region.
+ *   @size: size of region.
+ *   @flags: flags of region, see enum pl_mempool_flags.
+ ************************************************************************************/
+struct pl_mempool_region {
+	pl_mempool_handle_t mempool;
+	void *start;
+	size_t size;
+	uchar_t flags;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -53,6 +128,27 @@ extern "C" {
 pl_mempool_handle_t pl_mempool_init(void *pool, ushrt_t id,
                                   size_t pool_size, uchar_t grain_order);
 
+/*************************************************************************************
+ * Function Name: pl_mempool_init_lock
+ *
+ * Description:
+ *    Memory pool initialization interface with the lock of pool,
+ *    pl_mempool_init() uses PL_MEMPOOL_LOCK_SEM.
+ *
+ * Param:
+ *   @pool: user provided memory block required.
+ *   @id: memory pool identification number.
+ *   @pool_size: user provided memory block size required.
+ *   @grain_order: the minimum granularity that memory allocators need to manage.
+ *                 grain_order_size = (1 << grain_order).
+ *   @lock: lock of pool, see enum pl_mempool_lock.
+ *
+ * Return:
+ *   handle of memory pool.
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_init_lock(void *pool, ushrt_t id, size_t pool_size,
+                                       uchar_t grain_order, enum pl_mempool_lock lock);
+
 /*************************************************************************************
  * Function Name: pl_mempool_malloc
  *
@@ -68,6 +164,21 @@ pl_mempool_handle_t pl_mempool_init(void *pool, ushrt_t id,
  ************************************************************************************/
 void *pl_mempool_malloc(pl_mempool_handle_t mempool, size_t size);
 
+/*************************************************************************************
+ * Function Name: pl_mempool_malloc_isr
+ *
+ * Description:
+ *   Allocate memory in interrupt, the pool must be PL_MEMPOOL_LOCK_CRITICAL.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ * 
+ * Return:
+ *   address of memory, NULL if the pool is not ISR-safe.
+ ************************************************************************************/
+void *pl_mempool_malloc_isr(pl_mempool_handle_t mempool, size_t size);
+
 /*************************************************************************************
  * Function Name: pl_mempool_free
  *
@@ -83,6 +194,88 @@ void *pl_mempool_malloc(pl_mempool_handle_t mempool, size_t size);
  ************************************************************************************/
 void pl_mempool_free(pl_mempool_handle_t mempool, void *p);
 
+/*************************************************************************************
+ * Function Name: pl_mempool_free_isr
+ *
+ * Description:
+ *   Free memory in interrupt, the pool must be PL_MEMPOOL_LOCK_CRITICAL.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ * 
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_isr(pl_mempool_handle_t mempool, void *p);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_alloc_sized
+ *
+ * Description:
+ *   Allocate memory without header for the users which know the size at free,
+ *   such as kernel objects. The memory is freed by pl_mempool_free_sized() with
+ *   the same size, it has no owner and is not walked.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ * 
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void *pl_mempool_alloc_sized(pl_mempool_handle_t mempool, size_t size);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_sized
+ *
+ * Description:
+ *   Free memory of pl_mempool_alloc_sized().
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *   @size: size passed to pl_mempool_alloc_sized().
+ * 
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_sized(pl_mempool_handle_t mempool, void *p, size_t size);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_realloc
+ *
+ * Description:
+ *   Change the size of memory. The memory grows or shrinks in place if the space
+ *   after it is free, otherwise it is moved to a new memory.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address, NULL is the same as pl_mempool_malloc().
+ *   @size: new size of memory, 0 is the same as pl_mempool_free().
+ * 
+ * Return:
+ *   address of memory, NULL on failure and p is not changed.
+ ************************************************************************************/
+void *pl_mempool_realloc(pl_mempool_handle_t mempool, void *p, size_t size);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_memalign
+ *
+ * Description:
+ *   Allocate memory whose address is a multiple of align, such as DMA buffers.
+ *   The memory is freed by pl_mempool_free().
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @align: alignment, power of 2.
+ *   @size: memory size to require.
+ * 
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void *pl_mempool_memalign(pl_mempool_handle_t mempool, size_t align, size_t size);
+
 /*************************************************************************************
  * Function Name: pl_mempool_get_free_bytes
  *
@@ -148,6 +341,198 @@ void *pl_mempool_zalloc(pl_mempool_handle_t mempool, size_t size);
  ************************************************************************************/
 void *pl_mempool_calloc(pl_mempool_handle_t mempool, size_t num, size_t size);
 
+/*************************************************************************************
+ * Function Name: pl_mempool_get_stats
+ *
+ * Description:
+ *   Get statistics of memory pool, the free fragments are counted by scanning the
+ *   pool.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @stats: statistics wanted to get.
+ * 
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mempool_get_stats(pl_mempool_handle_t mempool, struct pl_mempool_stats *stats);
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+/*************************************************************************************
+ * Function Name: pl_mempool_walk
+ *
+ * Description:
+ *   Call walk for each allocation of memory pool.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @walk: callback.
+ *   @arg: argument of callback.
+ * 
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mempool_walk(pl_mempool_handle_t mempool, pl_mempool_walk_t walk, void *arg);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_set_owner
+ *
+ * Description:
+ *   Change the owner of memory, the memory shared by tasks should be owned by
+ *   system (NULL), so it is not reported or reclaimed with a task.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *   @owner: new owner.
+ * 
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_set_owner(pl_mempool_handle_t mempool, void *p, void *owner);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_get_owner_bytes
+ *
+ * Description:
+ *   Get the bytes which are allocated by owner.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ * 
+ * Return:
+ *   usable bytes of the memory of owner.
+ ************************************************************************************/
+size_t pl_mempool_get_owner_bytes(pl_mempool_handle_t mempool, void *owner);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_owner
+ *
+ * Description:
+ *   Free all memory of owner, such as the memory leaked by a killed task.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ * 
+ * Return:
+ *   the number of allocations freed.
+ ************************************************************************************/
+size_t pl_mempool_free_owner(pl_mempool_handle_t mempool, void *owner);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_disown
+ *
+ * Description:
+ *   Give all memory of owner to system, such as the memory left by an exited task.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ * 
+ * Return:
+ *   the number of allocations given to system.
+ ************************************************************************************/
+size_t pl_mempool_disown(pl_mempool_handle_t mempool, void *owner);
+#endif
+
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+/*************************************************************************************
+ * Function Name: pl_mempool_add_region
+ *
+ * Description:
+ *   Init a memory pool on a RAM region and add it to the region table, it is
+ *   called by early initcalls, the default pool is the first region.
+ *
+ * Param:
+ *   @start: start address of region, such as a symbol of linker script.
+ *   @size: size of region.
+ *   @flags: flags of region, see enum pl_mempool_flags.
+ * 
+ * Return:
+ *   handle of memory pool, NULL if the table is full or the region is too small.
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_add_region(void *start, size_t size, uchar_t flags);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_malloc_flags
+ *
+ * Description:
+ *   Allocate memory from the region which fits the flags best, the regions
+ *   without PL_MEMPOOL_DMA are never used if it is required, the hints fall
+ *   back to other regions when the best one is exhausted.
+ *
+ * Param:
+ *   @size: memory size to require.
+ *   @flags: flags of region, see enum pl_mempool_flags.
+ * 
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void *pl_mempool_malloc_flags(size_t size, uchar_t flags);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_flags
+ *
+ * Description:
+ *   Free memory of pl_mempool_malloc_flags(), the region is found by address.
+ *
+ * Param:
+ *   @p: memory address.
+ * 
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_flags(void *p);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_region_of
+ *
+ * Description:
+ *   Get the memory pool of the region which holds an address.
+ *
+ * Param:
+ *   @p: memory address.
+ * 
+ * Return:
+ *   handle of memory pool, NULL if the address is not in any region.
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_region_of(const void *p);
+
+/*************************************************************************************
+ * Function Name: pl_mempool_get_region
+ *
+ * Description:
+ *   Get a region of the table, pl_mempool_get_stats() on its pool gives the
+ *   statistics of region.
+ *
+ * Param:
+ *   @idx: index of region.
+ *   @region: region to fill.
+ * 
+ * Return:
+ *   0 on success, -ENOENT if idx is out of the table.
+ ************************************************************************************/
+int pl_mempool_get_region(size_t idx, struct pl_mempool_region *region);
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+/*************************************************************************************
+ * Function Name: pl_mempool_disown_regions
+ *
+ * Description:
+ *   Give all memory of owner in every region to system.
+ *
+ * Param:
+ *   @owner: owner, the task id.
+ * 
+ * Return:
+ *   the number of allocations given to system.
+ ************************************************************************************/
+size_t pl_mempool_disown_regions(void *owner);
+#endif
+#endif
+
 #ifdef __cplusplus
 }
 #endif
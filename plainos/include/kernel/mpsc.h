@@ -0,0 +1,127 @@
+/*
+MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_MPSC_H__
+#define __KERNEL_MPSC_H__
+
+#include <types.h>
+#include <errno.h>
+
+/*************************************************************************************
+ * Structure Name: pl_mpsc_slot
+ * Description: a slot of the mpsc ring.
+ *
+ * Members:
+ *   @seq: sequence of slot, it tells if the slot is free or full for a position.
+ *   @data: the entry in slot.
+ ************************************************************************************/
+struct pl_mpsc_slot {
+	volatile uint_t seq;
+	void *data;
+};
+
+/*************************************************************************************
+ * Structure Name: pl_mpsc
+ * Description: bounded multi-producer single-consumer ring, the producers may be
+ *              interrupts or tasks, no interrupt is disabled to push or pop.
+ *
+ * Members:
+ *   @in: position of the next push, it is claimed by pl_port_atomic_cmpxchg().
+ *   @out: position of the next pop, it is only changed by the consumer.
+ *   @mask: count of slots minus 1.
+ *   @slots: slots of ring.
+ *
+ * NOTE:
+ *   A producer claims a position and then fills its slot, the consumer stops at a
+ *   claimed slot until it is filled. So a task producer preempted between the two
+ *   steps holds back the entries after it, but none of them is lost.
+ ************************************************************************************/
+struct pl_mpsc {
+	volatile uint_t in;
+	volatile uint_t out;
+	uint_t mask;
+	struct pl_mpsc_slot *slots;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_init
+ * Description: initialize a mpsc ring.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *   @slots: slots of ring.
+ *   @nr_slots: count of slots, MUST BE a power of 2.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mpsc_init(struct pl_mpsc *mpsc, struct pl_mpsc_slot *slots, uint_t nr_slots);
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_push
+ * Description: push an entry to the ring, it can be called by any producer,
+ *              including interrupts.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *   @data: the entry, it must not be NULL.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, -EFULL if the ring is full.
+ ************************************************************************************/
+int pl_mpsc_push(struct pl_mpsc *mpsc, void *data);
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_pop
+ * Description: pop an entry from the ring, only one consumer may call it.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *
+ * Return:
+ *   the entry, NULL if the ring is empty or its first slot is not filled yet.
+ ************************************************************************************/
+void *pl_mpsc_pop(struct pl_mpsc *mpsc);
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_len
+ * Description: get the count of positions claimed and not popped.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *
+ * Return:
+ *   count of entries.
+ ************************************************************************************/
+uint_t pl_mpsc_len(struct pl_mpsc *mpsc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_MPSC_H__ */
@@ -0,0 +1,175 @@
+/*
+MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_PIPE_H__
+#define __KERNEL_PIPE_H__
+
+#include <types.h>
+#include <kernel/list.h>
+#include <kernel/kfifo.h>
+
+/* timeouts of read and write, in ticks */
+#define PL_PIPE_NOWAIT                  (0)
+#define PL_PIPE_WAIT_FOREVER            (0xffffffffu)
+
+/* no delimiter wakes the reader */
+#define PL_PIPE_NO_DELIM                (-1)
+
+/*************************************************************************************
+ * Structure Name: pl_pipe
+ * Description: blocking pipe over a kfifo.
+ *
+ * Members:
+ *   @fifo: kfifo of the pipe, it is owned by the caller.
+ *   @readers: tasks waiting for data.
+ *   @writers: tasks waiting for space.
+ *   @read_wake: high watermark, a reader is woken when so many bytes are in.
+ *   @write_wake: low watermark, a writer is woken when so many bytes are free.
+ *   @delim: a reader is woken when this character is in, PL_PIPE_NO_DELIM if none.
+ *   @delim_in: index of kfifo just behind the last delimiter put.
+ *   @delim_pending: the last delimiter put is not got by a reader yet.
+ *   @latency: ticks a byte may wait for the watermark, 0 if no limit.
+ *   @first_ticks: ticks when the kfifo became not empty.
+ *   @nr_wakeups: count of times the readers were woken.
+ *
+ * NOTE:
+ *   The kfifo is copied with the interrupts disabled, so any task may read or
+ *   write the pipe. An interrupt can only write it with PL_PIPE_NOWAIT, or put
+ *   the characters into the kfifo itself and call pl_pipe_notify().
+ ************************************************************************************/
+struct pl_pipe {
+	struct pl_kfifo *fifo;
+	struct list_node readers;
+	struct list_node writers;
+	uint_t read_wake;
+	uint_t write_wake;
+	int delim;
+	uint_t delim_in;
+	bool delim_pending;
+	u32_t latency;
+	u64_t first_ticks;
+	u32_t nr_wakeups;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*************************************************************************************
+ * Function Name: pl_pipe_init
+ * Description: initialize a pipe over a kfifo, a reader is woken by every byte and
+ *              a writer by every free byte until the watermarks are set.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @fifo: initialized kfifo.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_pipe_init(struct pl_pipe *pipe, struct pl_kfifo *fifo);
+
+/*************************************************************************************
+ * Function Name: pl_pipe_set_read_wake
+ * Description: set when the readers are woken, the first condition met wakes them.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @wake_len: count of bytes in the kfifo, at least 1.
+ *   @delim: delimiter character, PL_PIPE_NO_DELIM if none.
+ *   @latency: ticks the first byte may wait, 0 if it waits for the others.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_pipe_set_read_wake(struct pl_pipe *pipe, uint_t wake_len, int delim,
+                          u32_t latency);
+
+/*************************************************************************************
+ * Function Name: pl_pipe_set_write_wake
+ * Description: set how many bytes must be free to wake the writers.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @wake_len: count of free bytes in the kfifo, at least 1.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_pipe_set_write_wake(struct pl_pipe *pipe, uint_t wake_len);
+
+/*************************************************************************************
+ * Function Name: pl_pipe_read
+ * Description: read the pipe, it waits until the wake condition is met or the
+ *              timeout expires, then gets what is in the kfifo.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @data: buffer of data.
+ *   @len: length of buffer, a reader never waits for more than it.
+ *   @timeout: ticks to wait, PL_PIPE_NOWAIT or PL_PIPE_WAIT_FOREVER.
+ *
+ * Return:
+ *   count of bytes read, -EAGAIN if the pipe is empty and timeout is
+ *   PL_PIPE_NOWAIT, -ETIMEOUT if it is still empty when the timeout expires.
+ ************************************************************************************/
+int pl_pipe_read(struct pl_pipe *pipe, char *data, uint_t len, u32_t timeout);
+
+/*************************************************************************************
+ * Function Name: pl_pipe_write
+ * Description: write the pipe, it waits for free space until all the data is put
+ *              or the timeout expires.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @data: data to write.
+ *   @len: length of data.
+ *   @timeout: ticks to wait, PL_PIPE_NOWAIT or PL_PIPE_WAIT_FOREVER.
+ *
+ * Return:
+ *   count of bytes written, -EAGAIN if the pipe is full and timeout is
+ *   PL_PIPE_NOWAIT, -ETIMEOUT if it is still full when the timeout expires.
+ ************************************************************************************/
+int pl_pipe_write(struct pl_pipe *pipe, const char *data, uint_t len, u32_t timeout);
+
+/*************************************************************************************
+ * Function Name: pl_pipe_notify
+ * Description: tell the pipe that characters were put into its kfifo directly,
+ *              such as by the top half of a serial interrupt.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @chars: the characters put, they end at the in index of the kfifo.
+ *   @len: length of characters.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_pipe_notify(struct pl_pipe *pipe, const char *chars, uint_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_PIPE_H__ */
@@ -0,0 +1,239 @@
+/*
+MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_RING_H__
+#define __KERNEL_RING_H__
+
+#include <types.h>
+#include <errno.h>
+#include <port/port.h>
+#include <lib/string.h>
+#include <kernel/kernel.h>
+
+/*************************************************************************************
+ * Description: index helpers of the rings.
+ *   The in and out indexes run freely and wrap by themselves, a slot is the index
+ *   masked by the capacity, which MUST BE a power of 2. pl_kfifo, the typed rings
+ *   and the C++ pl_ring share them.
+ ************************************************************************************/
+#define pl_ring_idx_len(in, out)              ((in) - (out))
+#define pl_ring_idx_avail(in, out, cap)       ((cap) - ((in) - (out)))
+#define pl_ring_idx_off(idx, cap)             ((idx) & ((cap) - 1))
+#define pl_ring_idx_contig(idx, cap, n)       min((n), (cap) - pl_ring_idx_off(idx, cap))
+
+/*************************************************************************************
+ * Macro Name: PL_RING_DEFINE
+ * Description: define a ring of elements of type, its functions are inlined.
+ *
+ * Param:
+ *   @name: name of the struct, the functions are named name_init(), name_len(),
+ *          name_avail(), name_slot(), name_push(), name_pop(), name_push_n() and
+ *          name_pop_n().
+ *   @type: type of element, its size is known at compile time.
+ *
+ * NOTE:
+ *   One producer and one consumer may use the ring without a lock on a single core,
+ *   such as an interrupt and a task, the index is stored after the element and the
+ *   compiler barrier keeps the order. Others must lock it.
+ ************************************************************************************/
+#define PL_RING_DEFINE(name, type)                                                    \
+struct name {                                                                         \
+	volatile uint_t in;                                                               \
+	volatile uint_t out;                                                              \
+	uint_t cap;                                                                       \
+	type *buff;                                                                       \
+};                                                                                    \
+                                                                                      \
+static inline int name##_init(struct name *ring, type *buff, uint_t cap)              \
+{                                                                                     \
+	if (ring == NULL || buff == NULL)                                                 \
+		return -EFAULT;                                                               \
+                                                                                      \
+	if (!pl_is_power_of_2(cap))                                                       \
+		return -EINVAL;                                                               \
+                                                                                      \
+	ring->in = 0;                                                                     \
+	ring->out = 0;                                                                    \
+	ring->cap = cap;                                                                  \
+	ring->buff = buff;                                                                \
+	return OK;                                                                        \
+}                                                                                     \
+                                                                                      \
+static inline uint_t name##_len(struct name *ring)                                    \
+{                                                                                     \
+	return pl_ring_idx_len(ring->in, ring->out);                                      \
+}                                                                                     \
+                                                                                      \
+static inline uint_t name##_avail(struct name *ring)                                  \
+{                                                                                     \
+	return pl_ring_idx_avail(ring->in, ring->out, ring->cap);                         \
+}                                                                                     \
+                                                                                      \
+static inline type *name##_slot(struct name *ring, uint_t idx)                        \
+{                                                                                     \
+	return &ring->buff[pl_ring_idx_off(idx, ring->cap)];                              \
+}                                                                                     \
+                                                                                      \
+static inline bool name##_push(struct name *ring, type val)                           \
+{                                                                                     \
+	uint_t in = ring->in;                                                             \
+                                                                                      \
+	if (pl_ring_idx_len(in, ring->out) >= ring->cap)                                  \
+		return false;                                                                 \
+                                                                                      \
+	ring->buff[pl_ring_idx_off(in, ring->cap)] = val;                                 \
+	pl_port_compile_barrier;                                                          \
+	ring->in = in + 1;                                                                \
+	return true;                                                                      \
+}                                                                                     \
+                                                                                      \
+static inline bool name##_pop(struct name *ring, type *val)                           \
+{                                                                                     \
+	uint_t out = ring->out;                                                           \
+                                                                                      \
+	if (ring->in == out)                                                              \
+		return false;                                                                 \
+                                                                                      \
+	pl_port_compile_barrier;                                                          \
+	*val = ring->buff[pl_ring_idx_off(out, ring->cap)];                               \
+	pl_port_compile_barrier;                                                          \
+	ring->out = out + 1;                                                              \
+	return true;                                                                      \
+}                                                                                     \
+                                                                                      \
+static inline uint_t name##_push_n(struct name *ring, const type *vals, uint_t n)     \
+{                                                                                     \
+	uint_t len;                                                                       \
+	uint_t in = ring->in;                                                             \
+                                                                                      \
+	n = min(n, pl_ring_idx_avail(in, ring->out, ring->cap));                          \
+	len = pl_ring_idx_contig(in, ring->cap, n);                                       \
+	pl_memcpy(ring->buff + pl_ring_idx_off(in, ring->cap), vals, len * sizeof(type)); \
+	pl_memcpy(ring->buff, vals + len, (n - len) * sizeof(type));                      \
+	pl_port_compile_barrier;                                                          \
+	ring->in = in + n;                                                                \
+	return n;                                                                         \
+}                                                                                     \
+                                                                                      \
+static inline uint_t name##_pop_n(struct name *ring, type *vals, uint_t n)            \
+{                                                                                     \
+	uint_t len;                                                                       \
+	uint_t out = ring->out;                                                           \
+                                                                                      \
+	n = min(n, pl_ring_idx_len(ring->in, out));                                       \
+	pl_port_compile_barrier;                                                          \
+	len = pl_ring_idx_contig(out, ring->cap, n);                                      \
+	pl_memcpy(vals, ring->buff + pl_ring_idx_off(out, ring->cap), len * sizeof(type)); \
+	pl_memcpy(vals + len, ring->buff, (n - len) * sizeof(type));                      \
+	pl_port_compile_barrier;                                                          \
+	ring->out = out + n;                                                              \
+	return n;                                                                         \
+}
+
+#ifdef __cplusplus
+/*************************************************************************************
+ * Class Name: pl_ring
+ * Description: ring of CAP elements of T in the object, the same as the rings of
+ *              PL_RING_DEFINE, except that the capacity is known at compile time.
+ *
+ * Template Param:
+ *   @T: type of element, it is copied by assignment.
+ *   @CAP: capacity, MUST BE a power of 2.
+ ************************************************************************************/
+template <typename T, uint_t CAP>
+class pl_ring {
+	/* a negative size fails to compile if CAP is not a power of 2 */
+	typedef char cap_must_be_power_of_2[pl_is_power_of_2(CAP) ? 1 : -1];
+
+public:
+	pl_ring() : in(0), out(0) {}
+
+	uint_t len() const { return pl_ring_idx_len(in, out); }
+	uint_t avail() const { return pl_ring_idx_avail(in, out, CAP); }
+	uint_t capacity() const { return CAP; }
+
+	bool push(const T &val)
+	{
+		uint_t idx = in;
+
+		if (pl_ring_idx_len(idx, out) >= CAP)
+			return false;
+
+		buff[pl_ring_idx_off(idx, CAP)] = val;
+		pl_port_compile_barrier;
+		in = idx + 1;
+		return true;
+	}
+
+	bool pop(T &val)
+	{
+		uint_t idx = out;
+
+		if (in == idx)
+			return false;
+
+		pl_port_compile_barrier;
+		val = buff[pl_ring_idx_off(idx, CAP)];
+		pl_port_compile_barrier;
+		out = idx + 1;
+		return true;
+	}
+
+	uint_t push_n(const T *vals, uint_t n)
+	{
+		uint_t i;
+		uint_t idx = in;
+
+		n = min(n, pl_ring_idx_avail(idx, out, CAP));
+		for (i = 0; i < n; i++)
+			buff[pl_ring_idx_off(idx + i, CAP)] = vals[i];
+
+		pl_port_compile_barrier;
+		in = idx + n;
+		return n;
+	}
+
+	uint_t pop_n(T *vals, uint_t n)
+	{
+		uint_t i;
+		uint_t idx = out;
+
+		n = min(n, pl_ring_idx_len(in, idx));
+		pl_port_compile_barrier;
+		for (i = 0; i < n; i++)
+			vals[i] = buff[pl_ring_idx_off(idx + i, CAP)];
+
+		pl_port_compile_barrier;
+		out = idx + n;
+		return n;
+	}
+
+private:
+	volatile uint_t in;
+	volatile uint_t out;
+	T buff[CAP];
+};
+#endif
+
+#endif /* __KERNEL_RING_H__ */
@@ -31,6 +31,36 @@ SOFTWARE.
 struct pl_stimer;
 typedef void (*pl_stimer_fun_t)(struct pl_stimer *timer);
 
+/*************************************************************************************
+ * Structure Name: pl_stimer
+ * Description: soft timer.
+ *
+ * Members:
+ *   @node: node in the timer wheel or in the expired list of daemon.
+ *   @name: name of timer.
+ *   @fun: callback function.
+ *   @priv_data: private data.
+ *   @timing_cnt: the count of timing, it is the period of a reload timer.
+ *   @reach_cnt: the systicks the timer expires at.
+ *   @slack_mask: the timer may expire up to slack_mask ticks late, its deadline is
+ *                rounded up to a multiple of slack_mask + 1 to share the tick with
+ *                the other timers rounded to it.
+ *   @overruns: count of periods skipped by a reload timer since it was started.
+ *   @reload: the timer is started again after its callback.
+ *   @expired: the timer is taken by the daemon and its callback is to be called.
+ *   @hard: the callback is called in the systick handler, not by the daemon.
+ *
+ * NOTE:
+ *   A reload timer expires at reach_cnt + timing_cnt of its last deadline, not of
+ *   the time its callback returns, so the latency of daemon does not drift it. The
+ *   periods already passed when it is started again are skipped and counted.
+ *
+ *   The callback of a hard timer runs in the systick interrupt with interrupts
+ *   disabled, before any task is scheduled. It must be short and must not block:
+ *   no delay, no waiting on a semaphore, completion or pipe, no pl_workqueue_flush()
+ *   and no allocation from a memory pool. It may toggle a pin, notify or resume a
+ *   task, add a work, post a completion or start and cancel timers.
+ ************************************************************************************/
 struct pl_stimer {
 	struct list_node node;
 	const char *name;
@@ -38,7 +68,11 @@ struct pl_stimer {
 	void *priv_data;
 	u64_t timing_cnt;
 	u64_t reach_cnt;
+	u32_t slack_mask;
+	u32_t overruns;
 	bool reload;
+	bool expired;
+	bool hard;
 };
 
 #ifdef __cplusplus
@@ -74,6 +108,38 @@ struct pl_stimer *pl_softtimer_request(const char *name);
  ************************************************************************************/
 int pl_softtimer_get_private_data(struct pl_stimer *timer, void **data);
 
+/*************************************************************************************
+ * Function Name: pl_softtimer_get_overruns
+ *
+ * Description:
+ *   get the count of periods skipped by a reload timer.
+ * 
+ * Parameters:
+ *  @timer: handle of soft timer requested.
+ *  @overruns: count of periods skipped since the timer was started.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_softtimer_get_overruns(struct pl_stimer *timer, u32_t *overruns);
+
+/*************************************************************************************
+ * Function Name: pl_softtimer_set_hard
+ *
+ * Description:
+ *   call the callback of soft timer in the systick handler or by the daemon task,
+ *   see the restrictions of hard timer in struct pl_stimer.
+ * 
+ * Parameters:
+ *  @timer: handle of soft timer requested.
+ *  @hard: call the callback in the systick handler whether or not.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EBUSY: the timer is running.
+ ************************************************************************************/
+int pl_softtimer_set_hard(struct pl_stimer *timer, bool hard);
+
 /*************************************************************************************
  * Function Name: pl_softtimer_timer_init
  *
@@ -96,7 +162,7 @@ void pl_softtimer_timer_init(struct pl_stimer *stimer, pl_stimer_fun_t fun,
  * Function Name: pl_softtimer_start
  *
  * Description:
- *   start soft timer.
+ *   start soft timer, with the slack set by pl_softtimer_reload().
  * 
  * Parameters:
  *  @timer: handle of soft timer requested.
@@ -117,25 +183,44 @@ int pl_softtimer_start(struct pl_stimer *timer);
  *  @reload: reload whether or not.
  *  @fun: callback function.
  *  @timing_cnt: the count of timing.
+ *  @slack_cnt: ticks the timer may expire late, so that the expiries close to each
+ *              other share one wakeup of the daemon, 0 for an exact timer.
  *  @priv_data: private data.
  *
  * Return:
  *  Greater than or equal to 0 on success, less than 0 on failure.
  ************************************************************************************/
 int pl_softtimer_reload(struct pl_stimer *timer, bool reload, pl_stimer_fun_t fun,
-                                               u64_t timing_cnt, void *priv_data);
+                        u64_t timing_cnt, u64_t slack_cnt, void *priv_data);
+
+/*************************************************************************************
+ * Function Name: pl_softtimer_get_wakeups_saved
+ *
+ * Description:
+ *   get the count of expiries which shared the tick of another timer because of
+ *   their slack.
+ * 
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  count of wakeups saved.
+ ************************************************************************************/
+u32_t pl_softtimer_get_wakeups_saved(void);
 
 /*************************************************************************************
  * Function Name: pl_softtimer_cancel
  *
  * Description:
- *   cancel soft timer.
+ *   cancel soft timer, a timer expired but not called yet is not called, a reload
+ *   timer in its callback is not started again.
  * 
  * Parameters:
  *  @timer: handle of soft timer requested.
  *
  * Return:
  *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EEMPTY: the timer is not running.
  ************************************************************************************/
 int pl_softtimer_cancel(struct pl_stimer *timer);
 
@@ -153,6 +153,37 @@ void pl_task_pend(pl_tid_t tid);
  ************************************************************************************/
 void pl_task_resume(pl_tid_t tid);
 
+/*************************************************************************************
+ * Function Name: pl_task_notify
+ *
+ * Description:
+ *   send a direct notification to a task, it can be called in interrupt context.
+ *   The notifications are counted, so none of them will be lost even if the task
+ *   is not waiting at the moment.
+ *
+ * Parameters:
+ *  @tid: task id;
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+void pl_task_notify(pl_tid_t tid);
+
+/*************************************************************************************
+ * Function Name: pl_task_notify_wait
+ *
+ * Description:
+ *   wait for direct notifications of current task, it will pend current task until
+ *   any notification arrived.
+ *
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  count of notifications taken.
+ ************************************************************************************/
+u32_t pl_task_notify_wait(void);
+
 /*************************************************************************************
  * Function Name: pl_task_restart
  *
@@ -168,6 +199,20 @@ void pl_task_resume(pl_tid_t tid);
  ************************************************************************************/
 void pl_task_restart(pl_tid_t tid);
 
+/*************************************************************************************
+ * Function Name: pl_task_get_name
+ *
+ * Description:
+ *   get the name of task.
+ * 
+ * Parameters:
+ *  @tid: task id;
+ *
+ * Return:
+ *  name of task, NULL if tid is NULL.
+ ************************************************************************************/
+const char *pl_task_get_name(pl_tid_t tid);
+
 /*************************************************************************************
  * Function Name: pl_task_kill
  *
@@ -197,6 +242,20 @@ int pl_task_kill(pl_tid_t tid);
  ************************************************************************************/
 int pl_task_get_syscount(u64_t *c);
 
+/*************************************************************************************
+ * Function Name: pl_task_get_switch_count
+ *
+ * Description:
+ *   The function is used to get the count of context switches.
+ * 
+ * Parameters:
+ *  @c: count wanted to get.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_task_get_switch_count(u32_t *c);
+
 /*************************************************************************************
  * Function Name: pl_task_get_cpu_rate_count
  *
@@ -0,0 +1,138 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_TASKLET_H__
+#define __KERNEL_TASKLET_H__
+
+#include <types.h>
+#include <kernel/list.h>
+#include <kernel/kernel.h>
+
+struct pl_tasklet;
+typedef void (*pl_tasklet_fun_t)(struct pl_tasklet *tasklet);
+
+/*************************************************************************************
+ * Type Name: pl_tasklet_state
+ * Description: tasklet state definition.
+ *
+ * Members:
+ *   PL_TASKLET_STATE_IDLE: the tasklet is not queued.
+ *   PL_TASKLET_STATE_PENDING: the tasklet is queued and waits for the exception exit.
+ *   PL_TASKLET_STATE_RUNNING: the callback of the tasklet is running.
+ ************************************************************************************/
+enum pl_tasklet_state {
+	PL_TASKLET_STATE_IDLE = 0,
+	PL_TASKLET_STATE_PENDING,
+	PL_TASKLET_STATE_RUNNING,
+};
+
+/*************************************************************************************
+ * Structure Name: pl_tasklet
+ * Description: deferred procedure call.
+ *
+ * Members:
+ *   @node: list node of the pending tasklets.
+ *   @fun: callback function.
+ *   @priv_data: private data.
+ *   @state: state of the tasklet.
+ *
+ * NOTE:
+ *   The callback runs at the lowest exception priority with interrupts enabled,
+ *   before the scheduler picks the next task. It has no task context, so it must
+ *   not block (no pl_semaphore_wait, pl_task_delay_ticks, pl_mempool_malloc...).
+ ************************************************************************************/
+struct pl_tasklet {
+	struct list_node node;
+	pl_tasklet_fun_t fun;
+	void *priv_data;
+	volatile u8_t state;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_init
+ *
+ * Description:
+ *   initialize a tasklet.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *  @fun: callback function.
+ *  @priv_data: private data.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_tasklet_init(struct pl_tasklet *tasklet, pl_tasklet_fun_t fun, void *priv_data);
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_schedule
+ *
+ * Description:
+ *   queue a tasklet, it can be called in interrupt context.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EALREADY: the tasklet is already pending, it will run only once.
+ ************************************************************************************/
+int pl_tasklet_schedule(struct pl_tasklet *tasklet);
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_cancel
+ *
+ * Description:
+ *   remove a pending tasklet.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_tasklet_cancel(struct pl_tasklet *tasklet);
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_get_private_data
+ *
+ * Description:
+ *   get the private data of tasklet.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *
+ * Return:
+ *   private data of the tasklet.
+ ************************************************************************************/
+void *pl_tasklet_get_private_data(struct pl_tasklet *tasklet);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __KERNEL_TASKLET_H__ */
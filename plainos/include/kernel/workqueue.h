@@ -26,23 +26,91 @@ SOFTWARE.
 
 #include <types.h>
 #include <kernel/task.h>
+#include <kernel/list.h>
+#include <kernel/softtimer.h>
 #include <kernel/kernel.h>
+#include <kernel/ring.h>
 
 struct pl_work;
 typedef void (*pl_work_fun_t)(struct pl_work *work);
 
+#define PL_WORK_STATE_PENDING           (1 << 0)
+#define PL_WORK_STATE_RUNNING           (1 << 1)
+#define PL_WORK_STATE_QUEUED            (1 << 2)
+
+PL_RING_DEFINE(pl_work_ring, struct pl_work *)
+
+/*************************************************************************************
+ * Structure Name: pl_work
+ * Description: work of workqueue.
+ *
+ * Members:
+ *   @fun: callback function.
+ *   @priv_data: private data.
+ *   @wq: workqueue the work was added to.
+ *   @seq: index of the fifo slot holding the work, valid while it is queued.
+ *   @state: PL_WORK_STATE_PENDING, PL_WORK_STATE_RUNNING and PL_WORK_STATE_QUEUED
+ *           bits, the last one is set while the work is in a slot of the fifo.
+ *
+ * NOTE:
+ *   Adding a pending work is a no-op, so it runs only once however many times it
+ *   was added. A work can be added again in its callback, but it must not be freed
+ *   there.
+ ************************************************************************************/
 struct pl_work {
 	pl_work_fun_t fun;
 	void *priv_data;
+	struct pl_workqueue *wq;
+	uint_t seq;
+	volatile u8_t state;
+};
+
+/*************************************************************************************
+ * Structure Name: pl_delayed_work
+ * Description: work added to the workqueue by a softtimer.
+ *
+ * Members:
+ *   @work: the work.
+ *   @timer: softtimer of the delay.
+ ************************************************************************************/
+struct pl_delayed_work {
+	struct pl_work work;
+	struct pl_stimer timer;
 };
 
+/*************************************************************************************
+ * Structure Name: pl_workqueue
+ * Description: workqueue, works in the fifo are drained by a pool of workers.
+ *
+ * Members:
+ *   @exec_thread: the first worker task.
+ *   @name: name of the workqueue and its workers.
+ *   @fifo: fifo of works, its capacity MUST BE a power of 2.
+ *   @prio: priority of the workers.
+ *   @nr_workers: count of workers.
+ *   @max_workers: max count of workers, the pool grows on demand up to it.
+ *   @nr_running: count of works running.
+ *   @nr_wakeups: count of the idle workers woken by adding works.
+ *   @batch: the only worker drains the fifo in batches, see pl_workqueue_create_batch().
+ *   @stack_sz: stack size of each worker.
+ *   @workers: list of all workers.
+ *   @idle_workers: list of the workers sleeping for works.
+ *   @flushers: list of the tasks waiting for the workqueue draining.
+ ************************************************************************************/
 struct pl_workqueue {
 	pl_tid_t exec_thread;
-	u32_t fifo_cap;
-	u32_t fifo_in;
-	u32_t fifo_out;
 	const char *name;
-	struct pl_work **fifo;
+	struct pl_work_ring fifo;
+	u16_t prio;
+	u16_t nr_workers;
+	u16_t max_workers;
+	u16_t nr_running;
+	u32_t nr_wakeups;
+	bool batch;
+	size_t stack_sz;
+	struct list_node workers;
+	struct list_node idle_workers;
+	struct list_node flushers;
 };
 
 /*************************************************************************************
@@ -74,17 +142,66 @@ extern struct pl_workqueue *g_pl_sys_lowq_handle;
 struct pl_workqueue *pl_workqueue_create(const char *name, u16_t prio,
                                size_t wq_stack_sz, u32_t wq_fifo_cap);
 
+/*************************************************************************************
+ * Function Name: pl_workqueue_create_pool
+ *
+ * Description:
+ *   create a workqueue with a pool of workers draining the same fifo, a slow work
+ *   only stalls one worker. When works are waiting and no worker is idle, the busy
+ *   worker creates a new one, up to max_workers.
+ *   Producers only wake a worker parked on the idle list, never a busy one.
+ * 
+ * Parameters:
+ *  @name: workqueue name.
+ *  @proi: priority of workqueue.
+ *  @wq_stack_sz: stack size of each worker.
+ *  @wq_fifo_cap: capacity of workqueue fifo.
+ *  @nr_workers: count of workers created at the beginning.
+ *  @max_workers: max count of workers.
+ *
+ * Return:
+ *  @struct pl_workqueue*: handle of workqueue requested.
+ ************************************************************************************/
+struct pl_workqueue *pl_workqueue_create_pool(const char *name, u16_t prio,
+                               size_t wq_stack_sz, u32_t wq_fifo_cap,
+                               u16_t nr_workers, u16_t max_workers);
+
+/*************************************************************************************
+ * Function Name: pl_workqueue_create_batch
+ *
+ * Description:
+ *   create a workqueue whose only worker drains the fifo in batches: it takes a
+ *   snapshot of the fifo and runs all works of it with two critical sections.
+ *   The slots of a batch are released when the whole batch has run, so the fifo
+ *   fills up sooner than the one of pl_workqueue_create(), size it for the bursts.
+ * 
+ * Parameters:
+ *  @name: workqueue name.
+ *  @proi: priority of workqueue.
+ *  @wq_stack_sz: workqueue task stack size.
+ *  @wq_fifo_cap: capacity of workqueue fifo.
+ *
+ * Return:
+ *  @struct pl_workqueue*: handle of workqueue requested.
+ ************************************************************************************/
+struct pl_workqueue *pl_workqueue_create_batch(const char *name, u16_t prio,
+                               size_t wq_stack_sz, u32_t wq_fifo_cap);
+
 /*************************************************************************************
  * Function Name: pl_workqueue_destroy
  *
  * Description:
- *   destroy a workqueue.
+ *   destroy a workqueue, the works left in the fifo are dropped and the tasks
+ *   flushing it are woken up. The delayed works still on their timers must be
+ *   cancelled before, and no work may be added while it is destroyed.
  * 
  * Parameters:
  *  @workqueue: workqueue handle.
  *
  * Return:
  *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EBUSY: a work is running, flush the workqueue first, or it is called by a
+ *          worker of the workqueue.
  ************************************************************************************/
 int pl_workqueue_destroy(struct pl_workqueue *workqueue);
 
@@ -106,7 +223,7 @@ int pl_work_init(struct pl_work *work, pl_work_fun_t fun, void *priv_data);
  * Function Name: pl_work_add
  *
  * Description:
- *   add a work to the workqueue.
+ *   add a work to the workqueue, it is a no-op if the work is pending.
  * 
  * Parameters:
  *  @workqueue: workqueue handle.
@@ -121,7 +238,8 @@ int pl_work_add(struct pl_workqueue *workqueue, struct pl_work *work);
  * Function Name: pl_work_cancel
  *
  * Description:
- *   cancel a work int the workqueue.
+ *   cancel a pending work in O(1), the slot of the work is cleared and skipped
+ *   by the worker, so the work may be freed once it is cancelled.
  * 
  * Parameters:
  *  @workqueue: workqueue handle.
@@ -129,9 +247,74 @@ int pl_work_add(struct pl_workqueue *workqueue, struct pl_work *work);
  *
  * Return:
  *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EBUSY: the work is running and not pending.
+ *  -EEMPTY: the work is not pending.
  ************************************************************************************/
 int pl_work_cancel(struct pl_workqueue *workqueue, struct pl_work *work);
 
+/*************************************************************************************
+ * Function Name: pl_workqueue_flush
+ *
+ * Description:
+ *   wait until the fifo of workqueue is empty and no work is running.
+ *   NOTE: it must not be called in the callback of a work of the same workqueue.
+ * 
+ * Parameters:
+ *  @workqueue: workqueue handle.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_workqueue_flush(struct pl_workqueue *workqueue);
+
+/*************************************************************************************
+ * Function Name: pl_delayed_work_init
+ *
+ * Description:
+ *   initialize a delayed work.
+ * 
+ * Parameters:
+ *  @dwork: delayed work.
+ *  @fun: callback function.
+ *  @priv_data: private data.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_delayed_work_init(struct pl_delayed_work *dwork, pl_work_fun_t fun,
+                         void *priv_data);
+
+/*************************************************************************************
+ * Function Name: pl_work_add_delayed
+ *
+ * Description:
+ *   add a work to the workqueue when the delay ticks expired, the work is
+ *   pending during the delay.
+ * 
+ * Parameters:
+ *  @workqueue: workqueue handle.
+ *  @dwork: delayed work.
+ *  @ticks: delay ticks, the work is added at once if it is 0.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_work_add_delayed(struct pl_workqueue *workqueue, struct pl_delayed_work *dwork,
+                        u64_t ticks);
+
+/*************************************************************************************
+ * Function Name: pl_delayed_work_cancel
+ *
+ * Description:
+ *   cancel a delayed work, whether its timer is running or it is in the fifo.
+ * 
+ * Parameters:
+ *  @dwork: delayed work.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_delayed_work_cancel(struct pl_delayed_work *dwork);
 /*************************************************************************************
  * Function Name: pl_work_get_private_data
  *
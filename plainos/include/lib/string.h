@@ -24,8 +24,15 @@ SOFTWARE.
 #ifndef __LIB_STRING_H__
 #define __LIB_STRING_H__
 
+#include <stddef.h>
+
 int pl_lib_ull2str(char *str, unsigned long long n, unsigned char base);
 int pl_lib_ll2str(char *str, long long n, unsigned char base);
+void *pl_memcpy(void *dest, const void *src, size_t len);
+void *pl_memset(void *dest, int c, size_t len);
 void *pl_memmove(void *dest, const void *src, size_t len);
+int pl_memcmp(const void *s1, const void *s2, size_t len);
+size_t pl_strlen(const char *str);
+int pl_strcmp(const char *s1, const char *s2);
 
 #endif /* __LIB_STRING_H__ */
\ No newline at end of file
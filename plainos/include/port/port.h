@@ -91,6 +91,39 @@ void pl_port_cpu_dsb(void);
  ************************************************************************************/
 void pl_port_cpu_isb(void);
 
+/*************************************************************************************
+ * Function Name: pl_port_cpu_cycles
+ *
+ * Description:
+ *   The function is used to read a free running cycle counter, it is used to
+ *   measure short latencies. The resolution is port specific.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   count of cycles.
+ ************************************************************************************/
+u32_t pl_port_cpu_cycles(void);
+
+/*************************************************************************************
+ * Function Name: pl_port_atomic_cmpxchg
+ *
+ * Description:
+ *   The function is used to compare and exchange a word atomically, it must be safe
+ *   against interrupts and other cores without disabling the interrupts if the
+ *   cpu can (LDREX/STREX on Cortex-M3 and later).
+ *
+ * Parameters:
+ *   @ptr: address of the word.
+ *   @old: value expected in the word.
+ *   @val: value stored if the word is equal to old.
+ *
+ * Return:
+ *   the value of the word before, it is equal to old on success.
+ ************************************************************************************/
+uint_t pl_port_atomic_cmpxchg(volatile uint_t *ptr, uint_t old, uint_t val);
+
 /*************************************************************************************
  * Function Name: void pl_port_enter_critical(void)
  * Description: enter critical area.
@@ -199,6 +232,22 @@ int pl_port_systick_init(void);
  ************************************************************************************/
 void pl_callee_systick_expiration(void);
 
+/*************************************************************************************
+ * Function Name: pl_callee_run_tasklets
+ *
+ * Description:
+ *   The function is used to run pending tasklets, we must call it at the entry of
+ *   switching context (PendSV on cortex-m) with interrupts enabled, before
+ *   pl_callee_save_curr_context_sp.
+ *
+ * Parameters:
+ *  none
+ *
+ * Return:
+ *  none
+ ************************************************************************************/
+void pl_callee_run_tasklets(void);
+
 /*************************************************************************************
  * Function Name: pl_callee_save_curr_context_sp
  * Description: update context and return context_sp of the current task.
@@ -0,0 +1,247 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <config.h>
+#include <types.h>
+#include <port/port.h>
+#include <kernel/kernel.h>
+#include <kernel/arena.h>
+#include <kernel/syslog.h>
+#include "arena.h"
+
+#define ARENA_ALIGN                      (sizeof(uintptr_t) << 1)
+
+/*************************************************************************************
+ * Description: state of arena.
+ *   ARENA_STATE_OPEN: memory can be allocated.
+ *   ARENA_STATE_BOOT: the initcalls are running, system tasks use the arena.
+ *   ARENA_STATE_SEALED: no memory can be allocated.
+ ************************************************************************************/
+enum arena_state {
+	ARENA_STATE_OPEN = 0,
+	ARENA_STATE_BOOT,
+	ARENA_STATE_SEALED,
+};
+
+/*************************************************************************************
+ * Structure Name: arena
+ * Description: linear allocator, memory is carved from pos to end.
+ *
+ * Members:
+ *   @start: start of arena.
+ *   @pos: start of free memory.
+ *   @end: end of arena.
+ *   @state: state of arena.
+ ************************************************************************************/
+struct arena {
+	uchar_t *start;
+	uchar_t *pos;
+	uchar_t *end;
+	uchar_t state;
+};
+
+static struct arena boot_arena;
+
+/*************************************************************************************
+ * Function Name: pl_arena_init
+ *
+ * Description:
+ *   Initialize the boot arena on a memory block.
+ *
+ * Parameters:
+ *   @pool: memory block of arena.
+ *   @size: size of memory block.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_init(void *pool, size_t size)
+{
+	boot_arena.start = (uchar_t *)pl_align_address(pool, ARENA_ALIGN);
+	boot_arena.end = (uchar_t *)pool + size;
+	if (boot_arena.start > boot_arena.end)
+		boot_arena.start = boot_arena.end;
+
+	boot_arena.pos = boot_arena.start;
+	boot_arena.state = ARENA_STATE_OPEN;
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_alloc
+ *
+ * Description:
+ *   Allocate memory which is never freed from the boot arena.
+ *
+ * Parameters:
+ *  @size: memory size to require.
+ *
+ * Return:
+ *  address of memory, NULL if the arena is full or sealed.
+ ************************************************************************************/
+void *pl_arena_alloc(size_t size)
+{
+	void *p = NULL;
+
+	if (size == 0)
+		return NULL;
+
+	pl_port_enter_critical();
+	if (boot_arena.state != ARENA_STATE_SEALED &&
+	    size <= (size_t)(boot_arena.end - boot_arena.pos)) {
+		p = boot_arena.pos;
+		boot_arena.pos += pl_align_size(size, ARENA_ALIGN);
+		boot_arena.pos = min(boot_arena.pos, boot_arena.end);
+	}
+	pl_port_exit_critical();
+
+	return p;
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_contains
+ *
+ * Description:
+ *   Check whether memory is in the boot arena.
+ *
+ * Parameters:
+ *  @p: memory address.
+ *
+ * Return:
+ *  true if p is in the arena.
+ ************************************************************************************/
+bool pl_arena_contains(const void *p)
+{
+	return (const uchar_t *)p >= boot_arena.start &&
+	       (const uchar_t *)p < boot_arena.end;
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_get_used_bytes
+ *
+ * Description:
+ *   Get the bytes allocated from the boot arena.
+ *
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  used bytes of arena.
+ ************************************************************************************/
+size_t pl_arena_get_used_bytes(void)
+{
+	return (size_t)(boot_arena.pos - boot_arena.start);
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_get_size
+ *
+ * Description:
+ *   Get the size of the boot arena.
+ *
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  size of arena.
+ ************************************************************************************/
+size_t pl_arena_get_size(void)
+{
+	return (size_t)(boot_arena.end - boot_arena.start);
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_boot_begin
+ *
+ * Description:
+ *   Begin the boot stage, the system tasks are created in the arena.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_boot_begin(void)
+{
+	boot_arena.state = ARENA_STATE_BOOT;
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_boot_end
+ *
+ * Description:
+ *   End the boot stage and report the usage of arena, the tasks created after it
+ *   are allocated from the memory pool.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_boot_end(void)
+{
+	pl_port_enter_critical();
+	if (boot_arena.state == ARENA_STATE_BOOT)
+		boot_arena.state = ARENA_STATE_OPEN;
+	pl_port_exit_critical();
+
+	pl_syslog_info("boot arena: %u of %u bytes used\r\n",
+	               (u32_t)pl_arena_get_used_bytes(), (u32_t)pl_arena_get_size());
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_seal
+ *
+ * Description:
+ *   Seal the boot arena, no memory can be allocated from it any more.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_seal(void)
+{
+	pl_port_enter_critical();
+	boot_arena.state = ARENA_STATE_SEALED;
+	pl_port_exit_critical();
+}
+
+/*************************************************************************************
+ * Function Name: pl_arena_is_booting
+ *
+ * Description:
+ *   Check whether the system is in the boot stage.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   true in the boot stage.
+ ************************************************************************************/
+bool pl_arena_is_booting(void)
+{
+	return boot_arena.state == ARENA_STATE_BOOT;
+}
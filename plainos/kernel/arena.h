@@ -0,0 +1,102 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_INTERNAL_ARENA_H__
+#define __KERNEL_INTERNAL_ARENA_H__
+
+#include <types.h>
+#include <stddef.h>
+
+/*************************************************************************************
+ * Function Name: pl_arena_init
+ *
+ * Description:
+ *   Initialize the boot arena on a memory block.
+ *
+ * Parameters:
+ *   @pool: memory block of arena.
+ *   @size: size of memory block.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_init(void *pool, size_t size);
+
+/*************************************************************************************
+ * Function Name: pl_arena_boot_begin
+ *
+ * Description:
+ *   Begin the boot stage, the system tasks are created in the arena.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_boot_begin(void);
+
+/*************************************************************************************
+ * Function Name: pl_arena_boot_end
+ *
+ * Description:
+ *   End the boot stage and report the usage of arena, the tasks created after it
+ *   are allocated from the memory pool.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_boot_end(void);
+
+/*************************************************************************************
+ * Function Name: pl_arena_seal
+ *
+ * Description:
+ *   Seal the boot arena, no memory can be allocated from it any more.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_arena_seal(void);
+
+/*************************************************************************************
+ * Function Name: pl_arena_is_booting
+ *
+ * Description:
+ *   Check whether the system is in the boot stage.
+ *
+ * Parameters:
+ *   none.
+ *
+ * Return:
+ *   true in the boot stage.
+ ************************************************************************************/
+bool pl_arena_is_booting(void);
+
+#endif /* __KERNEL_INTERNAL_ARENA_H__ */
@@ -26,6 +26,9 @@ SOFTWARE.
 #include <kernel/initcall.h>
 #include <kernel/assert.h>
 #include "initcall.h"
+#ifdef CONFIG_PL_BOOT_ARENA
+#include "arena.h"
+#endif
 
 extern initcall_t __early_initcall_start[];
 extern initcall_t __early_initcall_end[];
@@ -115,7 +118,8 @@ void pl_do_early_initcalls(void)
  * Function Name: pl_do_initcalls
  *
  * Description:
- *   The function is used to call initcalls.
+ *   The function is used to call initcalls. With the boot arena, the system tasks
+ *   created before the late initcalls are put in the arena.
  *
  * Parameters:
  *   none.
@@ -128,9 +132,21 @@ void pl_do_initcalls(void)
 	int ret;
 	initcall_t **init_fns;
 
+#ifdef CONFIG_PL_BOOT_ARENA
+	pl_arena_boot_begin();
+#endif
 	for (init_fns = &initcall_levels[0]; init_fns < &initcall_levels[10];
 	     init_fns++) {
+#ifdef CONFIG_PL_BOOT_ARENA
+		/* late initcalls start apps and tests, their tasks may exit */
+		if (init_fns == &initcall_levels[9])
+			pl_arena_boot_end();
+#endif
 		ret = call_initcall_level(*init_fns, *(init_fns + 1));
 		pl_assert(ret >= 0);
 	}
+
+#ifdef CONFIG_PL_BOOT_ARENA_SEAL
+	pl_arena_seal();
+#endif
 }
@@ -0,0 +1,263 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <errno.h>
+#include <types.h>
+#include <config.h>
+#include <port/port.h>
+#include <kernel/list.h>
+#include <kernel/task.h>
+#include <kernel/irq.h>
+#include "task.h"
+
+/*************************************************************************************
+ * Description: list head of the requested interrupts.
+ ************************************************************************************/
+static LIST_HEAD(pl_irq_desc_list);
+
+/*************************************************************************************
+ * Function Name: irq_thread
+ *
+ * Description:
+ *   the task of threaded handler.
+ *
+ * Parameters:
+ *  @argc: count of argv.
+ *  @argv: interrupt description.
+ *
+ * Return:
+ *  never return.
+ ************************************************************************************/
+static int irq_thread(int argc, char *argv[])
+{
+	u32_t latency;
+	struct pl_irq_desc *desc = (struct pl_irq_desc *)argv;
+
+	USED(argc);
+
+	while (true) {
+		pl_task_notify_wait();
+
+		latency = pl_port_cpu_cycles() - desc->wake_cycles;
+		if (latency > desc->stats.thread_max_latency)
+			desc->stats.thread_max_latency = latency;
+
+		++desc->stats.thread_count;
+		desc->thread_fun(desc);
+	}
+
+	return 0;
+}
+
+/*************************************************************************************
+ * Function Name: pl_irq_request_threaded
+ *
+ * Description:
+ *   request a threaded interrupt.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *  @irq: interrupt number.
+ *  @name: name of the interrupt.
+ *  @handler: top half, it must not be NULL.
+ *  @thread_fun: threaded handler.
+ *  @prio: priority of the interrupt thread.
+ *  @priv_data: private data.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_irq_request_threaded(struct pl_irq_desc *desc, u16_t irq, const char *name,
+                            pl_irq_handler_t handler, pl_irq_thread_fun_t thread_fun,
+                            u16_t prio, void *priv_data)
+{
+	if (desc == NULL || handler == NULL)
+		return -EFAULT;
+
+	desc->name = (name == NULL) ? "anonymous irq" : name;
+	desc->irq = irq;
+	desc->prio = prio;
+	desc->handler = handler;
+	desc->thread_fun = thread_fun;
+	desc->priv_data = priv_data;
+	desc->thread = NULL;
+	desc->wake_cycles = 0;
+	desc->stats.count = 0;
+	desc->stats.thread_count = 0;
+	desc->stats.top_max_cycles = 0;
+	desc->stats.thread_max_latency = 0;
+	list_init(&desc->node);
+
+	if (thread_fun != NULL) {
+		desc->thread = pl_task_sys_create(desc->name, irq_thread, prio,
+		                                  CONFIG_PL_IRQ_THREAD_STACK_SIZE,
+		                                  1, (char **)desc);
+		if (desc->thread == NULL)
+			return -ENOMEM;
+	}
+
+	pl_port_enter_critical();
+	list_add_node_at_tail(&pl_irq_desc_list, &desc->node);
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_irq_free
+ *
+ * Description:
+ *   free a threaded interrupt.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_irq_free(struct pl_irq_desc *desc)
+{
+	int ret;
+
+	if (desc == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	list_del_node(&desc->node);
+	list_init(&desc->node);
+	pl_port_exit_critical();
+
+	if (desc->thread == NULL)
+		return OK;
+
+	ret = pl_task_kill(desc->thread);
+	desc->thread = NULL;
+	return ret;
+}
+
+/*************************************************************************************
+ * Function Name: pl_irq_callee_handle
+ *
+ * Description:
+ *   the entry of the threaded interrupt.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *
+ * Return:
+ *  return value of the top half, PL_IRQ_NONE if it is not requested yet.
+ ************************************************************************************/
+int pl_irq_callee_handle(struct pl_irq_desc *desc)
+{
+	int ret;
+	u32_t start;
+	u32_t cycles;
+
+	if (desc == NULL)
+		return PL_IRQ_NONE;
+
+	start = pl_port_cpu_cycles();
+	ret = (desc->handler == NULL) ? PL_IRQ_NONE : desc->handler(desc);
+	if (ret == PL_IRQ_WAKE_THREAD && desc->thread != NULL) {
+		desc->wake_cycles = pl_port_cpu_cycles();
+		pl_task_notify(desc->thread);
+	}
+
+	cycles = pl_port_cpu_cycles() - start;
+	if (cycles > desc->stats.top_max_cycles)
+		desc->stats.top_max_cycles = cycles;
+
+	++desc->stats.count;
+	return ret;
+}
+
+/*************************************************************************************
+ * Function Name: pl_irq_get_private_data
+ *
+ * Description:
+ *   get the private data of interrupt.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *
+ * Return:
+ *   private data of the interrupt.
+ ************************************************************************************/
+void *pl_irq_get_private_data(struct pl_irq_desc *desc)
+{
+	if (desc == NULL)
+		return NULL;
+
+	return desc->priv_data;
+}
+
+/*************************************************************************************
+ * Function Name: pl_irq_get_stats
+ *
+ * Description:
+ *   get the statistics of interrupt.
+ *
+ * Parameters:
+ *  @desc: interrupt description.
+ *  @stats: statistics wanted to get.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_irq_get_stats(struct pl_irq_desc *desc, struct pl_irq_stats *stats)
+{
+	if (desc == NULL || stats == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	*stats = desc->stats;
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_irq_next_desc
+ *
+ * Description:
+ *   iterate the requested interrupts.
+ *
+ * Parameters:
+ *  @desc: current interrupt description, NULL to get the first one.
+ *
+ * Return:
+ *   next interrupt description, NULL if there is no more.
+ ************************************************************************************/
+struct pl_irq_desc *pl_irq_next_desc(struct pl_irq_desc *desc)
+{
+	struct list_node *next;
+
+	pl_port_enter_critical();
+	next = (desc == NULL) ? pl_irq_desc_list.next : desc->node.next;
+	pl_port_exit_critical();
+
+	if (next == &pl_irq_desc_list)
+		return NULL;
+
+	return container_of(next, struct pl_irq_desc, node);
+}
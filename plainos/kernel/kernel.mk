@@ -30,13 +30,31 @@ C_SRCS += $(KERNEL_DIR)/idletask.c
 C_SRCS += $(KERNEL_DIR)/initcall.c
 C_SRCS += $(KERNEL_DIR)/list.c
 C_SRCS += $(KERNEL_DIR)/mempool.c
+C_SRCS += $(KERNEL_DIR)/kmem_cache.c
 C_SRCS += $(KERNEL_DIR)/syslog.c
 C_SRCS += $(KERNEL_DIR)/task.c
 C_SRCS += $(KERNEL_DIR)/semaphore.c
 C_SRCS += $(KERNEL_DIR)/softtimer.c
+C_SRCS += $(KERNEL_DIR)/timer_wheel.c
 C_SRCS += $(KERNEL_DIR)/kfifo.c
 C_SRCS += $(KERNEL_DIR)/workqueue.c
+C_SRCS += $(KERNEL_DIR)/tasklet.c
+C_SRCS += $(KERNEL_DIR)/irq.c
 C_SRCS += $(KERNEL_DIR)/completion.c
+C_SRCS += $(KERNEL_DIR)/pipe.c
+C_SRCS += $(KERNEL_DIR)/mpsc.c
+
+ifeq ($(PL_MEMPOOL_TLSF), y)
+C_SRCS += $(KERNEL_DIR)/mempool_tlsf.c
+endif
+
+ifeq ($(PL_MEMPOOL_REGIONS), y)
+C_SRCS += $(KERNEL_DIR)/mempool_region.c
+endif
+
+ifeq ($(PL_BOOT_ARENA), y)
+C_SRCS += $(KERNEL_DIR)/arena.c
+endif
 
 ifeq ($(PL_SHELL_SUPPORT), y)
 C_SRCS += $(KERNEL_DIR)/shell.c
@@ -23,11 +23,12 @@ SOFTWARE.
 
 #include <errno.h>
 #include <types.h>
-#include <string.h>
+#include <lib/string.h>
 #include <port/port.h>
 #include <kernel/kernel.h>
 #include <kernel/mempool.h>
 #include <kernel/kfifo.h>
+#include <kernel/ring.h>
 
 /*************************************************************************************
  * Function Name: pl_kfifo_init
@@ -74,7 +75,8 @@ struct pl_kfifo *pl_kfifo_request(uint_t buff_size)
 	if (!pl_is_power_of_2(buff_size))
 		return NULL;
 
-	kfifo = pl_mempool_malloc(g_pl_default_mempool, sizeof(struct pl_kfifo) + buff_size);
+	kfifo = pl_mempool_alloc_sized(g_pl_default_mempool,
+	                               sizeof(struct pl_kfifo) + buff_size);
 	if (kfifo == NULL)
 		return NULL;
 
@@ -98,14 +100,18 @@ struct pl_kfifo *pl_kfifo_request(uint_t buff_size)
  ************************************************************************************/
 void pl_kfifo_destroy(struct pl_kfifo *kfifo)
 {
+	uint_t buff_size;
+
 	if (kfifo == NULL)
 		return;
 
+	buff_size = kfifo->size;
 	kfifo->in = 0;
 	kfifo->out = 0;
 	kfifo->size = 0;
 	kfifo->buff = NULL;
-	pl_mempool_free(g_pl_default_mempool, kfifo);
+	pl_mempool_free_sized(g_pl_default_mempool, kfifo,
+	                      sizeof(struct pl_kfifo) + buff_size);
 }
 
 /*************************************************************************************
@@ -123,7 +129,56 @@ uint_t pl_kfifo_len(struct pl_kfifo *kfifo)
 	if (kfifo == NULL)
 		return 0;
 
-	return (kfifo->in - kfifo->out);
+	return pl_ring_idx_len(kfifo->in, kfifo->out);
+}
+
+/*************************************************************************************
+ * Function Name: kfifo_copy_out
+ * Description: copy data out of the kfifo buffer from an index.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @idx: index of data.
+ *   @data: buffer to fill.
+ *   @size: length of data.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void kfifo_copy_out(struct pl_kfifo *kfifo, uint_t idx, char *data, uint_t size)
+{
+	uint_t len;
+
+	/* first get the data from idx until the end of the buffer */
+	len = pl_ring_idx_contig(idx, kfifo->size, size);
+	pl_memcpy(data, kfifo->buff + pl_ring_idx_off(idx, kfifo->size), len);
+	/* then get the rest (if any) from the beginning of the buffer */
+	pl_memcpy(data + len, kfifo->buff, size - len);
+}
+
+/*************************************************************************************
+ * Function Name: kfifo_copy_in
+ * Description: copy data into the kfifo buffer from an index.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @idx: index of data.
+ *   @data: data to copy.
+ *   @size: length of data.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void kfifo_copy_in(struct pl_kfifo *kfifo, uint_t idx, const char *data,
+                          uint_t size)
+{
+	uint_t len;
+
+	/* first put the data starting from idx to buffer end */
+	len = pl_ring_idx_contig(idx, kfifo->size, size);
+	pl_memcpy(kfifo->buff + pl_ring_idx_off(idx, kfifo->size), data, len);
+	/* then put the rest (if any) at the beginning of the buffer */
+	pl_memcpy(kfifo->buff, data + len, size - len);
 }
 
 /*************************************************************************************
@@ -140,19 +195,14 @@ uint_t pl_kfifo_len(struct pl_kfifo *kfifo)
  ************************************************************************************/
 uint_t pl_kfifo_get(struct pl_kfifo *kfifo, char *data, uint_t data_len)
 {
-	uint_t len;
 	uint_t size;
 
 	if (kfifo == NULL || pl_kfifo_len(kfifo) == 0)
 		return 0;
 
-	size = min(data_len, kfifo->in - kfifo->out);
+	size = min(data_len, pl_ring_idx_len(kfifo->in, kfifo->out));
 	pl_port_cpu_dmb();
-	/* first get the data from fifo->out until the end of the buffer */
-	len = min(size, kfifo->size - (kfifo->out & (kfifo->size - 1)));
-	memcpy(data, kfifo->buff + (kfifo->out & (kfifo->size - 1)), len);
-	/* then get the rest (if any) from the beginning of the buffer */
-	memcpy(data + len, kfifo->buff, size - len);
+	kfifo_copy_out(kfifo, kfifo->out, data, size);
 
 	pl_port_cpu_dmb();
 	kfifo->out += size;
@@ -174,22 +224,315 @@ uint_t pl_kfifo_get(struct pl_kfifo *kfifo, char *data, uint_t data_len)
  ************************************************************************************/
 uint_t pl_kfifo_put(struct pl_kfifo *kfifo, char *data, uint_t data_len)
 {
-	uint_t len;
 	uint_t size;
 
 	if (kfifo == NULL || pl_kfifo_len(kfifo) >= kfifo->size)
 		return 0;
 
-	size = min(data_len, kfifo->size - kfifo->in + kfifo->out);
+	size = min(data_len, pl_ring_idx_avail(kfifo->in, kfifo->out, kfifo->size));
 	pl_port_cpu_dmb();
-	/* first put the data starting from fifo->in to buffer end */
-	len  = min(size, kfifo->size - (kfifo->in & (kfifo->size - 1)));
-	memcpy(kfifo->buff + (kfifo->in & (kfifo->size - 1)), data, len);
-	/* then put the rest (if any) at the beginning of the buffer */
-	memcpy(kfifo->buff, data + len, size - len);
+	kfifo_copy_in(kfifo, kfifo->in, data, size);
 
 	pl_port_cpu_dmb();
 	kfifo->in += size;
 
 	return size;
 }
+
+/*************************************************************************************
+ * Function Name: kfifo_spans
+ * Description: split a range of kfifo buffer into two spans.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @idx: index of the range.
+ *   @size: length of the range.
+ *   @iov: two spans.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void kfifo_spans(struct pl_kfifo *kfifo, uint_t idx, uint_t size,
+                        struct pl_kfifo_iovec iov[2])
+{
+	uint_t off = pl_ring_idx_off(idx, kfifo->size);
+
+	iov[0].base = kfifo->buff + off;
+	iov[0].len = min(size, kfifo->size - off);
+	iov[1].base = kfifo->buff;
+	iov[1].len = size - iov[0].len;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_reserve_iov
+ * Description: get all the free space of kfifo as two spans.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @iov: two spans.
+ *
+ * Return:
+ *   The length of free space.
+ ************************************************************************************/
+uint_t pl_kfifo_reserve_iov(struct pl_kfifo *kfifo, struct pl_kfifo_iovec iov[2])
+{
+	uint_t size;
+
+	if (kfifo == NULL || iov == NULL)
+		return 0;
+
+	size = pl_ring_idx_avail(kfifo->in, kfifo->out, kfifo->size);
+	/* the consumer has read the space before it is written, as pl_kfifo_put() */
+	pl_port_cpu_dmb();
+	kfifo_spans(kfifo, kfifo->in, size, iov);
+	return size;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_reserve
+ * Description: get the largest contiguous free span at the in index.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @buff: start of span.
+ *
+ * Return:
+ *   The length of span, 0 if the kfifo is full.
+ ************************************************************************************/
+uint_t pl_kfifo_reserve(struct pl_kfifo *kfifo, char **buff)
+{
+	struct pl_kfifo_iovec iov[2];
+
+	if (buff == NULL || pl_kfifo_reserve_iov(kfifo, iov) == 0)
+		return 0;
+
+	*buff = iov[0].base;
+	return iov[0].len;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_commit
+ * Description: publish the data written into the reserved spans.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @len: length of data written.
+ *
+ * Return:
+ *   The length of data committed.
+ ************************************************************************************/
+uint_t pl_kfifo_commit(struct pl_kfifo *kfifo, uint_t len)
+{
+	if (kfifo == NULL)
+		return 0;
+
+	len = min(len, pl_ring_idx_avail(kfifo->in, kfifo->out, kfifo->size));
+	/* the data is written before it is seen by the consumer */
+	pl_port_cpu_dmb();
+	kfifo->in += len;
+	return len;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_peek_iov
+ * Description: get all the data of kfifo as two spans.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @iov: two spans.
+ *
+ * Return:
+ *   The length of data.
+ ************************************************************************************/
+uint_t pl_kfifo_peek_iov(struct pl_kfifo *kfifo, struct pl_kfifo_iovec iov[2])
+{
+	uint_t size;
+
+	if (kfifo == NULL || iov == NULL)
+		return 0;
+
+	size = pl_ring_idx_len(kfifo->in, kfifo->out);
+	/* the data is read after the in index, as pl_kfifo_get() */
+	pl_port_cpu_dmb();
+	kfifo_spans(kfifo, kfifo->out, size, iov);
+	return size;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_peek
+ * Description: get the largest contiguous span of data at the out index.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @buff: start of span.
+ *
+ * Return:
+ *   The length of span, 0 if the kfifo is empty.
+ ************************************************************************************/
+uint_t pl_kfifo_peek(struct pl_kfifo *kfifo, char **buff)
+{
+	struct pl_kfifo_iovec iov[2];
+
+	if (buff == NULL || pl_kfifo_peek_iov(kfifo, iov) == 0)
+		return 0;
+
+	*buff = iov[0].base;
+	return iov[0].len;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_consume
+ * Description: release the data read from the peeked spans.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @len: length of data read.
+ *
+ * Return:
+ *   The length of data consumed.
+ ************************************************************************************/
+uint_t pl_kfifo_consume(struct pl_kfifo *kfifo, uint_t len)
+{
+	if (kfifo == NULL)
+		return 0;
+
+	len = min(len, pl_ring_idx_len(kfifo->in, kfifo->out));
+	/* the data is read before the space is given back to the producer */
+	pl_port_cpu_dmb();
+	kfifo->out += len;
+	return len;
+}
+
+/*************************************************************************************
+ * Function Name: kfifo_rec_len
+ * Description: read the length of the first record.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *
+ * Return:
+ *   The length of record, 0 if the kfifo has no record.
+ ************************************************************************************/
+static uint_t kfifo_rec_len(struct pl_kfifo *kfifo)
+{
+	if (pl_ring_idx_len(kfifo->in, kfifo->out) < PL_KFIFO_REC_HDR_SIZE)
+		return 0;
+
+	/* the record is read after the in index, the header may wrap */
+	pl_port_cpu_dmb();
+	return (uint_t)(u8_t)kfifo->buff[pl_ring_idx_off(kfifo->out, kfifo->size)] |
+	       ((uint_t)(u8_t)kfifo->buff[pl_ring_idx_off(kfifo->out + 1, kfifo->size)] << 8);
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_put
+ * Description: put a record to the kfifo.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @data: data of record.
+ *   @data_len: length of record.
+ *
+ * Return:
+ *   data_len on success, 0 if the record does not fit.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_put(struct pl_kfifo *kfifo, const char *data, uint_t data_len)
+{
+	uint_t free_len;
+
+	if (kfifo == NULL || data == NULL || data_len == 0 ||
+	    data_len > PL_KFIFO_REC_MAX_LEN)
+		return 0;
+
+	free_len = pl_ring_idx_avail(kfifo->in, kfifo->out, kfifo->size);
+	if (free_len < PL_KFIFO_REC_HDR_SIZE ||
+	    data_len > free_len - PL_KFIFO_REC_HDR_SIZE)
+		return 0;
+
+	pl_port_cpu_dmb();
+	kfifo->buff[pl_ring_idx_off(kfifo->in, kfifo->size)] = (char)data_len;
+	kfifo->buff[pl_ring_idx_off(kfifo->in + 1, kfifo->size)] = (char)(data_len >> 8);
+	kfifo_copy_in(kfifo, kfifo->in + PL_KFIFO_REC_HDR_SIZE, data, data_len);
+
+	/* the whole record is seen by the consumer at once */
+	pl_port_cpu_dmb();
+	kfifo->in += data_len + PL_KFIFO_REC_HDR_SIZE;
+
+	return data_len;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_get
+ * Description: get a record from the kfifo.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *   @data: buffer of record.
+ *   @data_len: length of buffer.
+ *
+ * Return:
+ *   The length of record, 0 if there is no record or the buffer is too small.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_get(struct pl_kfifo *kfifo, char *data, uint_t data_len)
+{
+	uint_t len;
+
+	if (kfifo == NULL || data == NULL)
+		return 0;
+
+	len = kfifo_rec_len(kfifo);
+	if (len == 0 || len > data_len)
+		return 0;
+
+	kfifo_copy_out(kfifo, kfifo->out + PL_KFIFO_REC_HDR_SIZE, data, len);
+
+	pl_port_cpu_dmb();
+	kfifo->out += len + PL_KFIFO_REC_HDR_SIZE;
+
+	return len;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_peek_len
+ * Description: get the length of the first record.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *
+ * Return:
+ *   The length of record, 0 if the kfifo has no record.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_peek_len(struct pl_kfifo *kfifo)
+{
+	if (kfifo == NULL)
+		return 0;
+
+	return kfifo_rec_len(kfifo);
+}
+
+/*************************************************************************************
+ * Function Name: pl_kfifo_rec_skip
+ * Description: drop the first record.
+ *
+ * Param:
+ *   @fifo: kfifo handle.
+ *
+ * Return:
+ *   The length of record dropped, 0 if the kfifo has no record.
+ ************************************************************************************/
+uint_t pl_kfifo_rec_skip(struct pl_kfifo *kfifo)
+{
+	uint_t len;
+
+	if (kfifo == NULL)
+		return 0;
+
+	len = kfifo_rec_len(kfifo);
+	if (len == 0)
+		return 0;
+
+	pl_port_cpu_dmb();
+	kfifo->out += len + PL_KFIFO_REC_HDR_SIZE;
+
+	return len;
+}
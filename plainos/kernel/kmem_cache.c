@@ -0,0 +1,214 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <errno.h>
+#include <types.h>
+#include <port/port.h>
+#include <kernel/kernel.h>
+#include <kernel/list.h>
+#include <kernel/mempool.h>
+#include <kernel/kmem_cache.h>
+
+#define KMEM_CACHE_DEFAULT_OBJS          (8)
+#define KMEM_CACHE_ALIGN                 (sizeof(uintptr_t) << 1)
+
+/*************************************************************************************
+ * Description: slab of cache, the objects follow the header.
+ ************************************************************************************/
+struct kmem_slab {
+	struct list_node node;
+};
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_create
+ *
+ * Description:
+ *   Create a cache of fixed-size objects, the objects have no header, slabs are
+ *   carved from mempool when the cache is empty.
+ *
+ * Parameters:
+ *  @name: name of cache.
+ *  @obj_size: size of object.
+ *  @objs_per_slab: the number of objects in a slab, 0 for default.
+ *  @mempool: memory pool which the cache and slabs are allocated from.
+ *
+ * Return:
+ *  handle of cache, NULL on failure.
+ ************************************************************************************/
+struct pl_kmem_cache *pl_kmem_cache_create(const char *name, size_t obj_size,
+                                           u16_t objs_per_slab,
+                                           pl_mempool_handle_t mempool)
+{
+	struct pl_kmem_cache *cache;
+
+	if (obj_size == 0 || mempool == NULL)
+		return NULL;
+
+	cache = pl_mempool_alloc_sized(mempool, sizeof(struct pl_kmem_cache));
+	if (cache == NULL)
+		return NULL;
+
+	/* the free object holds the link of free list */
+	obj_size = max(obj_size, sizeof(void *));
+	cache->name = name;
+	cache->mempool = mempool;
+	cache->free_list = NULL;
+	cache->obj_size = pl_align_size(obj_size, KMEM_CACHE_ALIGN);
+	cache->objs_per_slab = objs_per_slab ? objs_per_slab : KMEM_CACHE_DEFAULT_OBJS;
+	cache->slab_size = pl_align_size(sizeof(struct kmem_slab), KMEM_CACHE_ALIGN) +
+	                   cache->obj_size * cache->objs_per_slab;
+	cache->nr_slabs = 0;
+	cache->nr_active = 0;
+	list_init(&cache->slabs);
+
+	return cache;
+}
+
+/*************************************************************************************
+ * Function Name: kmem_cache_grow
+ *
+ * Description:
+ *   Allocate a slab and put its objects except the first one to free list.
+ *
+ * Parameters:
+ *  @cache: handle of cache.
+ *
+ * Return:
+ *  the first object of slab, NULL if there is no memory.
+ ************************************************************************************/
+static void *kmem_cache_grow(struct pl_kmem_cache *cache)
+{
+	u16_t i;
+	u8_t *obj;
+	struct kmem_slab *slab;
+
+	/* the mempool may wait semaphore, allocate out of critical section */
+	slab = pl_mempool_alloc_sized(cache->mempool, cache->slab_size);
+	if (slab == NULL)
+		return NULL;
+
+	obj = (u8_t *)slab + pl_align_size(sizeof(struct kmem_slab), KMEM_CACHE_ALIGN);
+
+	pl_port_enter_critical();
+	list_add_node_at_tail(&cache->slabs, &slab->node);
+	for (i = cache->objs_per_slab - 1; i > 0; i--) {
+		*(void **)(obj + i * cache->obj_size) = cache->free_list;
+		cache->free_list = obj + i * cache->obj_size;
+	}
+
+	cache->nr_slabs++;
+	cache->nr_active++;
+	pl_port_exit_critical();
+
+	return obj;
+}
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_alloc
+ *
+ * Description:
+ *   Allocate an object from cache.
+ *
+ * Parameters:
+ *  @cache: handle of cache.
+ *
+ * Return:
+ *  address of object, NULL on failure.
+ ************************************************************************************/
+void *pl_kmem_cache_alloc(struct pl_kmem_cache *cache)
+{
+	void *obj;
+
+	if (cache == NULL)
+		return NULL;
+
+	pl_port_enter_critical();
+	obj = cache->free_list;
+	if (obj != NULL) {
+		cache->free_list = *(void **)obj;
+		cache->nr_active++;
+	}
+	pl_port_exit_critical();
+
+	if (obj != NULL)
+		return obj;
+
+	return kmem_cache_grow(cache);
+}
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_free
+ *
+ * Description:
+ *   Free an object to cache, the object must be allocated from the cache.
+ *
+ * Parameters:
+ *  @cache: handle of cache.
+ *  @obj: address of object.
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+void pl_kmem_cache_free(struct pl_kmem_cache *cache, void *obj)
+{
+	if (cache == NULL || obj == NULL)
+		return;
+
+	pl_port_enter_critical();
+	*(void **)obj = cache->free_list;
+	cache->free_list = obj;
+	cache->nr_active--;
+	pl_port_exit_critical();
+}
+
+/*************************************************************************************
+ * Function Name: pl_kmem_cache_destroy
+ *
+ * Description:
+ *   Destroy cache, all slabs are freed to memory pool.
+ *
+ * Parameters:
+ *  @cache: handle of cache.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, -EBUSY if some objects are in use.
+ ************************************************************************************/
+int pl_kmem_cache_destroy(struct pl_kmem_cache *cache)
+{
+	struct kmem_slab *pos;
+	struct kmem_slab *tmp;
+
+	if (cache == NULL)
+		return -EFAULT;
+
+	if (cache->nr_active != 0)
+		return -EBUSY;
+
+	list_for_each_entry_safe(pos, tmp, &cache->slabs, struct kmem_slab, node) {
+		list_del_node(&pos->node);
+		pl_mempool_free_sized(cache->mempool, pos, cache->slab_size);
+	}
+
+	pl_mempool_free_sized(cache->mempool, cache, sizeof(struct pl_kmem_cache));
+	return OK;
+}
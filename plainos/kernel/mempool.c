@@ -24,13 +24,29 @@ SOFTWARE.
 #include <config.h>
 #include <types.h>
 #include <errno.h>
+#include <lib/string.h>
 #include <kernel/kernel.h>
+#include <kernel/bitops.h>
 #include <kernel/mempool.h>
 #include <kernel/assert.h>
 #include <kernel/semaphore.h>
+#include <port/port.h>
 #include <kernel/initcall.h>
 #include <kernel/syslog.h>
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+#include "task.h"
+#endif
+#ifdef CONFIG_PL_BOOT_ARENA
+#include "arena.h"
+#endif
 
+/*************************************************************************************
+ * Description: default memory pool, the boot arena takes the front of it.
+ ************************************************************************************/
+static u8_t pl_default_mempool_data[CONFIG_PL_DEFAULT_MEMPOOL_SIZE];
+pl_mempool_handle_t g_pl_default_mempool;
+
+#ifndef CONFIG_PL_MEMPOOL_TLSF
 /*************************************************************************************
  * Description: mempool structure definition.
  ************************************************************************************/
@@ -38,36 +54,74 @@ struct mempool {
 	ushrt_t id;
 	uchar_t state;
 	uchar_t grain_order;
+	uchar_t lock;
 	size_t blk_num;
 	uintptr_t *blk_bitmaps;
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	uintptr_t *blk_heads;
+#endif
 	uchar_t *blk_first_bits;
 	uchar_t *blk_max_bits;
 	size_t data_pool_size;
 	uchar_t *data_pool;
+	size_t used_bytes;
+	size_t peak_used;
+	size_t nr_allocs;
+	size_t nr_fails;
+	struct pl_sem sem;
 };
 
+/*************************************************************************************
+ * Description: header of memory, every allocation except pl_mempool_alloc_sized()
+ *              has a header at its first grain, the memory of memalign has a copy
+ *              of it before the payload. With owners, the first grains of headers
+ *              are marked in blk_heads, so the walk skips the memory without header.
+ ************************************************************************************/
 struct mempool_data {
 	size_t bit_idx;
 	size_t bit_num;
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	void *owner;
+#endif
 	uchar_t *data[0];
 };
 
-struct default_mempool {
-	struct pl_sem sem;
-	u8_t pool_data[CONFIG_PL_DEFAULT_MEMPOOL_SIZE];
+#ifdef CONFIG_PL_MEMPOOL_INDEX
+/*************************************************************************************
+ * Description: summary index of blocks.
+ *
+ * The index is a complete binary tree whose leaves are the blocks, node 1 is the
+ * root and the children of node i are 2i and 2i+1. Only the internal nodes are
+ * stored (after blk_max_bits), the leaf (leaves + blk_idx) is read from the block
+ * arrays, the leaves after blk_num are empty. For each node:
+ *   pre: number of free grains from bit 0 of the first block of node.
+ *   suf: number of fully free blocks at the end of node.
+ *   best: longest free run starting at bit 0 of a block inside node.
+ *   mbits: max blk_max_bits inside node.
+ ************************************************************************************/
+struct mempool_index {
+	size_t leaves;
+	size_t *pre;
+	size_t *suf;
+	size_t *best;
+	uchar_t *mbits;
+};
+
+struct mempool_sum {
+	size_t pre;
+	size_t suf;
+	size_t best;
+	uchar_t mbits;
 };
+#endif
 
 /*************************************************************************************
  * Description: definitions.
  ************************************************************************************/
+#ifndef CONFIG_PL_MEMPOOL_INDEX
 typedef bool (*find_bit_condition_t)(struct mempool* mp, size_t iter,
                                      size_t alloc_size, size_t* arg);
-
-/*************************************************************************************
- * Description: default memory pool.
- ************************************************************************************/
-static struct default_mempool pl_default_mempool;
-pl_mempool_handle_t g_pl_default_mempool;
+#endif
 
 /*************************************************************************************
  * Function Name: calculate_min_pool_size
@@ -92,6 +146,14 @@ static size_t calculate_min_pool_size(uchar_t grain_order)
 	min_pool_size += sizeof(struct mempool);
 	/* add ctrl_blk_size */
 	min_pool_size += sizeof(uintptr_t) + (sizeof(uchar_t) << 1);
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	/* add heads of one block */
+	min_pool_size += sizeof(uintptr_t);
+#endif
+#ifdef CONFIG_PL_MEMPOOL_INDEX
+	/* add index_size of one block */
+	min_pool_size += sizeof(size_t) * 4 + sizeof(uchar_t);
+#endif
 	/* add gap_size (4 * sizeof(uintptr_t)) */
 	min_pool_size += sizeof(uintptr_t) << 2;
 	/* add data_size */
@@ -124,6 +186,9 @@ static size_t calculate_blk_num(uchar_t grain_order, size_t pool_size)
 	gap_size = sizeof(uintptr_t) << 2;
 	/* add ctrl_blk_size and data_size */
 	blk_size = sizeof(uintptr_t) + (sizeof(uchar_t) << 1);
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	blk_size += sizeof(uintptr_t);
+#endif
 	blk_size += ((size_t)1 << grain_order) * UINTPTR_T_BITS;
 	/* calculate body_size */
 	pool_size -= sizeof(struct mempool);
@@ -132,6 +197,239 @@ static size_t calculate_blk_num(uchar_t grain_order, size_t pool_size)
 	return blk_num;
 }
 
+#ifdef CONFIG_PL_MEMPOOL_INDEX
+/*************************************************************************************
+ * Function Name: mempool_index_leaves
+ *
+ * Description:
+ *    Calculate the number of leaves of index, it is power of 2.
+ *
+ * Param:
+ *   @blk_num: the number of blocks.
+ *
+ * Return:
+ *   The number of leaves.
+ ************************************************************************************/
+static size_t mempool_index_leaves(size_t blk_num)
+{
+	size_t leaves = 1;
+
+	while (leaves < blk_num)
+		leaves <<= 1;
+
+	return leaves;
+}
+
+/*************************************************************************************
+ * Function Name: mempool_get_index
+ *
+ * Description:
+ *    Get the index of memory pool, it is placed after blk_max_bits.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *   @idx: index of memory pool.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_get_index(struct mempool *mp, struct mempool_index *idx)
+{
+	idx->leaves = mempool_index_leaves(mp->blk_num);
+	idx->pre = (size_t *)pl_align_address(mp->blk_max_bits + mp->blk_num,
+	                                      sizeof(size_t));
+	idx->suf = idx->pre + idx->leaves;
+	idx->best = idx->suf + idx->leaves;
+	idx->mbits = (uchar_t *)(idx->best + idx->leaves);
+}
+
+/*************************************************************************************
+ * Function Name: mempool_index_get_sum
+ *
+ * Description:
+ *    Get the summary of node, the summary of leaf is calculated by block.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *   @idx: index of memory pool.
+ *   @node: node of index.
+ *   @sum: summary of node.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_index_get_sum(struct mempool *mp, struct mempool_index *idx,
+                                  size_t node, struct mempool_sum *sum)
+{
+	size_t blk_idx;
+
+	if (node < idx->leaves) {
+		sum->pre = idx->pre[node];
+		sum->suf = idx->suf[node];
+		sum->best = idx->best[node];
+		sum->mbits = idx->mbits[node];
+		return;
+	}
+
+	blk_idx = node - idx->leaves;
+	if (blk_idx >= mp->blk_num) {
+		sum->pre = 0;
+		sum->suf = 0;
+		sum->best = 0;
+		sum->mbits = 0;
+		return;
+	}
+
+	sum->pre = mp->blk_first_bits[blk_idx];
+	sum->suf = (sum->pre == UINTPTR_T_BITS) ? 1 : 0;
+	sum->best = sum->pre;
+	sum->mbits = mp->blk_max_bits[blk_idx];
+}
+
+/*************************************************************************************
+ * Function Name: mempool_index_update
+ *
+ * Description:
+ *    Update the nodes of index above the blocks [first, last], stop at the level
+ *    where no node is changed unless all is true.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *   @first: the first block changed.
+ *   @last: the last block changed.
+ *   @all: update all levels (build the index).
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_index_update(struct mempool *mp, size_t first, size_t last,
+                                 bool all)
+{
+	size_t node;
+	size_t len = 1;
+	bool changed = true;
+	struct mempool_sum l;
+	struct mempool_sum r;
+	struct mempool_sum sum;
+	struct mempool_index idx;
+
+	mempool_get_index(mp, &idx);
+	first += idx.leaves;
+	last += idx.leaves;
+
+	while (first > 1 && (changed || all)) {
+		first >>= 1;
+		last >>= 1;
+		changed = false;
+		for (node = first; node <= last; node++) {
+			mempool_index_get_sum(mp, &idx, node << 1, &l);
+			mempool_index_get_sum(mp, &idx, (node << 1) + 1, &r);
+			sum.pre = (l.pre == len * UINTPTR_T_BITS) ? l.pre + r.pre : l.pre;
+			sum.suf = (r.suf == len) ? len + l.suf : r.suf;
+			sum.best = max(l.best, r.best);
+			sum.best = max(sum.best, l.suf * UINTPTR_T_BITS + r.pre);
+			sum.mbits = max(l.mbits, r.mbits);
+			if (sum.pre == idx.pre[node] && sum.suf == idx.suf[node] &&
+			    sum.best == idx.best[node] && sum.mbits == idx.mbits[node])
+				continue;
+
+			idx.pre[node] = sum.pre;
+			idx.suf[node] = sum.suf;
+			idx.best[node] = sum.best;
+			idx.mbits[node] = sum.mbits;
+			changed = true;
+		}
+		len <<= 1;
+	}
+}
+
+/*************************************************************************************
+ * Function Name: mempool_index_find
+ *
+ * Description:
+ *    Find the first block which can hold bit_num bits by index.
+ *    If bit_num < UINTPTR_T_BITS, find the first block whose blk_max_bits is enough,
+ *    otherwise find the first free run starting at bit 0 of a block.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *   @bit_num: the number of bits.
+ *   @blk_idx: got index of block.
+ *
+ * Return:
+ *   true: got it.
+ *   false: can't find.
+ ************************************************************************************/
+static bool mempool_index_find(struct mempool *mp, size_t bit_num, size_t *blk_idx)
+{
+	size_t node = 1;
+	size_t first = 0;
+	size_t len;
+	struct mempool_sum l;
+	struct mempool_sum r;
+	struct mempool_index idx;
+
+	mempool_get_index(mp, &idx);
+	mempool_index_get_sum(mp, &idx, node, &l);
+	if ((bit_num < UINTPTR_T_BITS && l.mbits < bit_num) ||
+	    (bit_num >= UINTPTR_T_BITS && l.best < bit_num))
+		return false;
+
+	len = idx.leaves;
+	while (node < idx.leaves) {
+		len >>= 1;
+		node <<= 1;
+		mempool_index_get_sum(mp, &idx, node, &l);
+		if (bit_num < UINTPTR_T_BITS) {
+			if (l.mbits < bit_num) {
+				++node;
+				first += len;
+			}
+			continue;
+		}
+
+		if (l.best >= bit_num)
+			continue;
+
+		mempool_index_get_sum(mp, &idx, node + 1, &r);
+		if (l.suf * UINTPTR_T_BITS + r.pre >= bit_num) {
+			*blk_idx = first + len - l.suf;
+			return true;
+		}
+
+		++node;
+		first += len;
+	}
+
+	*blk_idx = first;
+	return true;
+}
+#endif
+
+/*************************************************************************************
+ * Function Name: mempool_meta_end
+ *
+ * Description:
+ *    Get the end address of control blocks (bitmaps, fbits, mbits and index).
+ *
+ * Param:
+ *   @mp: memory pool.
+ *
+ * Return:
+ *   end address of control blocks.
+ ************************************************************************************/
+static uchar_t *mempool_meta_end(struct mempool *mp)
+{
+#ifdef CONFIG_PL_MEMPOOL_INDEX
+	struct mempool_index idx;
+
+	mempool_get_index(mp, &idx);
+	return idx.mbits + idx.leaves;
+#else
+	return mp->blk_max_bits + mp->blk_num;
+#endif
+}
+
 /*************************************************************************************
  * Function Name: mempool_blk_init
  *
@@ -150,6 +448,11 @@ static void mempool_blk_init(struct mempool* mp)
 	uchar_t grain_num;
 	size_t rest_size = mp->data_pool_size;
 
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	for (i = 0; i < mp->blk_num; i++)
+		mp->blk_heads[i] = 0;
+#endif
+
 	/* initialize mempool */
 	for (i = 0; i < mp->blk_num - 1; i++) {
 		mp->blk_first_bits[i] = UINTPTR_T_BITS;
@@ -172,10 +475,54 @@ static void mempool_blk_init(struct mempool* mp)
 }
 
 /*************************************************************************************
- * Function Name: pl_mempool_init
+ * Function Name: mempool_layout
+ *
+ * Description:
+ *    Place control blocks and data pool of memory pool for blk_num blocks.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *   @blk_num: the number of blocks.
+ *   @pool_size: actual size of pool.
+ *
+ * Return:
+ *   true: the data pool can fill blk_num blocks.
+ *   false: pool_size is not enough.
+ ************************************************************************************/
+static bool mempool_layout(struct mempool *mp, size_t blk_num, size_t pool_size)
+{
+	size_t meta_size;
+	size_t blk_size = ((size_t)1 << mp->grain_order) * UINTPTR_T_BITS;
+
+	mp->blk_num = blk_num;
+	mp->blk_bitmaps = (uintptr_t*)((uchar_t *)mp + sizeof(struct mempool));
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	mp->blk_heads = mp->blk_bitmaps + blk_num;
+	mp->blk_first_bits = (uchar_t*)(mp->blk_heads + blk_num);
+#else
+	mp->blk_first_bits = (uchar_t*)(mp->blk_bitmaps + blk_num);
+#endif
+	mp->blk_max_bits = mp->blk_first_bits + blk_num;
+	mp->data_pool = mempool_meta_end(mp);
+	mp->data_pool = (uchar_t*)pl_align_address(mp->data_pool, sizeof(uintptr_t) << 2);
+	meta_size = (size_t)(mp->data_pool) - (size_t)mp;
+	if (meta_size >= pool_size)
+		return false;
+
+	mp->data_pool_size = pool_size - meta_size;
+	mp->data_pool_size &= (~(((size_t)1 << mp->grain_order) - 1));
+	if (mp->data_pool_size <= (blk_num - 1) * blk_size)
+		return false;
+
+	mp->data_pool_size = min(mp->data_pool_size, blk_num * blk_size);
+	return true;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_init_lock
  *
  * Description:
- *    Memory pool initialization interface.
+ *    Memory pool initialization interface with the lock of pool.
  *
  * Param:
  *   @pool: user provided memory block required.
@@ -183,28 +530,30 @@ static void mempool_blk_init(struct mempool* mp)
  *   @pool_size: user provided memory block size required.
  *   @grain_order: the minimum granularity that memory allocators need to manage.
  *                 grain_order_size = (1 << grain_order).
+ *   @lock: lock of pool, see enum pl_mempool_lock.
  *
  * Return:
  *   handle of memory pool.
  *
  * NOTE:
  * mempool:
- *  [//gap//][struct mempool][bitmaps][fbits][mbits][//gap//][data_pool]
- *  A        A               A        A      A               A
- *  |        |               |        |      |               |
- * pool      mp             body    fbits  mfits         data_pool
- *           \_________________________________________________________/
- *                                     |
- *                                pool_szie
+ *  [//gap//][struct mempool][bitmaps][heads][fbits][mbits][index][//gap//][data_pool]
+ *  A        A               A        A      A      A      A              A
+ *  |        |               |        |      |      |      |              |
+ * pool      mp             body    heads  fbits  mfits  index        data_pool
+ *           \________________________________________________________________/
+ *                                         |
+ *                                     pool_szie
+ *  heads only exist with CONFIG_PL_MEMPOOL_OWNER.
  ************************************************************************************/
-pl_mempool_handle_t pl_mempool_init(void* pool, ushrt_t id, size_t pool_size,
-                                uchar_t grain_order)
+pl_mempool_handle_t pl_mempool_init_lock(void* pool, ushrt_t id, size_t pool_size,
+                                       uchar_t grain_order, enum pl_mempool_lock lock)
 {
 	struct mempool* mp;
 	size_t blk_num;
 	size_t min_pool_size;
 
-	if (pool == NULL)
+	if (pool == NULL || lock > PL_MEMPOOL_LOCK_NONE)
 		return NULL;
 
 	mp = (struct mempool*)pl_align_address(pool, sizeof(uintptr_t));
@@ -221,19 +570,91 @@ pl_mempool_handle_t pl_mempool_init(void* pool, ushrt_t id, size_t pool_size,
 	mp->id = id;
 	mp->state = 0;
 	mp->grain_order = grain_order;
-	mp->blk_num = blk_num;
-	mp->blk_bitmaps = (uintptr_t*)((uchar_t *)mp + sizeof(struct mempool));
-	mp->blk_first_bits = (uchar_t*)(mp->blk_bitmaps + blk_num);
-	mp->blk_max_bits = mp->blk_first_bits + blk_num;
-	mp->data_pool = mp->blk_max_bits + blk_num;
-	mp->data_pool = (uchar_t*)pl_align_address(mp->data_pool, sizeof(uintptr_t) << 2);
-	mp->data_pool_size = pool_size - ((size_t)(mp->data_pool) - (size_t)mp);
-	mp->data_pool_size &= (~(((size_t)1 << grain_order) - 1));
+	mp->lock = (uchar_t)lock;
+	mp->used_bytes = 0;
+	mp->peak_used = 0;
+	mp->nr_allocs = 0;
+	mp->nr_fails = 0;
+	if (lock == PL_MEMPOOL_LOCK_SEM && pl_semaphore_init(&mp->sem, 1) < 0)
+		return NULL;
+
+	/* the index takes some space of the last blocks */
+	while (!mempool_layout(mp, blk_num, pool_size)) {
+		if (--blk_num == 0)
+			return NULL;
+	}
 
 	mempool_blk_init(mp);
+#ifdef CONFIG_PL_MEMPOOL_INDEX
+	mempool_index_update(mp, 0, mempool_index_leaves(blk_num) - 1, true);
+#endif
 	return mp;
 }
 
+/*************************************************************************************
+ * Function Name: pl_mempool_init
+ *
+ * Description:
+ *    Memory pool initialization interface, the pool is locked by semaphore.
+ *
+ * Param:
+ *   @pool: user provided memory block required.
+ *   @id: memory pool identification number.
+ *   @pool_size: user provided memory block size required.
+ *   @grain_order: the minimum granularity that memory allocators need to manage.
+ *                 grain_order_size = (1 << grain_order).
+ *
+ * Return:
+ *   handle of memory pool.
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_init(void* pool, ushrt_t id, size_t pool_size,
+                                uchar_t grain_order)
+{
+	return pl_mempool_init_lock(pool, id, pool_size, grain_order,
+	                            PL_MEMPOOL_LOCK_SEM);
+}
+
+/*************************************************************************************
+ * Function Name: mempool_lock
+ *
+ * Description:
+ *   Lock memory pool by the lock of pool.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_lock(struct mempool *mp)
+{
+	if (mp->lock == PL_MEMPOOL_LOCK_SEM)
+		pl_semaphore_wait(&mp->sem);
+	else if (mp->lock == PL_MEMPOOL_LOCK_CRITICAL)
+		pl_port_enter_critical();
+}
+
+/*************************************************************************************
+ * Function Name: mempool_unlock
+ *
+ * Description:
+ *   Unlock memory pool by the lock of pool.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_unlock(struct mempool *mp)
+{
+	if (mp->lock == PL_MEMPOOL_LOCK_SEM)
+		pl_semaphore_post(&mp->sem);
+	else if (mp->lock == PL_MEMPOOL_LOCK_CRITICAL)
+		pl_port_exit_critical();
+}
+
+#ifndef CONFIG_PL_MEMPOOL_INDEX
 /*************************************************************************************
  * Function Name: find_blk_condition
  *
@@ -330,6 +751,7 @@ static bool get_blk_idx(struct mempool *mp, size_t alloc_size,
 
 	return false;
 }
+#endif
 
 /*************************************************************************************
  * Function Name: get_bit_offset
@@ -340,31 +762,17 @@ static bool get_blk_idx(struct mempool *mp, size_t alloc_size,
  * Param:
  *   @mp: Memory pool.
  *   @blk_idx: index of block.
- *   @grain_order: the minimum granularity that memory allocators need to manage.
- *                 grain_order_size = (1 << grain_order).
- *   @idx: got index of block.
+ *   @bit_num: the number of bits.
  *
  * Return:
  *   offset bit in blk_idx.
  ************************************************************************************/
-static size_t get_bit_offset(struct mempool *mp, size_t blk_idx,
-                             uchar_t grain_order, size_t alloc_size)
+static size_t get_bit_offset(struct mempool *mp, size_t blk_idx, size_t bit_num)
 {
-	size_t i;
-	size_t max_continue_bits = 0;
-	uintptr_t blk_bitmap = mp->blk_bitmaps[blk_idx];
-
-	if (alloc_size >= (((size_t)1 << grain_order) * UINTPTR_T_BITS))
+	if (bit_num >= UINTPTR_T_BITS)
 		return 0;
 
-	for (i = 0; i < UINTPTR_T_BITS; i++) {
-		max_continue_bits = blk_bitmap & ((uintptr_t)1 << i) ?
-			max_continue_bits + 1 : 0;
-		if ((max_continue_bits << grain_order) >= alloc_size)
-			break;
-	}
-
-	return i + 1 - max_continue_bits;
+	return pl_bits_first_run(mp->blk_bitmaps[blk_idx], (uchar_t)bit_num);
 }
 
 /*************************************************************************************
@@ -382,34 +790,18 @@ static size_t get_bit_offset(struct mempool *mp, size_t blk_idx,
  ************************************************************************************/
 static void update_blk_bits(struct mempool *mp, size_t blk_idx)
 {
-	size_t i;
-	uchar_t fbits = 0;
-	uchar_t bits = 0;
-	uchar_t mbits = 0;
-	uchar_t fbits_inc = 1;
 	uintptr_t blk_bitmap = mp->blk_bitmaps[blk_idx];
 
-	for (i = 0; i < UINTPTR_T_BITS; i++) {
-		if (blk_bitmap & ((uintptr_t)1 << i)) {
-			fbits += fbits_inc;
-			++bits;
-		} else {
-			fbits_inc = 0;
-			mbits = bits > mbits ? bits : mbits;
-			bits = 0;
-		}
-	}
-
-	mbits = bits > mbits ? bits : mbits;
-	mp->blk_first_bits[blk_idx] = fbits;
-	mp->blk_max_bits[blk_idx] = mbits;
+	mp->blk_first_bits[blk_idx] = pl_ctz(~blk_bitmap);
+	mp->blk_max_bits[blk_idx] = pl_bits_max_run(blk_bitmap);
 }
 
 /*************************************************************************************
  * Function Name: update_bit_map
  *
  * Description:
- *   Update bitmap when memory is allocated or free.
+ *   Update bitmap when memory is allocated or free, the bits may start at any
+ *   offset and cross blocks.
  *
  * Param:
  *   @mp: Memory pool.
@@ -424,117 +816,356 @@ static void update_blk_bits(struct mempool *mp, size_t blk_idx)
 static void update_bit_map(struct mempool *mp, size_t blk_start_idx,
                            size_t bit_offset, size_t bit_num, bool set_bits)
 {
-	size_t i = 0;
-	uintptr_t bitmap = 0;
+	size_t n;
+	uintptr_t bitmap;
 	uintptr_t bitmap_mask;
-	uchar_t first_bits = 0;
-	uchar_t max_bits = 0;
 	size_t blk_offset = blk_start_idx;
 
-	if (set_bits) {
-		bitmap = UINTPTR_T_MAX;
-		first_bits = UINTPTR_T_BITS;
-		max_bits = UINTPTR_T_BITS;
-	}
-
-	if (bit_num >= UINTPTR_T_BITS) {
-		for (i = 0; i < bit_num / UINTPTR_T_BITS; i++) {
-			mp->blk_first_bits[blk_offset] = first_bits;
-			mp->blk_max_bits[blk_offset] = max_bits;
+	while (bit_num != 0) {
+		n = min(bit_num, UINTPTR_T_BITS - bit_offset);
+		if (n == UINTPTR_T_BITS) {
+			mp->blk_first_bits[blk_offset] = set_bits ? UINTPTR_T_BITS : 0;
+			mp->blk_max_bits[blk_offset] = set_bits ? UINTPTR_T_BITS : 0;
+			mp->blk_bitmaps[blk_offset] = set_bits ? UINTPTR_T_MAX : 0;
+		} else {
+			bitmap = mp->blk_bitmaps[blk_offset];
+			bitmap_mask = ((((uintptr_t)1 << n) - 1) << bit_offset);
+			bitmap = set_bits ? (bitmap | bitmap_mask) : (bitmap & (~bitmap_mask));
 			mp->blk_bitmaps[blk_offset] = bitmap;
-			++blk_offset;
+			update_blk_bits(mp, blk_offset);
 		}
+
+		bit_num -= n;
+		bit_offset = 0;
+		++blk_offset;
 	}
 
-	/* bit_num -= i * UINTPTR_T_BITS */
-	bit_num -= i * UINTPTR_T_BITS;
-	bitmap = mp->blk_bitmaps[blk_offset];
-	bitmap_mask = ((((uintptr_t)1 << bit_num) - 1) << bit_offset);
-	bitmap = set_bits ? (bitmap | bitmap_mask) : (bitmap & (~bitmap_mask));
-	mp->blk_bitmaps[blk_offset] = bitmap;
-	/* get rest bit_map */
-	update_blk_bits(mp, blk_offset);
+#ifdef CONFIG_PL_MEMPOOL_INDEX
+	mempool_index_update(mp, blk_start_idx, blk_offset - 1, false);
+#endif
 }
 
 /*************************************************************************************
- * Function Name: pl_mempool_malloc
+ * Function Name: mempool_bits_free
  *
  * Description:
- *   Update bitmap when memory is allocated or free.
+ *   Check whether the grains are all free.
  *
  * Param:
- *   @mempool: memory pool.
- *   @size: memory size to require.
+ *   @mp: Memory pool.
+ *   @bit_idx: index of the first grain.
+ *   @bit_num: the number of grains.
  *
  * Return:
- *   address of memory.
+ *   true: all grains are free.
+ *   false: some grains are in use or out of pool.
  ************************************************************************************/
-void* pl_mempool_malloc(pl_mempool_handle_t mempool, size_t size)
+static bool mempool_bits_free(struct mempool *mp, size_t bit_idx, size_t bit_num)
 {
-	bool found;
-	size_t blk_idx;
-	size_t bit_offset;
-	struct mempool_data* data_addr;
-	struct mempool *mp = (struct mempool *)mempool;
-	size_t grain_size = (uintptr_t)1 << mp->grain_order;
-	size_t alloc_size = size + sizeof(struct mempool_data);
-	size_t bit_num = (alloc_size + grain_size - 1) / grain_size;
-
-	/* check mp if is NULL */
-	if (mp == NULL)
-		return NULL;
-
-	pl_semaphore_wait(&pl_default_mempool.sem);
-	/* get block index */
-	if (bit_num < UINTPTR_T_BITS)
-		found = get_blk_idx(mp, alloc_size, find_bit_condition, &blk_idx);
-	else
-		found = get_blk_idx(mp, alloc_size, find_blk_condition, &blk_idx);
-
-	/* check block index */
-	if (!found || blk_idx >= mp->blk_num) {
-		pl_semaphore_post(&pl_default_mempool.sem);
-		return NULL;
+	size_t n;
+	uintptr_t mask;
+	size_t blk_idx = bit_idx / UINTPTR_T_BITS;
+	size_t bit_offset = bit_idx & (UINTPTR_T_BITS - 1);
+
+	while (bit_num != 0) {
+		if (blk_idx >= mp->blk_num)
+			return false;
+
+		n = min(bit_num, UINTPTR_T_BITS - bit_offset);
+		mask = (n == UINTPTR_T_BITS) ? UINTPTR_T_MAX :
+		       ((((uintptr_t)1 << n) - 1) << bit_offset);
+		if ((mp->blk_bitmaps[blk_idx] & mask) != mask)
+			return false;
+
+		bit_num -= n;
+		bit_offset = 0;
+		++blk_idx;
 	}
 
-	/* get bit offset */
-	bit_offset = get_bit_offset(mp, blk_idx, mp->grain_order, alloc_size);
-	data_addr = (struct mempool_data*)(mp->data_pool +
-	             (((blk_idx << mp->grain_order) * UINTPTR_T_BITS) |
-	               (bit_offset << mp->grain_order)));
-
-	/* set data structure */
-	data_addr->bit_idx = (blk_idx * UINTPTR_T_BITS) | bit_offset;
-	data_addr->bit_num = bit_num;
-
-	/* update bitmap */
-	update_bit_map(mp, blk_idx, bit_offset, bit_num, false);
-	pl_semaphore_post(&pl_default_mempool.sem);
-
-	return (void*)data_addr->data;
+	return true;
 }
 
 /*************************************************************************************
- * Function Name: get_mempool_data
+ * Function Name: mempool_data_head
  *
  * Description:
- *   Get the data head of memory based on memory address p.
+ *   Get the header at the first grain of memory.
  *
  * Param:
- *   @mp: memory pool.
- *   @p: memory address.
+ *   @mp: Memory pool.
+ *   @bit_idx: index of the first grain.
  *
  * Return:
- *   data in the memory pool.
+ *   header of memory.
  ************************************************************************************/
-static struct mempool_data* get_mempool_data(struct mempool *mp, void* p)
+static struct mempool_data *mempool_data_head(struct mempool *mp, size_t bit_idx)
 {
-	size_t blk_idx;
-	struct mempool_data* data_addr;
+	return (struct mempool_data *)(mp->data_pool + (bit_idx << mp->grain_order));
+}
 
-	/* check mp and p */
-	if (mp == NULL || p == NULL)
-		return NULL;
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+/*************************************************************************************
+ * Function Name: mempool_mark_head
+ *
+ * Description:
+ *   Mark or unmark the first grain of memory with header.
+ *
+ * Param:
+ *   @mp: Memory pool.
+ *   @bit_idx: index of the first grain.
+ *   @head: the grain holds a header.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_mark_head(struct mempool *mp, size_t bit_idx, bool head)
+{
+	uintptr_t mask = (uintptr_t)1 << (bit_idx & (UINTPTR_T_BITS - 1));
+
+	if (head)
+		mp->blk_heads[bit_idx / UINTPTR_T_BITS] |= mask;
+	else
+		mp->blk_heads[bit_idx / UINTPTR_T_BITS] &= ~mask;
+}
+#endif
+
+/*************************************************************************************
+ * Function Name: mempool_count_alloc
+ *
+ * Description:
+ *   Count an allocation in the statistics of pool.
+ *
+ * Param:
+ *   @mp: Memory pool.
+ *   @bit_num: the number of grains.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_count_alloc(struct mempool *mp, size_t bit_num)
+{
+	mp->used_bytes += bit_num << mp->grain_order;
+	mp->peak_used = max(mp->peak_used, mp->used_bytes);
+	mp->nr_allocs++;
+}
+
+/*************************************************************************************
+ * Function Name: mempool_set_data
+ *
+ * Description:
+ *   Set the header of memory and count the allocation.
+ *
+ * Param:
+ *   @mp: Memory pool.
+ *   @data_addr: header before the payload.
+ *   @bit_idx: index of the first grain.
+ *   @bit_num: the number of grains.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_set_data(struct mempool *mp, struct mempool_data *data_addr,
+                             size_t bit_idx, size_t bit_num)
+{
+	struct mempool_data *head = mempool_data_head(mp, bit_idx);
+
+	head->bit_idx = bit_idx;
+	head->bit_num = bit_num;
+	data_addr->bit_idx = bit_idx;
+	data_addr->bit_num = bit_num;
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	head->owner = pl_task_get_curr_tcb();
+	data_addr->owner = head->owner;
+	mempool_mark_head(mp, bit_idx, true);
+#endif
+
+	mempool_count_alloc(mp, bit_num);
+}
+
+/*************************************************************************************
+ * Function Name: mempool_free_grains
+ *
+ * Description:
+ *   Free the grains of memory and uncount the allocation.
+ *
+ * Param:
+ *   @mp: Memory pool.
+ *   @bit_idx: index of the first grain.
+ *   @bit_num: the number of grains.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_free_grains(struct mempool *mp, size_t bit_idx, size_t bit_num)
+{
+	update_bit_map(mp, bit_idx / UINTPTR_T_BITS, bit_idx & (UINTPTR_T_BITS - 1),
+	               bit_num, true);
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	mempool_mark_head(mp, bit_idx, false);
+#endif
+	mp->used_bytes -= bit_num << mp->grain_order;
+	mp->nr_allocs--;
+}
+
+/*************************************************************************************
+ * Function Name: mempool_free_data
+ *
+ * Description:
+ *   Free the grains of memory.
+ *
+ * Param:
+ *   @mp: Memory pool.
+ *   @data_addr: header of memory.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_free_data(struct mempool *mp, struct mempool_data *data_addr)
+{
+	mempool_free_grains(mp, data_addr->bit_idx, data_addr->bit_num);
+}
+
+/*************************************************************************************
+ * Function Name: mempool_take_grains
+ *
+ * Description:
+ *   Find free grains and mark them used, the failure is counted.
+ *
+ * Param:
+ *   @mp: Memory pool, it is locked.
+ *   @bit_num: the number of grains.
+ *   @bit_idx: index of the first grain found.
+ *
+ * Return:
+ *   true: got it.
+ *   false: can't find.
+ ************************************************************************************/
+static bool mempool_take_grains(struct mempool *mp, size_t bit_num, size_t *bit_idx)
+{
+	bool found;
+	size_t blk_idx;
+	size_t bit_offset;
+
+	/* get block index */
+#ifdef CONFIG_PL_MEMPOOL_INDEX
+	found = mempool_index_find(mp, bit_num, &blk_idx);
+#else
+	if (bit_num < UINTPTR_T_BITS)
+		found = get_blk_idx(mp, bit_num << mp->grain_order, find_bit_condition,
+		                    &blk_idx);
+	else
+		found = get_blk_idx(mp, bit_num << mp->grain_order, find_blk_condition,
+		                    &blk_idx);
+#endif
+
+	/* check block index */
+	if (!found || blk_idx >= mp->blk_num) {
+		mp->nr_fails++;
+		return false;
+	}
+
+	/* get bit offset and update bitmap */
+	bit_offset = get_bit_offset(mp, blk_idx, bit_num);
+	*bit_idx = (blk_idx * UINTPTR_T_BITS) | bit_offset;
+	update_bit_map(mp, blk_idx, bit_offset, bit_num, false);
+	return true;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_malloc
+ *
+ * Description:
+ *   Update bitmap when memory is allocated or free.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void* pl_mempool_malloc(pl_mempool_handle_t mempool, size_t size)
+{
+	size_t bit_idx;
+	struct mempool_data* data_addr;
+	size_t grain_size;
+	size_t alloc_size;
+	size_t bit_num;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	/* check mp if is NULL */
+	if (mp == NULL)
+		return NULL;
+
+	grain_size = (uintptr_t)1 << mp->grain_order;
+	alloc_size = size + sizeof(struct mempool_data);
+	bit_num = (alloc_size + grain_size - 1) / grain_size;
+
+	mempool_lock(mp);
+	if (!mempool_take_grains(mp, bit_num, &bit_idx)) {
+		mempool_unlock(mp);
+		return NULL;
+	}
+
+	/* set data structure */
+	data_addr = mempool_data_head(mp, bit_idx);
+	mempool_set_data(mp, data_addr, bit_idx, bit_num);
+	mempool_unlock(mp);
+
+	return (void*)data_addr->data;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_malloc_isr
+ *
+ * Description:
+ *   Allocate memory in interrupt, the pool must be PL_MEMPOOL_LOCK_CRITICAL.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory, NULL if the pool is not ISR-safe.
+ ************************************************************************************/
+void* pl_mempool_malloc_isr(pl_mempool_handle_t mempool, size_t size)
+{
+	void* p;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || mp->lock != PL_MEMPOOL_LOCK_CRITICAL)
+		return NULL;
+
+	/* the memory of interrupt is owned by system, not the interrupted task */
+	p = pl_mempool_malloc(mp, size);
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	if (p != NULL)
+		container_of(p, struct mempool_data, data)->owner = NULL;
+#endif
+	return p;
+}
+
+/*************************************************************************************
+ * Function Name: get_mempool_data
+ *
+ * Description:
+ *   Get the data head of memory based on memory address p.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *   @p: memory address.
+ *
+ * Return:
+ *   data in the memory pool.
+ ************************************************************************************/
+static struct mempool_data* get_mempool_data(struct mempool *mp, void* p)
+{
+	size_t blk_idx;
+	struct mempool_data* data_addr;
+
+	/* check mp and p */
+	if (mp == NULL || p == NULL)
+		return NULL;
 
 	/* get address of data and check it */
 	data_addr = container_of(p, struct mempool_data, data);
@@ -567,8 +1198,6 @@ static struct mempool_data* get_mempool_data(struct mempool *mp, void* p)
  ************************************************************************************/
 void pl_mempool_free(pl_mempool_handle_t mempool, void* p)
 {
-	size_t blk_idx;
-	size_t bit_offset;
 	struct mempool_data* data_addr;
 	struct mempool *mp = (struct mempool *)mempool;
 
@@ -576,11 +1205,269 @@ void pl_mempool_free(pl_mempool_handle_t mempool, void* p)
 	if (data_addr == NULL)
 		return;
 
-	pl_semaphore_wait(&pl_default_mempool.sem);
-	blk_idx = data_addr->bit_idx / UINTPTR_T_BITS;
-	bit_offset = data_addr->bit_idx & (UINTPTR_T_BITS - 1);
-	update_bit_map(mp, blk_idx, bit_offset, data_addr->bit_num, true);
-	pl_semaphore_post(&pl_default_mempool.sem);
+	mempool_lock(mp);
+	mempool_free_data(mp, data_addr);
+	mempool_unlock(mp);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_isr
+ *
+ * Description:
+ *   Free memory in interrupt, the pool must be PL_MEMPOOL_LOCK_CRITICAL.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_isr(pl_mempool_handle_t mempool, void* p)
+{
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || mp->lock != PL_MEMPOOL_LOCK_CRITICAL)
+		return;
+
+	pl_mempool_free(mp, p);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_alloc_sized
+ *
+ * Description:
+ *   Allocate memory without header, the memory starts at a grain and is freed by
+ *   pl_mempool_free_sized() with the same size.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void *pl_mempool_alloc_sized(pl_mempool_handle_t mempool, size_t size)
+{
+	size_t bit_idx;
+	size_t bit_num;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || size == 0)
+		return NULL;
+
+	/* too large size fails in the search and is counted, without overflow */
+	size = min(size, mp->data_pool_size + 1);
+	bit_num = (size + ((size_t)1 << mp->grain_order) - 1) >> mp->grain_order;
+
+	mempool_lock(mp);
+	if (!mempool_take_grains(mp, bit_num, &bit_idx)) {
+		mempool_unlock(mp);
+		return NULL;
+	}
+
+	mempool_count_alloc(mp, bit_num);
+	mempool_unlock(mp);
+
+	return (void *)mempool_data_head(mp, bit_idx);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_sized
+ *
+ * Description:
+ *   Free memory of pl_mempool_alloc_sized().
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *   @size: size passed to pl_mempool_alloc_sized().
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_sized(pl_mempool_handle_t mempool, void *p, size_t size)
+{
+	size_t offset;
+	size_t grain_size;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || p == NULL || size == 0 || (uchar_t *)p < mp->data_pool)
+		return;
+
+	/* the memory must start at a grain of pool */
+	grain_size = (size_t)1 << mp->grain_order;
+	offset = (size_t)((uchar_t *)p - mp->data_pool);
+	if (offset >= mp->data_pool_size || (offset & (grain_size - 1)) != 0 ||
+	    size > mp->data_pool_size - offset)
+		return;
+
+	mempool_lock(mp);
+	mempool_free_grains(mp, offset >> mp->grain_order,
+	                    (size + grain_size - 1) >> mp->grain_order);
+	mempool_unlock(mp);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_realloc
+ *
+ * Description:
+ *   Change the size of memory. The memory grows or shrinks in place if the grains
+ *   after it are free, otherwise it is moved to a new memory.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address, NULL is the same as pl_mempool_malloc().
+ *   @size: new size of memory, 0 is the same as pl_mempool_free().
+ *
+ * Return:
+ *   address of memory, NULL on failure and p is not changed.
+ ************************************************************************************/
+void* pl_mempool_realloc(pl_mempool_handle_t mempool, void* p, size_t size)
+{
+	void* new_p;
+	size_t end_bit;
+	size_t old_end_bit;
+	size_t old_size;
+	size_t grain_size;
+	struct mempool_data* data_addr;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (p == NULL)
+		return pl_mempool_malloc(mp, size);
+
+	data_addr = get_mempool_data(mp, p);
+	if (data_addr == NULL)
+		return NULL;
+
+	if (size == 0) {
+		pl_mempool_free(mp, p);
+		return NULL;
+	}
+
+	/* the payload of memalign may not follow the first grain */
+	grain_size = (size_t)1 << mp->grain_order;
+	end_bit = ((size_t)((uchar_t *)p - mp->data_pool) + size + grain_size - 1) >>
+	          mp->grain_order;
+
+	mempool_lock(mp);
+	old_end_bit = data_addr->bit_idx + data_addr->bit_num;
+	if (end_bit < old_end_bit)
+		update_bit_map(mp, end_bit / UINTPTR_T_BITS, end_bit & (UINTPTR_T_BITS - 1),
+		               old_end_bit - end_bit, true);
+
+	if (end_bit <= old_end_bit ||
+	    mempool_bits_free(mp, old_end_bit, end_bit - old_end_bit)) {
+		if (end_bit > old_end_bit)
+			update_bit_map(mp, old_end_bit / UINTPTR_T_BITS,
+			               old_end_bit & (UINTPTR_T_BITS - 1),
+			               end_bit - old_end_bit, false);
+
+		data_addr->bit_num = end_bit - data_addr->bit_idx;
+		mempool_data_head(mp, data_addr->bit_idx)->bit_num = data_addr->bit_num;
+		mp->used_bytes -= old_end_bit << mp->grain_order;
+		mp->used_bytes += end_bit << mp->grain_order;
+		mp->peak_used = max(mp->peak_used, mp->used_bytes);
+		mempool_unlock(mp);
+		return p;
+	}
+
+	old_size = (old_end_bit << mp->grain_order) -
+	           (size_t)((uchar_t *)p - mp->data_pool);
+	mempool_unlock(mp);
+
+	new_p = pl_mempool_malloc(mp, size);
+	if (new_p == NULL)
+		return NULL;
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	/* the owner of memalign is only kept right at its first grain */
+	container_of(new_p, struct mempool_data, data)->owner =
+		mempool_data_head(mp, data_addr->bit_idx)->owner;
+#endif
+	pl_memcpy(new_p, p, old_size);
+	pl_mempool_free(mp, p);
+	return new_p;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_memalign
+ *
+ * Description:
+ *   Allocate memory whose address is a multiple of align. If align is larger than
+ *   the alignment of malloc, the header is put just before the aligned address and
+ *   a copy of it is put at the first grain, so about one grain is wasted. The
+ *   aligned addresses are checked in order, it is slower than malloc.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @align: alignment, power of 2.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void* pl_mempool_memalign(pl_mempool_handle_t mempool, size_t align, size_t size)
+{
+	uintptr_t natural;
+	uintptr_t addr;
+	uintptr_t end;
+	size_t hdr_off;
+	size_t bit_idx;
+	size_t bit_num;
+	size_t grain_size;
+	struct mempool_data* data_addr;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || align == 0 || (align & (align - 1)) != 0)
+		return NULL;
+
+	/* the payload of malloc is at data_pool + n * grain_size + header */
+	grain_size = (size_t)1 << mp->grain_order;
+	natural = (uintptr_t)mp->data_pool | grain_size | sizeof(struct mempool_data);
+	natural &= ~natural + 1;
+	if (align <= natural)
+		return pl_mempool_malloc(mp, size);
+
+	addr = (uintptr_t)mp->data_pool + sizeof(struct mempool_data);
+	addr = (addr + align - 1) & ~((uintptr_t)align - 1);
+	end = (uintptr_t)mp->data_pool + mp->data_pool_size;
+
+	mempool_lock(mp);
+	for (; addr < end && size <= end - addr; addr += align) {
+		hdr_off = (size_t)(addr - sizeof(struct mempool_data) -
+		                   (uintptr_t)mp->data_pool);
+		bit_idx = hdr_off >> mp->grain_order;
+
+		/* the header at the first grain must not overlap the header */
+		hdr_off &= grain_size - 1;
+		if (hdr_off != 0 && hdr_off < sizeof(struct mempool_data)) {
+			if (addr < (uintptr_t)mp->data_pool + (sizeof(struct mempool_data) << 1))
+				continue;
+
+			hdr_off = (size_t)(addr - (sizeof(struct mempool_data) << 1) -
+			                   (uintptr_t)mp->data_pool);
+			bit_idx = hdr_off >> mp->grain_order;
+		}
+
+		bit_num = ((size_t)(addr - (uintptr_t)mp->data_pool) + size +
+		           grain_size - 1) >> mp->grain_order;
+		bit_num -= bit_idx;
+		if (!mempool_bits_free(mp, bit_idx, bit_num))
+			continue;
+
+		data_addr = container_of((void *)addr, struct mempool_data, data);
+		mempool_set_data(mp, data_addr, bit_idx, bit_num);
+		update_bit_map(mp, bit_idx / UINTPTR_T_BITS, bit_idx & (UINTPTR_T_BITS - 1),
+		               bit_num, false);
+		mempool_unlock(mp);
+		return (void *)addr;
+	}
+
+	mp->nr_fails++;
+	mempool_unlock(mp);
+
+	return NULL;
 }
 
 /*************************************************************************************
@@ -601,15 +1488,7 @@ void pl_mempool_free(pl_mempool_handle_t mempool, void* p)
 static size_t mempool_blk_get_free_bytes(struct mempool *mp, size_t blk_idx,
                                           uchar_t grain_order)
 {
-	size_t i;
-	size_t rest_bit_num = 0;
-
-	for (i = 0; i < UINTPTR_T_BITS; i++) {
-		if (mp->blk_bitmaps[blk_idx] & ((uintptr_t)1 << i))
-			++rest_bit_num;
-	}
-
-	return (rest_bit_num << grain_order);
+	return ((size_t)pl_popcount(mp->blk_bitmaps[blk_idx]) << grain_order);
 }
 
 /*************************************************************************************
@@ -633,14 +1512,313 @@ size_t pl_mempool_get_free_bytes(pl_mempool_handle_t mempool)
 	if (mp == NULL)
 		return 0;
 
-	pl_semaphore_wait(&pl_default_mempool.sem);
+	mempool_lock(mp);
 	for (i = 0; i < mp->blk_num; i++)
 		rest_bytes += mempool_blk_get_free_bytes(mp, i, mp->grain_order);
-	pl_semaphore_post(&pl_default_mempool.sem);
+	mempool_unlock(mp);
 
 	return rest_bytes;
 }
 
+/*************************************************************************************
+ * Function Name: pl_mempool_get_stats
+ *
+ * Description:
+ *   Get statistics of memory pool. The free runs are counted by the bitmaps, a
+ *   run starts at a free bit whose lower bit is used, a run may cross blocks.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @stats: statistics wanted to get.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mempool_get_stats(pl_mempool_handle_t mempool, struct pl_mempool_stats *stats)
+{
+	size_t i;
+	size_t run = 0;
+	size_t largest = 0;
+	uintptr_t bitmap;
+	uintptr_t carry = 0;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || stats == NULL)
+		return -EFAULT;
+
+	stats->free_bytes = 0;
+	stats->free_frags = 0;
+
+	mempool_lock(mp);
+	for (i = 0; i < mp->blk_num; i++) {
+		bitmap = mp->blk_bitmaps[i];
+		stats->free_bytes += mempool_blk_get_free_bytes(mp, i, mp->grain_order);
+		stats->free_frags += pl_popcount(bitmap & ~((bitmap << 1) | carry));
+		carry = bitmap >> (UINTPTR_T_BITS - 1);
+		if (bitmap == UINTPTR_T_MAX) {
+			run += UINTPTR_T_BITS;
+			continue;
+		}
+
+		/* the run from the previous blocks ends at the first used bit */
+		largest = max(largest, run + pl_ctz(~bitmap));
+		largest = max(largest, (size_t)mp->blk_max_bits[i]);
+		run = pl_clz(~bitmap);
+	}
+
+	stats->total_bytes = mp->data_pool_size;
+	stats->largest_free = max(largest, run) << mp->grain_order;
+	stats->peak_used = mp->peak_used;
+	stats->nr_allocs = mp->nr_allocs;
+	stats->nr_fails = mp->nr_fails;
+	mempool_unlock(mp);
+
+	return OK;
+}
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+/*************************************************************************************
+ * Function Name: mempool_grain_is_head
+ *
+ * Description:
+ *   Check whether a grain is the first grain of memory with header.
+ *
+ * Param:
+ *   @mp: memory pool.
+ *   @bit_idx: index of grain.
+ *
+ * Return:
+ *   true if the grain holds a header.
+ ************************************************************************************/
+static bool mempool_grain_is_head(struct mempool *mp, size_t bit_idx)
+{
+	return (mp->blk_heads[bit_idx / UINTPTR_T_BITS] >>
+	        (bit_idx & (UINTPTR_T_BITS - 1))) & 1;
+}
+
+/*************************************************************************************
+ * Function Name: mempool_walk
+ *
+ * Description:
+ *   Walk the allocations by the headers at their first grains, the memory without
+ *   header is skipped. walk is called for each allocation if it is not NULL,
+ *   otherwise the allocations of owner are freed (free_owner) or given to system.
+ *
+ * Param:
+ *   @mp: memory pool, it is locked.
+ *   @walk: callback.
+ *   @arg: argument of callback.
+ *   @owner: owner to free or disown.
+ *   @free_owner: free the allocations of owner.
+ *
+ * Return:
+ *   the number of allocations of owner.
+ ************************************************************************************/
+static size_t mempool_walk(struct mempool *mp, pl_mempool_walk_t walk, void *arg,
+                           void *owner, bool free_owner)
+{
+	size_t bit_idx = 0;
+	size_t bit_num;
+	size_t freed = 0;
+	size_t grains = mp->data_pool_size >> mp->grain_order;
+	struct mempool_data *data_addr;
+
+	while (bit_idx < grains) {
+		if (!mempool_grain_is_head(mp, bit_idx)) {
+			bit_idx++;
+			continue;
+		}
+
+		data_addr = mempool_data_head(mp, bit_idx);
+		bit_num = max(data_addr->bit_num, (size_t)1);
+		if (walk != NULL) {
+			walk(data_addr->data, (bit_num << mp->grain_order) -
+			     sizeof(struct mempool_data), data_addr->owner, arg);
+		} else if (data_addr->owner == owner) {
+			if (free_owner)
+				mempool_free_data(mp, data_addr);
+			else
+				data_addr->owner = NULL;
+
+			freed++;
+		}
+
+		bit_idx += bit_num;
+	}
+
+	return freed;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_walk
+ *
+ * Description:
+ *   Call walk for each allocation of memory pool.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @walk: callback.
+ *   @arg: argument of callback.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mempool_walk(pl_mempool_handle_t mempool, pl_mempool_walk_t walk, void *arg)
+{
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || walk == NULL)
+		return -EFAULT;
+
+	mempool_lock(mp);
+	mempool_walk(mp, walk, arg, NULL, false);
+	mempool_unlock(mp);
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_set_owner
+ *
+ * Description:
+ *   Change the owner of memory.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *   @owner: new owner.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_set_owner(pl_mempool_handle_t mempool, void *p, void *owner)
+{
+	struct mempool_data* data_addr;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	data_addr = get_mempool_data(mp, p);
+	if (data_addr == NULL)
+		return;
+
+	mempool_lock(mp);
+	data_addr->owner = owner;
+	mempool_data_head(mp, data_addr->bit_idx)->owner = owner;
+	mempool_unlock(mp);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_owner
+ *
+ * Description:
+ *   Free all memory of owner.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ *
+ * Return:
+ *   the number of allocations freed.
+ ************************************************************************************/
+size_t pl_mempool_free_owner(pl_mempool_handle_t mempool, void *owner)
+{
+	size_t freed;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL)
+		return 0;
+
+	mempool_lock(mp);
+	freed = mempool_walk(mp, NULL, NULL, owner, true);
+	mempool_unlock(mp);
+
+	return freed;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_disown
+ *
+ * Description:
+ *   Give all memory of owner to system, such as the memory left by an exited task.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ *
+ * Return:
+ *   the number of allocations given to system.
+ ************************************************************************************/
+size_t pl_mempool_disown(pl_mempool_handle_t mempool, void *owner)
+{
+	size_t n;
+	struct mempool *mp = (struct mempool *)mempool;
+
+	if (mp == NULL || owner == NULL)
+		return 0;
+
+	mempool_lock(mp);
+	n = mempool_walk(mp, NULL, NULL, owner, false);
+	mempool_unlock(mp);
+
+	return n;
+}
+#endif /* CONFIG_PL_MEMPOOL_OWNER */
+#endif /* CONFIG_PL_MEMPOOL_TLSF */
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+/*************************************************************************************
+ * Description: owner and its bytes for mempool_owner_bytes().
+ ************************************************************************************/
+struct mempool_owner_sum {
+	void *owner;
+	size_t bytes;
+};
+
+/*************************************************************************************
+ * Function Name: mempool_owner_bytes
+ *
+ * Description:
+ *   Callback of pl_mempool_walk() to sum the memory of owner.
+ *
+ * Param:
+ *   @p: memory address.
+ *   @size: usable size of memory.
+ *   @owner: owner of memory.
+ *   @arg: struct of owner and bytes.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void mempool_owner_bytes(void *p, size_t size, void *owner, void *arg)
+{
+	struct mempool_owner_sum *sum = (struct mempool_owner_sum *)arg;
+
+	USED(p);
+	if (owner == sum->owner)
+		sum->bytes += size;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_get_owner_bytes
+ *
+ * Description:
+ *   Get the bytes which are allocated by owner.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ *
+ * Return:
+ *   usable bytes of the memory of owner.
+ ************************************************************************************/
+size_t pl_mempool_get_owner_bytes(pl_mempool_handle_t mempool, void *owner)
+{
+	struct mempool_owner_sum sum = {owner, 0};
+
+	pl_mempool_walk(mempool, mempool_owner_bytes, &sum);
+	return sum.bytes;
+}
+#endif
+
 /*************************************************************************************
  * Function Name: pl_mempool_set
  *
@@ -658,28 +1836,13 @@ size_t pl_mempool_get_free_bytes(pl_mempool_handle_t mempool)
  ************************************************************************************/
 void* pl_mempool_set(pl_mempool_handle_t mempool, void* p, uint8_t val, size_t size)
 {
-	size_t i;
-	char* char_p;
-	uintptr_t uintptr_val = val;
-	uintptr_t* set_p = (uintptr_t*)p;
-	size_t words = size / sizeof(uintptr_t);
-	size_t slice = size & (sizeof(uintptr_t) - 1);
 	struct mempool *mp = (struct mempool *)mempool;
 
 	if (mp == NULL || p == NULL || size == 0)
 		return p;
 
-	for (i = 0; i < sizeof(uintptr_t); i++)
-		uintptr_val |= ((uintptr_t)val << (i << 3));
-
-	for (i = 0; i < words; i++)
-		*(set_p++) = uintptr_val;
-
-	char_p = (char*)set_p;
-	for (i = 0; i < slice; i++)
-		*(char_p++) = val;
-
-	return char_p - 1;
+	pl_memset(p, val, size);
+	return (char *)p + size - 1;
 }
 
 /*************************************************************************************
@@ -749,12 +1912,23 @@ void *pl_mempool_calloc(pl_mempool_handle_t mempool, size_t num, size_t size)
  ************************************************************************************/
 static int pl_default_mempool_init(void)
 {
-	int ret = pl_semaphore_init(&pl_default_mempool.sem, 1);
-	pl_assert(ret == OK);
-
-	g_pl_default_mempool = pl_mempool_init(pl_default_mempool.pool_data,
-										   0, CONFIG_PL_DEFAULT_MEMPOOL_SIZE,
-										   CONFIG_PL_DEFAULT_MEMPOOL_GRAIN_ORDER);
+	u8_t *data = pl_default_mempool_data;
+	size_t size = CONFIG_PL_DEFAULT_MEMPOOL_SIZE;
+
+#ifdef CONFIG_PL_BOOT_ARENA
+	pl_arena_init(data, CONFIG_PL_BOOT_ARENA_SIZE);
+	data += CONFIG_PL_BOOT_ARENA_SIZE;
+	size -= CONFIG_PL_BOOT_ARENA_SIZE;
+#endif
+
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+	/* the main SRAM serves every flag, the special regions are added by ports */
+	g_pl_default_mempool = pl_mempool_add_region(data, size, PL_MEMPOOL_FAST |
+	                                             PL_MEMPOOL_DMA | PL_MEMPOOL_LARGE);
+#else
+	g_pl_default_mempool = pl_mempool_init(data, 0, size,
+	                                       CONFIG_PL_DEFAULT_MEMPOOL_GRAIN_ORDER);
+#endif
 	pl_assert(g_pl_default_mempool != NULL);
 
 	pl_early_syslog_info("mempool init done\r\n");
@@ -0,0 +1,269 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <config.h>
+#include <types.h>
+#include <errno.h>
+#include <kernel/kernel.h>
+#include <kernel/mempool.h>
+
+#define MEMPOOL_REGIONS_MAX              (4)
+#define MEMPOOL_REGION_HARD_FLAGS        (PL_MEMPOOL_DMA)
+
+/* the table is only written by early initcalls, so it is read without lock */
+static struct pl_mempool_region mempool_regions[MEMPOOL_REGIONS_MAX];
+static size_t mempool_nr_regions;
+
+/*************************************************************************************
+ * Function Name: mempool_region_count_flags
+ *
+ * Description:
+ *   Count the flags which are set.
+ *
+ * Parameters:
+ *   @flags: flags of region.
+ *
+ * Return:
+ *   the number of flags.
+ ************************************************************************************/
+static uchar_t mempool_region_count_flags(uchar_t flags)
+{
+	uchar_t cnt = 0;
+
+	for (; flags != 0; flags &= (uchar_t)(flags - 1))
+		cnt++;
+
+	return cnt;
+}
+
+/*************************************************************************************
+ * Function Name: mempool_region_score
+ *
+ * Description:
+ *   Score how a region fits the flags, the lower is the better. A missing hint
+ *   costs more than an extra flag, so FAST memory goes to the FAST only region
+ *   and the DMA capable RAM is kept for DMA.
+ *
+ * Parameters:
+ *   @region_flags: flags of region.
+ *   @flags: flags of allocation.
+ *
+ * Return:
+ *   score of region, less than 0 if the region can't be used.
+ ************************************************************************************/
+static int mempool_region_score(uchar_t region_flags, uchar_t flags)
+{
+	uchar_t missing = (uchar_t)(flags & ~region_flags);
+	uchar_t extra = (uchar_t)(region_flags & ~flags);
+
+	if ((missing & MEMPOOL_REGION_HARD_FLAGS) != 0)
+		return -EINVAL;
+
+	return (mempool_region_count_flags(missing) << 2) +
+	        mempool_region_count_flags(extra);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_add_region
+ *
+ * Description:
+ *   Init a memory pool on a RAM region and add it to the region table.
+ *
+ * Parameters:
+ *   @start: start address of region.
+ *   @size: size of region.
+ *   @flags: flags of region, see enum pl_mempool_flags.
+ *
+ * Return:
+ *   handle of memory pool, NULL on failure.
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_add_region(void *start, size_t size, uchar_t flags)
+{
+	pl_mempool_handle_t mp;
+	struct pl_mempool_region *region;
+
+	if (mempool_nr_regions == MEMPOOL_REGIONS_MAX)
+		return NULL;
+
+	mp = pl_mempool_init(start, (ushrt_t)mempool_nr_regions, size,
+	                     CONFIG_PL_DEFAULT_MEMPOOL_GRAIN_ORDER);
+	if (mp == NULL)
+		return NULL;
+
+	region = &mempool_regions[mempool_nr_regions];
+	region->mempool = mp;
+	region->start = start;
+	region->size = size;
+	region->flags = flags;
+	mempool_nr_regions++;
+	return mp;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_malloc_flags
+ *
+ * Description:
+ *   Allocate memory from the region which fits the flags best, then from the
+ *   next one when the region is exhausted.
+ *
+ * Parameters:
+ *   @size: memory size to require.
+ *   @flags: flags of region, see enum pl_mempool_flags.
+ *
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void *pl_mempool_malloc_flags(size_t size, uchar_t flags)
+{
+	int score;
+	int best_score;
+	size_t i;
+	size_t best;
+	void *p;
+	uint_t tried = 0;
+
+	for (;;) {
+		best = MEMPOOL_REGIONS_MAX;
+		best_score = 0;
+		for (i = 0; i < mempool_nr_regions; i++) {
+			if ((tried & (1u << i)) != 0)
+				continue;
+
+			score = mempool_region_score(mempool_regions[i].flags, flags);
+			if (score < 0)
+				continue;
+
+			if (best == MEMPOOL_REGIONS_MAX || score < best_score) {
+				best = i;
+				best_score = score;
+			}
+		}
+
+		if (best == MEMPOOL_REGIONS_MAX)
+			return NULL;
+
+		p = pl_mempool_malloc(mempool_regions[best].mempool, size);
+		if (p != NULL)
+			return p;
+
+		tried |= 1u << best;
+	}
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_region_of
+ *
+ * Description:
+ *   Get the memory pool of the region which holds an address.
+ *
+ * Parameters:
+ *   @p: memory address.
+ *
+ * Return:
+ *   handle of memory pool, NULL if the address is not in any region.
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_region_of(const void *p)
+{
+	size_t i;
+	const uchar_t *start;
+
+	for (i = 0; i < mempool_nr_regions; i++) {
+		start = mempool_regions[i].start;
+		if ((const uchar_t *)p >= start &&
+		    (const uchar_t *)p < start + mempool_regions[i].size)
+			return mempool_regions[i].mempool;
+	}
+
+	return NULL;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_flags
+ *
+ * Description:
+ *   Free memory of pl_mempool_malloc_flags().
+ *
+ * Parameters:
+ *   @p: memory address.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_flags(void *p)
+{
+	pl_mempool_handle_t mp;
+
+	mp = pl_mempool_region_of(p);
+	if (mp != NULL)
+		pl_mempool_free(mp, p);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_get_region
+ *
+ * Description:
+ *   Get a region of the table.
+ *
+ * Parameters:
+ *   @idx: index of region.
+ *   @region: region to fill.
+ *
+ * Return:
+ *   0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mempool_get_region(size_t idx, struct pl_mempool_region *region)
+{
+	if (region == NULL)
+		return -EFAULT;
+
+	if (idx >= mempool_nr_regions)
+		return -ENOENT;
+
+	*region = mempool_regions[idx];
+	return OK;
+}
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+/*************************************************************************************
+ * Function Name: pl_mempool_disown_regions
+ *
+ * Description:
+ *   Give all memory of owner in every region to system.
+ *
+ * Parameters:
+ *   @owner: owner, the task id.
+ *
+ * Return:
+ *   the number of allocations given to system.
+ ************************************************************************************/
+size_t pl_mempool_disown_regions(void *owner)
+{
+	size_t i;
+	size_t cnt = 0;
+
+	for (i = 0; i < mempool_nr_regions; i++)
+		cnt += pl_mempool_disown(mempool_regions[i].mempool, owner);
+
+	return cnt;
+}
+#endif
@@ -0,0 +1,1087 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <config.h>
+#include <types.h>
+#include <errno.h>
+#include <lib/string.h>
+#include <port/port.h>
+#include <kernel/kernel.h>
+#include <kernel/bitops.h>
+#include <kernel/mempool.h>
+#include <kernel/semaphore.h>
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+#include "task.h"
+#endif
+
+/*************************************************************************************
+ * Description: two-level segregated fit (TLSF) memory pool.
+ *
+ * The free blocks are kept in lists indexed by [fl][sl], fl is the power of 2 of
+ * the size and sl splits [2^fl, 2^(fl+1)) into TLSF_SL_COUNT ranges. The sizes
+ * smaller than TLSF_SMALL_BLOCK are all in fl 0. Two levels of bitmaps mark the
+ * non-empty lists, so malloc and free take a constant number of steps. The free
+ * block is merged with its physical neighbours at once.
+ ************************************************************************************/
+#define TLSF_ALIGN_SIZE           (sizeof(uintptr_t) << 1)
+#define TLSF_ALIGN_LOG2           ((sizeof(uintptr_t) == 8) ? 4 : \
+                                   (sizeof(uintptr_t) == 4) ? 3 : 2)
+#define TLSF_SL_LOG2              (4)
+#define TLSF_SL_COUNT             (1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT             (TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_SMALL_BLOCK          ((size_t)1 << TLSF_FL_SHIFT)
+
+#define TLSF_BLOCK_FREE           ((size_t)1)
+#define TLSF_BLOCK_SIZE_MASK      (~((size_t)TLSF_ALIGN_SIZE - 1))
+#define TLSF_BLOCK_HDR_SIZE       (offsetof(struct tlsf_block, next_free))
+#define TLSF_BLOCK_MIN_SIZE       (sizeof(struct tlsf_block *) << 1)
+
+/*************************************************************************************
+ * Description: block of pool.
+ *   @prev_phys: previous block in memory.
+ *   @size: size of payload, bit 0 is set if the block is free.
+ *   @owner: task which allocated the block, reserved keeps the payload aligned.
+ *   @next_free/@prev_free: links of free list, they are in the payload.
+ ************************************************************************************/
+struct tlsf_block {
+	struct tlsf_block *prev_phys;
+	size_t size;
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	void *owner;
+	uintptr_t reserved;
+#endif
+	struct tlsf_block *next_free;
+	struct tlsf_block *prev_free;
+};
+
+/*************************************************************************************
+ * Description: control block of pool, followed by sl_bitmap and the free lists.
+ ************************************************************************************/
+struct tlsf_pool {
+	ushrt_t id;
+	uchar_t lock;
+	uchar_t fl_count;
+	uchar_t *start;
+	uchar_t *end;
+	size_t free_bytes;
+	size_t total_bytes;
+	size_t peak_used;
+	size_t nr_allocs;
+	size_t nr_fails;
+	uintptr_t fl_bitmap;
+	uintptr_t *sl_bitmap;
+	struct tlsf_block **blocks;
+	struct pl_sem sem;
+};
+
+/*************************************************************************************
+ * Function Name: tlsf_fls
+ *
+ * Description:
+ *   Find the last set bit.
+ *
+ * Param:
+ *   @x: value, it is not 0.
+ *
+ * Return:
+ *   index of the highest set bit.
+ ************************************************************************************/
+static uchar_t tlsf_fls(size_t x)
+{
+	return (uchar_t)(UINTPTR_T_BITS - 1 - pl_clz((uintptr_t)x));
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_mapping_insert
+ *
+ * Description:
+ *   Get the list of block size.
+ *
+ * Param:
+ *   @size: size of block.
+ *   @fl: first level index.
+ *   @sl: second level index.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_mapping_insert(size_t size, uchar_t *fl, uchar_t *sl)
+{
+	uchar_t f;
+
+	if (size < TLSF_SMALL_BLOCK) {
+		*fl = 0;
+		*sl = (uchar_t)(size / (TLSF_SMALL_BLOCK / TLSF_SL_COUNT));
+		return;
+	}
+
+	f = tlsf_fls(size);
+	*sl = (uchar_t)((size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT);
+	*fl = (uchar_t)(f - TLSF_FL_SHIFT + 1);
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_mapping_search
+ *
+ * Description:
+ *   Get the first list whose blocks are all large enough for size.
+ *
+ * Param:
+ *   @size: size required.
+ *   @fl: first level index.
+ *   @sl: second level index.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_mapping_search(size_t size, uchar_t *fl, uchar_t *sl)
+{
+	if (size >= TLSF_SMALL_BLOCK)
+		size += ((size_t)1 << (tlsf_fls(size) - TLSF_SL_LOG2)) - 1;
+
+	tlsf_mapping_insert(size, fl, sl);
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_block_size
+ *
+ * Description:
+ *   Get size of block payload.
+ *
+ * Param:
+ *   @block: block.
+ *
+ * Return:
+ *   size of payload.
+ ************************************************************************************/
+static size_t tlsf_block_size(struct tlsf_block *block)
+{
+	return block->size & TLSF_BLOCK_SIZE_MASK;
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_block_next
+ *
+ * Description:
+ *   Get the next block in memory.
+ *
+ * Param:
+ *   @block: block.
+ *
+ * Return:
+ *   next block.
+ ************************************************************************************/
+static struct tlsf_block *tlsf_block_next(struct tlsf_block *block)
+{
+	return (struct tlsf_block *)((uchar_t *)block + TLSF_BLOCK_HDR_SIZE +
+	                             tlsf_block_size(block));
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_insert_block
+ *
+ * Description:
+ *   Insert a free block to its list.
+ *
+ * Param:
+ *   @tp: pool.
+ *   @block: free block.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_insert_block(struct tlsf_pool *tp, struct tlsf_block *block)
+{
+	uchar_t fl;
+	uchar_t sl;
+	struct tlsf_block **head;
+
+	tlsf_mapping_insert(tlsf_block_size(block), &fl, &sl);
+	head = &tp->blocks[fl * TLSF_SL_COUNT + sl];
+	block->next_free = *head;
+	block->prev_free = NULL;
+	if (*head != NULL)
+		(*head)->prev_free = block;
+
+	*head = block;
+	block->size |= TLSF_BLOCK_FREE;
+	tp->fl_bitmap |= (uintptr_t)1 << fl;
+	tp->sl_bitmap[fl] |= (uintptr_t)1 << sl;
+	tp->free_bytes += tlsf_block_size(block);
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_remove_block
+ *
+ * Description:
+ *   Remove a free block from its list.
+ *
+ * Param:
+ *   @tp: pool.
+ *   @block: free block.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_remove_block(struct tlsf_pool *tp, struct tlsf_block *block)
+{
+	uchar_t fl;
+	uchar_t sl;
+	struct tlsf_block **head;
+
+	tlsf_mapping_insert(tlsf_block_size(block), &fl, &sl);
+	head = &tp->blocks[fl * TLSF_SL_COUNT + sl];
+	if (block->prev_free != NULL)
+		block->prev_free->next_free = block->next_free;
+	else
+		*head = block->next_free;
+
+	if (block->next_free != NULL)
+		block->next_free->prev_free = block->prev_free;
+
+	if (*head == NULL) {
+		tp->sl_bitmap[fl] &= ~((uintptr_t)1 << sl);
+		if (tp->sl_bitmap[fl] == 0)
+			tp->fl_bitmap &= ~((uintptr_t)1 << fl);
+	}
+
+	block->size &= ~TLSF_BLOCK_FREE;
+	tp->free_bytes -= tlsf_block_size(block);
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_find_block
+ *
+ * Description:
+ *   Find a free block which can hold size.
+ *
+ * Param:
+ *   @tp: pool.
+ *   @size: size required.
+ *
+ * Return:
+ *   free block, NULL if no block is large enough.
+ ************************************************************************************/
+static struct tlsf_block *tlsf_find_block(struct tlsf_pool *tp, size_t size)
+{
+	uchar_t fl;
+	uchar_t sl;
+	uintptr_t map;
+
+	tlsf_mapping_search(size, &fl, &sl);
+	if (fl >= tp->fl_count)
+		return NULL;
+
+	map = tp->sl_bitmap[fl] & (UINTPTR_T_MAX << sl);
+	if (map == 0) {
+		map = tp->fl_bitmap & (UINTPTR_T_MAX << fl) & ~((uintptr_t)1 << fl);
+		if (map == 0)
+			return NULL;
+
+		fl = pl_ctz(map);
+		map = tp->sl_bitmap[fl];
+	}
+
+	sl = pl_ctz(map);
+	return tp->blocks[fl * TLSF_SL_COUNT + sl];
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_split
+ *
+ * Description:
+ *   Trim a used block to size, the rest is merged with the next block if it is
+ *   free and put to the free lists.
+ *
+ * Param:
+ *   @tp: pool.
+ *   @block: used block.
+ *   @size: size of payload to keep, aligned.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_split(struct tlsf_pool *tp, struct tlsf_block *block, size_t size)
+{
+	size_t rest = tlsf_block_size(block) - size;
+	struct tlsf_block *next;
+	struct tlsf_block *after;
+
+	if (rest < TLSF_BLOCK_HDR_SIZE + TLSF_BLOCK_MIN_SIZE)
+		return;
+
+	block->size = size;
+	next = tlsf_block_next(block);
+	next->prev_phys = block;
+	next->size = rest - TLSF_BLOCK_HDR_SIZE;
+	after = tlsf_block_next(next);
+	if (after->size & TLSF_BLOCK_FREE) {
+		tlsf_remove_block(tp, after);
+		next->size += TLSF_BLOCK_HDR_SIZE + after->size;
+		after = tlsf_block_next(next);
+	}
+
+	after->prev_phys = next;
+	tlsf_insert_block(tp, next);
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_account
+ *
+ * Description:
+ *   Set the owner of a new used block and count it.
+ *
+ * Param:
+ *   @tp: pool.
+ *   @block: used block.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_account(struct tlsf_pool *tp, struct tlsf_block *block)
+{
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	block->owner = pl_task_get_curr_tcb();
+#else
+	USED(block);
+#endif
+	tp->nr_allocs++;
+	tp->peak_used = max(tp->peak_used, tp->total_bytes - tp->free_bytes);
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_free_block
+ *
+ * Description:
+ *   Free a used block, it is merged with its free neighbours.
+ *
+ * Param:
+ *   @tp: pool.
+ *   @block: used block.
+ *
+ * Return:
+ *   the free block after merging.
+ ************************************************************************************/
+static struct tlsf_block *tlsf_free_block(struct tlsf_pool *tp, struct tlsf_block *block)
+{
+	struct tlsf_block *next;
+
+	/* merge with the previous block */
+	if (block->prev_phys != NULL && (block->prev_phys->size & TLSF_BLOCK_FREE)) {
+		tlsf_remove_block(tp, block->prev_phys);
+		block->prev_phys->size += TLSF_BLOCK_HDR_SIZE + block->size;
+		block = block->prev_phys;
+	}
+
+	/* merge with the next block, the sentinel is never free */
+	next = tlsf_block_next(block);
+	if (next->size & TLSF_BLOCK_FREE) {
+		tlsf_remove_block(tp, next);
+		block->size += TLSF_BLOCK_HDR_SIZE + next->size;
+	}
+
+	tlsf_block_next(block)->prev_phys = block;
+	tlsf_insert_block(tp, block);
+	tp->nr_allocs--;
+	return block;
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_lock
+ *
+ * Description:
+ *   Lock pool by the lock of pool.
+ *
+ * Param:
+ *   @tp: pool.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_lock(struct tlsf_pool *tp)
+{
+	if (tp->lock == PL_MEMPOOL_LOCK_SEM)
+		pl_semaphore_wait(&tp->sem);
+	else if (tp->lock == PL_MEMPOOL_LOCK_CRITICAL)
+		pl_port_enter_critical();
+}
+
+/*************************************************************************************
+ * Function Name: tlsf_unlock
+ *
+ * Description:
+ *   Unlock pool by the lock of pool.
+ *
+ * Param:
+ *   @tp: pool.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void tlsf_unlock(struct tlsf_pool *tp)
+{
+	if (tp->lock == PL_MEMPOOL_LOCK_SEM)
+		pl_semaphore_post(&tp->sem);
+	else if (tp->lock == PL_MEMPOOL_LOCK_CRITICAL)
+		pl_port_exit_critical();
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_init_lock
+ *
+ * Description:
+ *    Memory pool initialization interface with the lock of pool.
+ *
+ * Param:
+ *   @pool: user provided memory block required.
+ *   @id: memory pool identification number.
+ *   @pool_size: user provided memory block size required.
+ *   @grain_order: not used by TLSF, the blocks are aligned to TLSF_ALIGN_SIZE.
+ *   @lock: lock of pool, see enum pl_mempool_lock.
+ *
+ * Return:
+ *   handle of memory pool.
+ *
+ * NOTE:
+ * mempool:
+ *  [//gap//][struct tlsf_pool][sl_bitmap][blocks][block]...[block][sentinel]
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_init_lock(void* pool, ushrt_t id, size_t pool_size,
+                                       uchar_t grain_order, enum pl_mempool_lock lock)
+{
+	uchar_t fl_count;
+	uchar_t *end;
+	struct tlsf_pool *tp;
+	struct tlsf_block *block;
+	struct tlsf_block *sentinel;
+
+	USED(grain_order);
+	if (pool == NULL || lock > PL_MEMPOOL_LOCK_NONE ||
+	    pool_size < sizeof(struct tlsf_pool) + TLSF_SMALL_BLOCK)
+		return NULL;
+
+	/* the lists cover sizes up to pool_size */
+	fl_count = 1;
+	if (pool_size >= TLSF_SMALL_BLOCK)
+		fl_count = (uchar_t)(tlsf_fls(pool_size) - TLSF_FL_SHIFT + 2);
+
+	tp = (struct tlsf_pool *)pl_align_address(pool, sizeof(uintptr_t));
+	tp->sl_bitmap = (uintptr_t *)(tp + 1);
+	tp->blocks = (struct tlsf_block **)(tp->sl_bitmap + fl_count);
+	tp->start = (uchar_t *)pl_align_address(tp->blocks + fl_count * TLSF_SL_COUNT,
+	                                        TLSF_ALIGN_SIZE);
+	end = (uchar_t *)pool + pool_size;
+	end = (uchar_t *)((uintptr_t)end & ~((uintptr_t)TLSF_ALIGN_SIZE - 1));
+	if (end < tp->start + (TLSF_BLOCK_HDR_SIZE << 1) + TLSF_BLOCK_MIN_SIZE)
+		return NULL;
+
+	tp->id = id;
+	tp->lock = (uchar_t)lock;
+	tp->fl_count = fl_count;
+	tp->end = end;
+	tp->free_bytes = 0;
+	tp->peak_used = 0;
+	tp->nr_allocs = 0;
+	tp->nr_fails = 0;
+	tp->fl_bitmap = 0;
+	pl_mempool_set(tp, tp->sl_bitmap, 0, fl_count * sizeof(uintptr_t));
+	pl_mempool_set(tp, tp->blocks, 0,
+	               fl_count * TLSF_SL_COUNT * sizeof(struct tlsf_block *));
+	if (lock == PL_MEMPOOL_LOCK_SEM && pl_semaphore_init(&tp->sem, 1) < 0)
+		return NULL;
+
+	/* one free block and a used sentinel without payload at the end */
+	block = (struct tlsf_block *)tp->start;
+	block->prev_phys = NULL;
+	block->size = (size_t)(end - tp->start) - (TLSF_BLOCK_HDR_SIZE << 1);
+	block->size &= TLSF_BLOCK_SIZE_MASK;
+	sentinel = tlsf_block_next(block);
+	sentinel->prev_phys = block;
+	sentinel->size = 0;
+	tlsf_insert_block(tp, block);
+	tp->total_bytes = tp->free_bytes;
+
+	return tp;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_init
+ *
+ * Description:
+ *    Memory pool initialization interface, the pool is locked by semaphore.
+ *
+ * Param:
+ *   @pool: user provided memory block required.
+ *   @id: memory pool identification number.
+ *   @pool_size: user provided memory block size required.
+ *   @grain_order: not used by TLSF.
+ *
+ * Return:
+ *   handle of memory pool.
+ ************************************************************************************/
+pl_mempool_handle_t pl_mempool_init(void* pool, ushrt_t id, size_t pool_size,
+                                uchar_t grain_order)
+{
+	return pl_mempool_init_lock(pool, id, pool_size, grain_order,
+	                            PL_MEMPOOL_LOCK_SEM);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_malloc
+ *
+ * Description:
+ *   Allocate memory, the rest of the block found is split to a free block.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void* pl_mempool_malloc(pl_mempool_handle_t mempool, size_t size)
+{
+	struct tlsf_block *block;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || size == 0)
+		return NULL;
+
+	/* too large size fails in the lookup and is counted, without overflow */
+	size = min(size, (size_t)(tp->end - tp->start) + 1);
+	size = pl_align_size(max(size, TLSF_BLOCK_MIN_SIZE), TLSF_ALIGN_SIZE);
+
+	tlsf_lock(tp);
+	block = tlsf_find_block(tp, size);
+	if (block == NULL) {
+		tp->nr_fails++;
+		tlsf_unlock(tp);
+		return NULL;
+	}
+
+	tlsf_remove_block(tp, block);
+	tlsf_split(tp, block, size);
+	tlsf_account(tp, block);
+	tlsf_unlock(tp);
+
+	return &block->next_free;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_malloc_isr
+ *
+ * Description:
+ *   Allocate memory in interrupt, the pool must be PL_MEMPOOL_LOCK_CRITICAL.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory, NULL if the pool is not ISR-safe.
+ ************************************************************************************/
+void* pl_mempool_malloc_isr(pl_mempool_handle_t mempool, size_t size)
+{
+	void* p;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || tp->lock != PL_MEMPOOL_LOCK_CRITICAL)
+		return NULL;
+
+	/* the memory of interrupt is owned by system, not the interrupted task */
+	p = pl_mempool_malloc(tp, size);
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	if (p != NULL)
+		container_of(p, struct tlsf_block, next_free)->owner = NULL;
+#endif
+	return p;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free
+ *
+ * Description:
+ *   Free memory interface, the block is merged with its free neighbours.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free(pl_mempool_handle_t mempool, void* p)
+{
+	struct tlsf_block *block;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || p == NULL)
+		return;
+
+	block = container_of(p, struct tlsf_block, next_free);
+	if ((uchar_t *)block < tp->start || (uchar_t *)p >= tp->end)
+		return;
+
+	tlsf_lock(tp);
+	if (block->size & TLSF_BLOCK_FREE) {
+		tlsf_unlock(tp);
+		return;
+	}
+
+	tlsf_free_block(tp, block);
+	tlsf_unlock(tp);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_isr
+ *
+ * Description:
+ *   Free memory in interrupt, the pool must be PL_MEMPOOL_LOCK_CRITICAL.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_isr(pl_mempool_handle_t mempool, void* p)
+{
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || tp->lock != PL_MEMPOOL_LOCK_CRITICAL)
+		return;
+
+	pl_mempool_free(tp, p);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_alloc_sized
+ *
+ * Description:
+ *   Allocate memory for the users which know the size at free. The boundary tags
+ *   of TLSF can't be dropped, so it is the same as malloc but owned by system.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void *pl_mempool_alloc_sized(pl_mempool_handle_t mempool, size_t size)
+{
+	void *p;
+
+	p = pl_mempool_malloc(mempool, size);
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	if (p != NULL)
+		container_of(p, struct tlsf_block, next_free)->owner = NULL;
+#endif
+	return p;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_sized
+ *
+ * Description:
+ *   Free memory of pl_mempool_alloc_sized(), the size is kept in the block.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *   @size: size passed to pl_mempool_alloc_sized().
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_free_sized(pl_mempool_handle_t mempool, void *p, size_t size)
+{
+	USED(size);
+	pl_mempool_free(mempool, p);
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_realloc
+ *
+ * Description:
+ *   Change the size of memory. The block grows in place if the next block is free
+ *   and large enough, it is trimmed in place when it shrinks, otherwise it is moved
+ *   to a new memory.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address, NULL is the same as pl_mempool_malloc().
+ *   @size: new size of memory, 0 is the same as pl_mempool_free().
+ *
+ * Return:
+ *   address of memory, NULL on failure and p is not changed.
+ ************************************************************************************/
+void* pl_mempool_realloc(pl_mempool_handle_t mempool, void* p, size_t size)
+{
+	void* new_p;
+	size_t old_size;
+	struct tlsf_block *block;
+	struct tlsf_block *next;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (p == NULL)
+		return pl_mempool_malloc(tp, size);
+
+	if (tp == NULL)
+		return NULL;
+
+	if (size == 0) {
+		pl_mempool_free(tp, p);
+		return NULL;
+	}
+
+	block = container_of(p, struct tlsf_block, next_free);
+	if ((uchar_t *)block < tp->start || (uchar_t *)p >= tp->end)
+		return NULL;
+
+	size = min(size, (size_t)(tp->end - tp->start) + 1);
+	size = pl_align_size(max(size, TLSF_BLOCK_MIN_SIZE), TLSF_ALIGN_SIZE);
+
+	tlsf_lock(tp);
+	old_size = tlsf_block_size(block);
+	next = tlsf_block_next(block);
+	if (size > old_size && (next->size & TLSF_BLOCK_FREE) &&
+	    old_size + TLSF_BLOCK_HDR_SIZE + tlsf_block_size(next) >= size) {
+		tlsf_remove_block(tp, next);
+		block->size += TLSF_BLOCK_HDR_SIZE + next->size;
+		tlsf_block_next(block)->prev_phys = block;
+	}
+
+	if (size <= tlsf_block_size(block)) {
+		tlsf_split(tp, block, size);
+		tp->peak_used = max(tp->peak_used, tp->total_bytes - tp->free_bytes);
+		tlsf_unlock(tp);
+		return p;
+	}
+	tlsf_unlock(tp);
+
+	new_p = pl_mempool_malloc(tp, size);
+	if (new_p == NULL)
+		return NULL;
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	container_of(new_p, struct tlsf_block, next_free)->owner = block->owner;
+#endif
+	pl_memcpy(new_p, p, old_size);
+	pl_mempool_free(tp, p);
+	return new_p;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_memalign
+ *
+ * Description:
+ *   Allocate memory whose address is a multiple of align. A block with room for
+ *   the alignment is taken, the space before the aligned address becomes a free
+ *   block and the tail is trimmed.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @align: alignment, power of 2.
+ *   @size: memory size to require.
+ *
+ * Return:
+ *   address of memory.
+ ************************************************************************************/
+void* pl_mempool_memalign(pl_mempool_handle_t mempool, size_t align, size_t size)
+{
+	size_t gap;
+	uintptr_t addr;
+	uintptr_t payload;
+	struct tlsf_block *block;
+	struct tlsf_block *aligned;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+	const size_t gap_min = TLSF_BLOCK_HDR_SIZE + TLSF_BLOCK_MIN_SIZE;
+
+	if (tp == NULL || align == 0 || (align & (align - 1)) != 0 ||
+	    align > (size_t)(tp->end - tp->start))
+		return NULL;
+
+	if (align <= TLSF_ALIGN_SIZE)
+		return pl_mempool_malloc(tp, size);
+
+	size = min(size, (size_t)(tp->end - tp->start) + 1);
+	size = pl_align_size(max(size, TLSF_BLOCK_MIN_SIZE), TLSF_ALIGN_SIZE);
+
+	tlsf_lock(tp);
+	block = tlsf_find_block(tp, size + align + gap_min);
+	if (block == NULL) {
+		tp->nr_fails++;
+		tlsf_unlock(tp);
+		return NULL;
+	}
+
+	/* the space before the aligned address must hold a free block */
+	tlsf_remove_block(tp, block);
+	payload = (uintptr_t)&block->next_free;
+	addr = (payload + align - 1) & ~((uintptr_t)align - 1);
+	if (addr != payload && addr - payload < gap_min)
+		addr = (payload + gap_min + align - 1) & ~((uintptr_t)align - 1);
+
+	gap = (size_t)(addr - payload);
+	if (gap != 0) {
+		aligned = container_of((void *)addr, struct tlsf_block, next_free);
+		aligned->prev_phys = block;
+		aligned->size = tlsf_block_size(block) - gap;
+		tlsf_block_next(aligned)->prev_phys = aligned;
+		block->size = gap - TLSF_BLOCK_HDR_SIZE;
+		tlsf_insert_block(tp, block);
+		block = aligned;
+	}
+
+	tlsf_split(tp, block, size);
+	tlsf_account(tp, block);
+	tlsf_unlock(tp);
+
+	return (void *)addr;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_get_free_bytes
+ *
+ * Description:
+ *   Get the remaining memory of the memory block interface.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *
+ * Return:
+ *   remaining size of memory pool.
+ ************************************************************************************/
+size_t pl_mempool_get_free_bytes(pl_mempool_handle_t mempool)
+{
+	size_t free_bytes;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL)
+		return 0;
+
+	tlsf_lock(tp);
+	free_bytes = tp->free_bytes;
+	tlsf_unlock(tp);
+
+	return free_bytes;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_get_stats
+ *
+ * Description:
+ *   Get statistics of memory pool, the free blocks are counted by walking the
+ *   blocks in memory.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @stats: statistics wanted to get.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mempool_get_stats(pl_mempool_handle_t mempool, struct pl_mempool_stats *stats)
+{
+	struct tlsf_block *block;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || stats == NULL)
+		return -EFAULT;
+
+	stats->largest_free = 0;
+	stats->free_frags = 0;
+
+	tlsf_lock(tp);
+	for (block = (struct tlsf_block *)tp->start; tlsf_block_size(block) != 0;
+	     block = tlsf_block_next(block)) {
+		if ((block->size & TLSF_BLOCK_FREE) == 0)
+			continue;
+
+		stats->free_frags++;
+		stats->largest_free = max(stats->largest_free, tlsf_block_size(block));
+	}
+
+	stats->total_bytes = tp->total_bytes;
+	stats->free_bytes = tp->free_bytes;
+	stats->peak_used = tp->peak_used;
+	stats->nr_allocs = tp->nr_allocs;
+	stats->nr_fails = tp->nr_fails;
+	tlsf_unlock(tp);
+
+	return OK;
+}
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+/*************************************************************************************
+ * Function Name: tlsf_walk
+ *
+ * Description:
+ *   Walk the used blocks in memory. walk is called for each block if it is not
+ *   NULL, otherwise the blocks of owner are freed (free_owner) or given to system.
+ *
+ * Param:
+ *   @tp: pool, it is locked.
+ *   @walk: callback.
+ *   @arg: argument of callback.
+ *   @owner: owner to free or disown.
+ *   @free_owner: free the blocks of owner.
+ *
+ * Return:
+ *   the number of blocks of owner.
+ ************************************************************************************/
+static size_t tlsf_walk(struct tlsf_pool *tp, pl_mempool_walk_t walk, void *arg,
+                        void *owner, bool free_owner)
+{
+	size_t freed = 0;
+	struct tlsf_block *block;
+
+	for (block = (struct tlsf_block *)tp->start; tlsf_block_size(block) != 0;
+	     block = tlsf_block_next(block)) {
+		if (block->size & TLSF_BLOCK_FREE)
+			continue;
+
+		if (walk != NULL) {
+			walk(&block->next_free, tlsf_block_size(block), block->owner, arg);
+		} else if (block->owner == owner) {
+			if (free_owner)
+				block = tlsf_free_block(tp, block);
+			else
+				block->owner = NULL;
+
+			freed++;
+		}
+	}
+
+	return freed;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_walk
+ *
+ * Description:
+ *   Call walk for each allocation of memory pool.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @walk: callback.
+ *   @arg: argument of callback.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mempool_walk(pl_mempool_handle_t mempool, pl_mempool_walk_t walk, void *arg)
+{
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || walk == NULL)
+		return -EFAULT;
+
+	tlsf_lock(tp);
+	tlsf_walk(tp, walk, arg, NULL, false);
+	tlsf_unlock(tp);
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_set_owner
+ *
+ * Description:
+ *   Change the owner of memory.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @p: memory address.
+ *   @owner: new owner.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_mempool_set_owner(pl_mempool_handle_t mempool, void *p, void *owner)
+{
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || p == NULL || (uchar_t *)p < tp->start || (uchar_t *)p >= tp->end)
+		return;
+
+	container_of(p, struct tlsf_block, next_free)->owner = owner;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mempool_free_owner
+ *
+ * Description:
+ *   Free all memory of owner.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ *
+ * Return:
+ *   the number of allocations freed.
+ ************************************************************************************/
+size_t pl_mempool_free_owner(pl_mempool_handle_t mempool, void *owner)
+{
+	size_t freed;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL)
+		return 0;
+
+	tlsf_lock(tp);
+	freed = tlsf_walk(tp, NULL, NULL, owner, true);
+	tlsf_unlock(tp);
+
+	return freed;
+}
+/*************************************************************************************
+ * Function Name: pl_mempool_disown
+ *
+ * Description:
+ *   Give all memory of owner to system, such as the memory left by an exited task.
+ *
+ * Param:
+ *   @mempool: memory pool.
+ *   @owner: owner, the task id.
+ *
+ * Return:
+ *   the number of allocations given to system.
+ ************************************************************************************/
+size_t pl_mempool_disown(pl_mempool_handle_t mempool, void *owner)
+{
+	size_t n;
+	struct tlsf_pool *tp = (struct tlsf_pool *)mempool;
+
+	if (tp == NULL || owner == NULL)
+		return 0;
+
+	tlsf_lock(tp);
+	n = tlsf_walk(tp, NULL, NULL, owner, false);
+	tlsf_unlock(tp);
+
+	return n;
+}
+#endif
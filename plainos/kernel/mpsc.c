@@ -0,0 +1,172 @@
+/*
+MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <errno.h>
+#include <types.h>
+#include <port/port.h>
+#include <kernel/kernel.h>
+#include <kernel/mpsc.h>
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_init
+ * Description: initialize a mpsc ring, slot i is free for the position i.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *   @slots: slots of ring.
+ *   @nr_slots: count of slots, MUST BE a power of 2.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_mpsc_init(struct pl_mpsc *mpsc, struct pl_mpsc_slot *slots, uint_t nr_slots)
+{
+	uint_t i;
+
+	if (mpsc == NULL || slots == NULL)
+		return -EFAULT;
+
+	if (!pl_is_power_of_2(nr_slots))
+		return -EINVAL;
+
+	for (i = 0; i < nr_slots; i++) {
+		slots[i].seq = i;
+		slots[i].data = NULL;
+	}
+
+	mpsc->slots = slots;
+	mpsc->mask = nr_slots - 1;
+	mpsc->in = 0;
+	mpsc->out = 0;
+	pl_port_cpu_dmb();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_push
+ * Description: push an entry to the ring.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *   @data: the entry, it must not be NULL.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, -EFULL if the ring is full.
+ ************************************************************************************/
+int pl_mpsc_push(struct pl_mpsc *mpsc, void *data)
+{
+	int diff;
+	uint_t pos;
+	uint_t seq;
+	struct pl_mpsc_slot *slot;
+
+	if (mpsc == NULL || data == NULL)
+		return -EFAULT;
+
+	pos = mpsc->in;
+	while (true) {
+		slot = &mpsc->slots[pos & mpsc->mask];
+		seq = slot->seq;
+		pl_port_cpu_dmb();
+		diff = (int)(seq - pos);
+
+		/* the slot is free for pos, try to claim it */
+		if (diff == 0) {
+			seq = pl_port_atomic_cmpxchg(&mpsc->in, pos, pos + 1);
+			if (seq == pos)
+				break;
+
+			pos = seq;
+			continue;
+		}
+
+		/* the slot still holds the entry of the last round */
+		if (diff < 0)
+			return -EFULL;
+
+		/* another producer claimed pos */
+		pos = mpsc->in;
+	}
+
+	slot->data = data;
+	/* the consumer sees the entry before the sequence */
+	pl_port_cpu_dmb();
+	slot->seq = pos + 1;
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_pop
+ * Description: pop an entry from the ring.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *
+ * Return:
+ *   the entry, NULL if the ring is empty or its first slot is not filled yet.
+ ************************************************************************************/
+void *pl_mpsc_pop(struct pl_mpsc *mpsc)
+{
+	void *data;
+	uint_t pos;
+	struct pl_mpsc_slot *slot;
+
+	if (mpsc == NULL)
+		return NULL;
+
+	pos = mpsc->out;
+	slot = &mpsc->slots[pos & mpsc->mask];
+	if (slot->seq != pos + 1)
+		return NULL;
+
+	pl_port_cpu_dmb();
+	data = slot->data;
+	mpsc->out = pos + 1;
+
+	/* the slot is free for the position of the next round */
+	pl_port_cpu_dmb();
+	slot->seq = pos + mpsc->mask + 1;
+
+	return data;
+}
+
+/*************************************************************************************
+ * Function Name: pl_mpsc_len
+ * Description: get the count of positions claimed and not popped.
+ *
+ * Param:
+ *   @mpsc: mpsc handle.
+ *
+ * Return:
+ *   count of entries.
+ ************************************************************************************/
+uint_t pl_mpsc_len(struct pl_mpsc *mpsc)
+{
+	if (mpsc == NULL)
+		return 0;
+
+	return mpsc->in - mpsc->out;
+}
@@ -0,0 +1,475 @@
+/*
+MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <config.h>
+#include <errno.h>
+#include <port/port.h>
+#include <kernel/list.h>
+#include <kernel/kernel.h>
+#include <kernel/kfifo.h>
+#include <kernel/pipe.h>
+#include "task.h"
+
+/*************************************************************************************
+ * Structure Name: pipe_waiter
+ * Description: a task waiting on the pipe, it lives in the stack of the task and
+ *              pl_task_kill() unlinks it through tcb->wait_node.
+ *
+ * Members:
+ *   @node: node of the readers or writers list.
+ *   @tcb: the waiting task.
+ *   @want: count of bytes (readers) or free bytes (writers) to wake the task.
+ ************************************************************************************/
+struct pipe_waiter {
+	struct list_node node;
+	struct tcb *tcb;
+	uint_t want;
+};
+
+/*************************************************************************************
+ * Function Name: pl_pipe_init
+ * Description: initialize a pipe over a kfifo.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @fifo: initialized kfifo.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_pipe_init(struct pl_pipe *pipe, struct pl_kfifo *fifo)
+{
+	if (pipe == NULL || fifo == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	pipe->fifo = fifo;
+	list_init(&pipe->readers);
+	list_init(&pipe->writers);
+	pipe->read_wake = 1;
+	pipe->write_wake = 1;
+	pipe->delim = PL_PIPE_NO_DELIM;
+	pipe->delim_in = fifo->out;
+	pipe->delim_pending = false;
+	pipe->latency = 0;
+	pipe->first_ticks = 0;
+	pipe->nr_wakeups = 0;
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_pipe_set_read_wake
+ * Description: set when the readers are woken.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @wake_len: count of bytes in the kfifo, at least 1.
+ *   @delim: delimiter character, PL_PIPE_NO_DELIM if none.
+ *   @latency: ticks the first byte may wait, 0 if it waits for the others.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_pipe_set_read_wake(struct pl_pipe *pipe, uint_t wake_len, int delim,
+                          u32_t latency)
+{
+	if (pipe == NULL)
+		return -EFAULT;
+
+	if (wake_len == 0 || wake_len > pipe->fifo->size)
+		return -EINVAL;
+
+	pl_port_enter_critical();
+	pipe->read_wake = wake_len;
+	pipe->delim = delim;
+	pipe->delim_in = pipe->fifo->out;
+	pipe->delim_pending = false;
+	pipe->latency = latency;
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_pipe_set_write_wake
+ * Description: set how many bytes must be free to wake the writers.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @wake_len: count of free bytes in the kfifo, at least 1.
+ *
+ * Return:
+ *   Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_pipe_set_write_wake(struct pl_pipe *pipe, uint_t wake_len)
+{
+	if (pipe == NULL)
+		return -EFAULT;
+
+	if (wake_len == 0 || wake_len > pipe->fifo->size)
+		return -EINVAL;
+
+	pl_port_enter_critical();
+	pipe->write_wake = wake_len;
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pipe_deadline
+ * Description: get the ticks when a timeout expires.
+ *
+ * Param:
+ *   @now: ticks of now.
+ *   @timeout: ticks to wait, PL_PIPE_NOWAIT or PL_PIPE_WAIT_FOREVER.
+ *
+ * Return:
+ *   ticks of deadline.
+ ************************************************************************************/
+static u64_t pipe_deadline(u64_t now, u32_t timeout)
+{
+	if (timeout == PL_PIPE_WAIT_FOREVER)
+		return UINT64_MAX;
+
+	return now + timeout;
+}
+
+/*************************************************************************************
+ * Function Name: pipe_readable
+ * Description: check if a reader can be woken, it must be called in critical area.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @want: count of bytes the reader waits for.
+ *
+ * Return:
+ *   true if the watermark is reached or a delimiter is in.
+ ************************************************************************************/
+static bool pipe_readable(struct pl_pipe *pipe, uint_t want)
+{
+	if (pl_kfifo_len(pipe->fifo) >= want)
+		return true;
+
+	return pipe->delim != PL_PIPE_NO_DELIM && pipe->delim_pending;
+}
+
+/*************************************************************************************
+ * Function Name: pipe_sleep
+ * Description: put the current task to sleep on a list of the pipe until it is
+ *              woken or the deadline, it must be called in critical area.
+ *
+ * Param:
+ *   @list: readers or writers list.
+ *   @waiter: waiter of current task.
+ *   @deadline: ticks to wake the task anyway.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void pipe_sleep(struct list_node *list, struct pipe_waiter *waiter,
+                       u64_t deadline)
+{
+	struct tcb *curr_tcb;
+
+	/* the delay list holds the task, so the tick wakes it on timeout */
+	curr_tcb = pl_task_get_curr_tcb();
+	waiter->tcb = curr_tcb;
+	list_add_node_at_tail(list, &waiter->node);
+	curr_tcb->wait_node = &waiter->node;
+	curr_tcb->delay_ticks = deadline;
+	pl_task_remove_tcb_from_rdylist(curr_tcb);
+	pl_task_insert_tcb_to_delaylist(curr_tcb);
+
+	pl_port_exit_critical();
+	pl_task_context_switch();
+	pl_port_enter_critical();
+
+	curr_tcb->wait_node = NULL;
+	list_del_node(&waiter->node);
+}
+
+/*************************************************************************************
+ * Function Name: pipe_wake
+ * Description: wake a sleeping task of the pipe, it must be called in critical area.
+ *
+ * Param:
+ *   @tcb: task to wake.
+ *
+ * Return:
+ *   true if the task is woken, false if it was ready already.
+ ************************************************************************************/
+static bool pipe_wake(struct tcb *tcb)
+{
+	if (tcb->curr_state != PL_TASK_STATE_DELAY)
+		return false;
+
+	pl_task_remove_tcb_from_delaylist(tcb);
+	pl_task_insert_tcb_to_rdylist(tcb);
+	return true;
+}
+
+/*************************************************************************************
+ * Function Name: pipe_wake_writers
+ * Description: wake the writers which have enough free space, it must be called in
+ *              critical area.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *
+ * Return:
+ *   true if any writer is woken.
+ ************************************************************************************/
+static bool pipe_wake_writers(struct pl_pipe *pipe)
+{
+	uint_t free_len;
+	bool woken = false;
+	struct pipe_waiter *pos;
+
+	free_len = pipe->fifo->size - pl_kfifo_len(pipe->fifo);
+	list_for_each_entry(pos, &pipe->writers, struct pipe_waiter, node) {
+		if (free_len >= pos->want)
+			woken |= pipe_wake(pos->tcb);
+	}
+
+	return woken;
+}
+
+/*************************************************************************************
+ * Function Name: pipe_put_done
+ * Description: account the characters just put and wake the readers, it must be
+ *              called in critical area.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @chars: the characters put, they end at the in index of the kfifo.
+ *   @len: length of characters.
+ *
+ * Return:
+ *   true if any reader is woken.
+ ************************************************************************************/
+static bool pipe_put_done(struct pl_pipe *pipe, const char *chars, uint_t len)
+{
+	uint_t i;
+	u64_t now;
+	u64_t wake_at;
+	bool woken = false;
+	bool first = false;
+	struct pipe_waiter *pos;
+
+	if (len == 0)
+		return false;
+
+	/* only the last delimiter is kept, the readers get all before it */
+	if (pipe->delim != PL_PIPE_NO_DELIM) {
+		for (i = len; i > 0; i--) {
+			if (chars[i - 1] == (char)pipe->delim) {
+				pipe->delim_in = pipe->fifo->in - len + i;
+				pipe->delim_pending = true;
+				break;
+			}
+		}
+	}
+
+	pl_task_get_syscount(&now);
+	if (pl_kfifo_len(pipe->fifo) == len) {
+		pipe->first_ticks = now;
+		first = true;
+	}
+
+	list_for_each_entry(pos, &pipe->readers, struct pipe_waiter, node) {
+		if (pipe_readable(pipe, pos->want)) {
+			woken |= pipe_wake(pos->tcb);
+			continue;
+		}
+
+		/* the first byte must not wait longer than latency for the others */
+		wake_at = now + pipe->latency;
+		if (!first || pipe->latency == 0 ||
+		    pos->tcb->curr_state != PL_TASK_STATE_DELAY ||
+		    pos->tcb->delay_ticks <= wake_at)
+			continue;
+
+		pl_task_remove_tcb_from_delaylist(pos->tcb);
+		pos->tcb->delay_ticks = wake_at;
+		pl_task_insert_tcb_to_delaylist(pos->tcb);
+	}
+
+	return woken;
+}
+
+/*************************************************************************************
+ * Function Name: pl_pipe_read
+ * Description: read the pipe.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @data: buffer of data.
+ *   @len: length of buffer, a reader never waits for more than it.
+ *   @timeout: ticks to wait, PL_PIPE_NOWAIT or PL_PIPE_WAIT_FOREVER.
+ *
+ * Return:
+ *   count of bytes read, -EAGAIN if the pipe is empty and timeout is
+ *   PL_PIPE_NOWAIT, -ETIMEOUT if it is still empty when the timeout expires.
+ ************************************************************************************/
+int pl_pipe_read(struct pl_pipe *pipe, char *data, uint_t len, u32_t timeout)
+{
+	u64_t now;
+	u64_t deadline;
+	u64_t wake_at;
+	uint_t ret;
+	bool woken;
+	struct pipe_waiter waiter;
+
+	if (pipe == NULL || data == NULL)
+		return -EFAULT;
+
+	if (len == 0)
+		return 0;
+
+	waiter.want = min(len, pipe->read_wake);
+	pl_port_enter_critical();
+	pl_task_get_syscount(&now);
+	deadline = pipe_deadline(now, timeout);
+	while (true) {
+		while (!pipe_readable(pipe, waiter.want)) {
+			wake_at = deadline;
+			if (pl_kfifo_len(pipe->fifo) != 0 && pipe->latency != 0)
+				wake_at = min(wake_at, pipe->first_ticks + pipe->latency);
+
+			if (now >= wake_at)
+				break;
+
+			pipe_sleep(&pipe->readers, &waiter, wake_at);
+			++pipe->nr_wakeups;
+			pl_task_get_syscount(&now);
+		}
+
+		ret = pl_kfifo_get(pipe->fifo, data, len);
+
+		/* retire the delimiter once it is got, the indexes wrap at 64 KB on avr */
+		if (pipe->delim_pending && (int)(pipe->delim_in - pipe->fifo->out) <= 0)
+			pipe->delim_pending = false;
+
+		/* a reader waiting forever never returns empty-handed */
+		if (ret != 0 || timeout != PL_PIPE_WAIT_FOREVER)
+			break;
+	}
+
+	woken = pipe_wake_writers(pipe);
+	pl_port_exit_critical();
+
+	if (woken)
+		pl_task_context_switch();
+
+	if (ret == 0)
+		return timeout == PL_PIPE_NOWAIT ? -EAGAIN : -ETIMEOUT;
+
+	return (int)ret;
+}
+
+/*************************************************************************************
+ * Function Name: pl_pipe_write
+ * Description: write the pipe.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @data: data to write.
+ *   @len: length of data.
+ *   @timeout: ticks to wait, PL_PIPE_NOWAIT or PL_PIPE_WAIT_FOREVER.
+ *
+ * Return:
+ *   count of bytes written, -EAGAIN if the pipe is full and timeout is
+ *   PL_PIPE_NOWAIT, -ETIMEOUT if it is still full when the timeout expires.
+ ************************************************************************************/
+int pl_pipe_write(struct pl_pipe *pipe, const char *data, uint_t len, u32_t timeout)
+{
+	u64_t now;
+	u64_t deadline;
+	uint_t put;
+	uint_t done = 0;
+	bool woken = false;
+	struct pipe_waiter waiter;
+
+	if (pipe == NULL || data == NULL)
+		return -EFAULT;
+
+	if (len == 0)
+		return 0;
+
+	pl_port_enter_critical();
+	pl_task_get_syscount(&now);
+	deadline = pipe_deadline(now, timeout);
+	while (true) {
+		put = pl_kfifo_put(pipe->fifo, (char *)data + done, len - done);
+		woken |= pipe_put_done(pipe, data + done, put);
+		done += put;
+		if (done == len || now >= deadline)
+			break;
+
+		/* the readers woken above run while the writer sleeps */
+		waiter.want = min(len - done, pipe->write_wake);
+		pipe_sleep(&pipe->writers, &waiter, deadline);
+		woken = false;
+		pl_task_get_syscount(&now);
+	}
+	pl_port_exit_critical();
+
+	if (woken)
+		pl_task_context_switch();
+
+	if (done == 0)
+		return timeout == PL_PIPE_NOWAIT ? -EAGAIN : -ETIMEOUT;
+
+	return (int)done;
+}
+
+/*************************************************************************************
+ * Function Name: pl_pipe_notify
+ * Description: tell the pipe that characters were put into its kfifo directly.
+ *
+ * Param:
+ *   @pipe: pipe handle.
+ *   @chars: the characters put, they end at the in index of the kfifo.
+ *   @len: length of characters.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+void pl_pipe_notify(struct pl_pipe *pipe, const char *chars, uint_t len)
+{
+	bool woken;
+
+	if (pipe == NULL || chars == NULL)
+		return;
+
+	pl_port_enter_critical();
+	woken = pipe_put_done(pipe, chars, len);
+	pl_port_exit_critical();
+
+	if (woken)
+		pl_task_context_switch();
+}
@@ -26,12 +26,13 @@ SOFTWARE.
 #include <errno.h>
 #include <config.h>
 #include <appcall.h>
-#include <string.h>
+#include <lib/string.h>
 #include <kernel/task.h>
 #include <kernel/syslog.h>
 #include <kernel/initcall.h>
 #include <kernel/mempool.h>
 #include <kernel/workqueue.h>
+#include <kernel/pipe.h>
 #include <drivers/serial/serial.h>
 
 #define ASCLL_ENTER                    13
@@ -41,6 +42,11 @@ SOFTWARE.
 #define ANSI_BACKSPACE                 "\033[P"
 #define SERIAL_PROCESS_NOT_CALL        (-1)
 
+/* a typed character is echoed within PLSH_READ_LATENCY_US, a paste wakes the
+ * shell once per PLSH_READ_WAKE_CHARS characters or line */
+#define PLSH_READ_WAKE_CHARS           (16)
+#define PLSH_READ_LATENCY_US           (2000)
+
 enum cmd_parse_state {
 	CMD_PARSE_STATE_ERR = -1,
 	CMD_PARSE_STATE_INIT = 0,
@@ -59,6 +65,7 @@ struct pl_shell {
 	int cmd_buffer_idx;
 	pl_tid_t cmd_task;
 	struct pl_serial_desc *desc;
+	struct pl_pipe pipe;
 	char *cmd_argv[CONFIG_PL_SHELL_CMD_ARGC_MAX];
 	char cmd_buffer[CONFIG_PL_SHELL_CMD_BUFF_MAX];
 };
@@ -75,7 +82,7 @@ static struct pl_app_entry *plsh_find_app_entry(char *name)
 	struct pl_app_entry *entry;
 
 	for (entry = __appcall_start; entry < __appcall_end; entry++) {
-		if (strcmp(entry->name, name) == 0) {
+		if (pl_strcmp(entry->name, name) == 0) {
 			return entry;
 		}
 	}
@@ -196,9 +203,48 @@ static void plsh_cmd_reset(	struct pl_shell *sh)
 	sh->state = CMD_PARSE_STATE_INIT;
 }
 /*************************************************************************************
- * @breaf: exec the cmd.
+ * @breaf: exec the cmd in the buffer.
  *
- * @param work: work to be executed.
+ * @param sh: the shell.
+ *
+ * @return none.
+ ************************************************************************************/
+static void plsh_exec_cmd(struct pl_shell *sh)
+{
+	int ret;
+	struct pl_app_entry *app_entry;
+
+	/* get argvs */
+	ret = plsh_get_argvs_from_buffer(sh->cmd_buffer, sh->cmd_argc, sh->cmd_argv);
+	if (ret < 0) {
+		plsh_cmd_reset(sh);
+		pl_early_syslog(CONFIG_PL_SHELL_PREFIX_NAME"# ");
+		return;
+	}
+
+	/* find the app entry */
+	app_entry = plsh_find_app_entry(sh->cmd_argv[0]);
+	if (app_entry == NULL) {
+		pl_early_syslog_err("%s not found\r\n", sh->cmd_argv[0]);
+		pl_early_syslog(CONFIG_PL_SHELL_PREFIX_NAME"# ");
+		plsh_cmd_reset(sh);
+		return;
+	}
+
+	/* exec the cmd */
+	ret = app_entry->entry(sh->cmd_argc, sh->cmd_argv);
+	if (ret < 0)
+		pl_early_syslog_err("app[%s] exec cmd failed, ret:%d\r\n", app_entry->name, ret);
+
+	plsh_cmd_reset(sh);
+	pl_early_syslog(CONFIG_PL_SHELL_PREFIX_NAME"# ");
+}
+
+/*************************************************************************************
+ * @breaf: the task reading the cmd from the pipe and executing it.
+ *
+ * @param argc: unused.
+ * @param argv: unused.
  *
  * @return none.
  ************************************************************************************/
@@ -206,54 +252,20 @@ static int plsh_exec_cmd_task(int argc, char *argv[])
 {
 	USED(argc);
 	USED(argv);
+	int i;
 	int ret;
-	char recv_ch;
-	struct pl_app_entry *app_entry;
-	struct pl_kfifo *recv_fifo = &(plsh.desc->recv_info.fifo);
+	char recv_chars[PLSH_READ_WAKE_CHARS];
 
 	pl_early_syslog(CONFIG_PL_SHELL_PREFIX_NAME"# ");
 	plsh_cmd_reset(&plsh);
 	while (true) {
-		if (pl_kfifo_len(recv_fifo) == 0) {
-			pl_task_pend(NULL);
-			continue;
+		/* wait until the pipe has a line, enough chars or the latency expires */
+		ret = pl_pipe_read(&plsh.pipe, recv_chars, sizeof(recv_chars),
+		                   PL_PIPE_WAIT_FOREVER);
+		for (i = 0; i < ret; i++) {
+			if (plsh_process_received_chars(&plsh, recv_chars[i]) == ASCLL_ENTER)
+				plsh_exec_cmd(&plsh);
 		}
-
-		/* get char from recv_fifo */
-		recv_ch = recv_fifo->buff[recv_fifo->out & (recv_fifo->size - 1)];
-		pl_port_enter_critical();
-		recv_fifo->out++;
-		pl_port_exit_critical();
-
-		/* process char */
-		ret = plsh_process_received_chars(&plsh, recv_ch);
-		if (ret != ASCLL_ENTER)
-			continue;
-
-		/* get argvs */
-		ret = plsh_get_argvs_from_buffer(plsh.cmd_buffer, plsh.cmd_argc, plsh.cmd_argv);
-		if (ret < 0) {
-			plsh_cmd_reset(&plsh);
-			pl_early_syslog(CONFIG_PL_SHELL_PREFIX_NAME"# ");
-			continue;
-		}
-
-		/* find the app entry */
-		app_entry = plsh_find_app_entry(plsh.cmd_argv[0]);
-		if (app_entry == NULL) {
-			pl_early_syslog_err("%s not found\r\n", plsh.cmd_argv[0]);
-			pl_early_syslog(CONFIG_PL_SHELL_PREFIX_NAME"# ");
-			plsh_cmd_reset(&plsh);
-			continue;
-		}
-
-		/* exec the cmd */
-		ret = app_entry->entry(plsh.cmd_argc, plsh.cmd_argv);
-		if (ret < 0)
-			pl_early_syslog_err("app[%s] exec cmd failed, ret:%d\r\n", app_entry->name, ret);
-
-		plsh_cmd_reset(&plsh);
-		pl_early_syslog(CONFIG_PL_SHELL_PREFIX_NAME"# ");
 	}
 
 	return -EUNKNOWE;
@@ -270,8 +282,9 @@ static int plsh_exec_cmd_task(int argc, char *argv[])
  ************************************************************************************/
 static int plsh_recv_process(struct pl_kfifo *recv_fifo, char *chars, uint_t chars_len)
 {
-	pl_kfifo_put(recv_fifo, chars, chars_len);
-	pl_task_resume(plsh.cmd_task);
+	USED(recv_fifo);
+	/* the characters are in recv_fifo already, the pipe decides the wakeup */
+	pl_pipe_notify(&plsh.pipe, chars, chars_len);
 	return SERIAL_PROCESS_NOT_CALL;
 }
 /*************************************************************************************
@@ -293,6 +306,10 @@ static int pl_shell_init(void)
 		return OK;
 	}
 
+	/* the pipe reads the receiving fifo of serial in place */
+	pl_pipe_init(&plsh.pipe, &serial->recv_info.fifo);
+	pl_pipe_set_read_wake(&plsh.pipe, PLSH_READ_WAKE_CHARS, ASCLL_ENTER,
+	                      PLSH_READ_LATENCY_US / CONFIG_PL_SYSTICK_TIME_SLICE_US);
 	ret = pl_serial_register_recv_process(serial, plsh_recv_process);
 	if (ret < 0) {
 		pl_syslog_err("serial register failed, ret:%d\r\n", ret);
@@ -26,35 +26,84 @@ SOFTWARE.
 #include <config.h>
 #include <port/port.h>
 #include <kernel/mempool.h>
+#include <kernel/kmem_cache.h>
 #include <kernel/syslog.h>
 #include <kernel/initcall.h>
 #include "softtimer.h"
 #include "task.h"
 
 static struct pl_stimer_ctrl pl_stimer_ctrl;
+static struct pl_kmem_cache *stimer_cache;
 
 /*************************************************************************************
- * Function Name: softtimer_consume_node
+ * Function Name: softtimer_take_expired
  *
  * Description:
- *   consume a node of softtimer.
+ *   take the first timer expired from the daemon list, the others stay on it so
+ *   that pl_softtimer_cancel() can unlink them until they are taken.
  * 
  * Parameters:
- *  @first: the first of softtimer list node.
+ *  none.
  *
  * Return:
- *  callback function of softtimer.
+ *  the timer taken, NULL if the list is empty.
  ************************************************************************************/
-static pl_stimer_fun_t softtimer_consume_node(struct pl_stimer *first)
+static struct pl_stimer *softtimer_take_expired(void)
 {
+	struct pl_stimer *timer = NULL;
+
+	pl_port_enter_critical();
+	if (!list_is_empty(&pl_stimer_ctrl.head)) {
+		timer = list_first_entry(&pl_stimer_ctrl.head, struct pl_stimer, node);
+		list_del_node(&timer->node);
+		list_init(&timer->node);
+		/* the timer belongs to the daemon now, pl_softtimer_cancel() only marks it */
+		timer->expired = true;
+	}
+	pl_port_exit_critical();
+
+	return timer;
+}
+
+/*************************************************************************************
+ * Function Name: softtimer_run_expired
+ *
+ * Description:
+ *   call the timer taken by the daemon, or a hard timer in the systick handler,
+ *   and start it again if it is a reload timer.
+ * 
+ * Parameters:
+ *  @timer: the timer taken.
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+static void softtimer_run_expired(struct pl_stimer *timer)
+{
+	u64_t last;
+	u64_t syscount;
 	pl_stimer_fun_t stimer_fun;
 
-	list_del_node(&first->node);
-	list_init(&first->node);
-	stimer_fun = first->fun;
-	first->fun = NULL;
+	list_init(&timer->node);
+	last = timer->reach_cnt;
+	stimer_fun = timer->fun;
+	if (!timer->reload)
+		timer->fun = NULL;
+	timer->expired = false;
+
+	/* call callback */
+	if (stimer_fun != NULL)
+		stimer_fun(timer);
 
-	return stimer_fun;
+	/* reload softtimer from its last deadline, unless it was started in callback */
+	pl_port_enter_critical();
+	if (timer->reload && timer->fun != NULL && timer->timing_cnt != 0 &&
+	    list_is_empty(&timer->node)) {
+		pl_task_get_syscount(&syscount);
+		timer->overruns += pl_timer_wheel_add_periodic(&pl_stimer_ctrl.wheel, timer,
+		                                               last, syscount);
+	}
+	pl_port_exit_critical();
 }
 
 /*************************************************************************************
@@ -73,38 +122,18 @@ static int softtimer_daemon_task(int argc, char **argv)
 {
 	USED(argc);
 	USED(argv);
-	bool is_empty;
-	struct pl_stimer *first;
-	pl_stimer_fun_t stimer_fun;
+	struct pl_stimer *timer;
 
 	while (true) {
-		/* get the timer_ctrl_list status */
-		pl_port_enter_critical();
-		is_empty = list_is_empty(&pl_stimer_ctrl.head);
-		pl_port_exit_critical();
-
 		/* if list of softtimer is empty, we need to suspend daemon task */
-		if (is_empty) {
+		timer = softtimer_take_expired();
+		if (timer == NULL) {
 			pl_task_pend(NULL);
 			continue;
 		}
 
-		/* get the first node from the softtimer list */
-		pl_port_enter_critical();
-		first = list_first_entry(&pl_stimer_ctrl.head, struct pl_stimer, node);
-		stimer_fun = softtimer_consume_node(first);
-		pl_port_exit_critical();
-
-		/* call callback */
-		if (stimer_fun != NULL)
-			stimer_fun(first);
-
-		/* reload softtimer */
-		if (first->reload) {
-			pl_softtimer_timer_init(first, first->fun, first->timing_cnt,
-			                        first->priv_data);
-			pl_softtimer_start(first);
-		}
+		/* the timers are taken in the order of their deadlines */
+		softtimer_run_expired(timer);
 	}
 
 	return 0;
@@ -126,13 +155,18 @@ struct pl_stimer *pl_softtimer_request(const char *name)
 {
 	struct pl_stimer *timer;
 
-	timer = pl_mempool_malloc(g_pl_default_mempool, sizeof(struct pl_stimer));
+	timer = pl_kmem_cache_alloc(stimer_cache);
 	if (timer == NULL) {
 		return NULL;
 	}
 
 	timer->name = name;
+	timer->fun = NULL;
+	timer->slack_mask = 0;
+	timer->overruns = 0;
 	timer->reload = false;
+	timer->expired = false;
+	timer->hard = false;
 	list_init(&timer->node);
 
 	return timer;
@@ -163,6 +197,61 @@ int pl_softtimer_get_private_data(struct pl_stimer *timer, void **data)
 	return OK;
 }
 
+/*************************************************************************************
+ * Function Name: pl_softtimer_get_overruns
+ *
+ * Description:
+ *   get the count of periods skipped by a reload timer.
+ * 
+ * Parameters:
+ *  @timer: handle of soft timer requested.
+ *  @overruns: count of periods skipped since the timer was started.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_softtimer_get_overruns(struct pl_stimer *timer, u32_t *overruns)
+{
+	if (timer == NULL || overruns == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	*overruns = timer->overruns;
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_softtimer_set_hard
+ *
+ * Description:
+ *   call the callback of soft timer in the systick handler or by the daemon task.
+ * 
+ * Parameters:
+ *  @timer: handle of soft timer requested.
+ *  @hard: call the callback in the systick handler whether or not.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_softtimer_set_hard(struct pl_stimer *timer, bool hard)
+{
+	int ret = OK;
+
+	if (timer == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	if (timer->expired || !list_is_empty(&timer->node))
+		ret = -EBUSY;
+	else
+		timer->hard = hard;
+	pl_port_exit_critical();
+
+	return ret;
+}
+
 /*************************************************************************************
  * Function Name: pl_softtimer_timer_init
  *
@@ -185,6 +274,7 @@ void pl_softtimer_timer_init(struct pl_stimer *stimer, pl_stimer_fun_t fun,
 	stimer->priv_data = priv_data;
 	stimer->timing_cnt = timing_cnt;
 	stimer->reach_cnt = 0;
+	stimer->slack_mask = 0;
 }
 
 /*************************************************************************************
@@ -202,8 +292,6 @@ void pl_softtimer_timer_init(struct pl_stimer *stimer, pl_stimer_fun_t fun,
 int pl_softtimer_start(struct pl_stimer *timer)
 {
 	u64_t syscount;
-	struct pl_stimer *pos;
-	struct list_node *timer_list;
 
 	if (timer == NULL)
 		return -EFAULT;
@@ -211,24 +299,13 @@ int pl_softtimer_start(struct pl_stimer *timer)
 	if (!list_is_empty(&timer->node))
 		return -EBUSY;
 
+	pl_port_enter_critical();
 	pl_task_get_syscount(&syscount);
 	timer->reach_cnt = syscount + timer->timing_cnt;
-	timer_list = pl_task_get_timer_list();
-
-	pl_port_enter_critical();
-	if (list_is_empty(timer_list)) {
-		list_add_node_at_tail(timer_list, &timer->node);
-		goto out;
-	}
-
-	list_for_each_entry(pos, timer_list, struct pl_stimer, node) {
-		if (timer->reach_cnt < pos->reach_cnt)
-			break;
-	}
-
-	list_add_node_ahead(&pos->node, &timer->node);
-out:
+	timer->overruns = 0;
+	pl_timer_wheel_add(&pl_stimer_ctrl.wheel, timer);
 	pl_port_exit_critical();
+
 	return OK;
 }
 
@@ -243,23 +320,49 @@ out:
  *  @reload: reload whether or not.
  *  @fun: callback function.
  *  @timing_cnt: the count of timing.
+ *  @slack_cnt: ticks the timer may expire late, 0 for an exact timer.
  *  @priv_data: private data.
  *
  * Return:
  *  Greater than or equal to 0 on success, less than 0 on failure.
  ************************************************************************************/
 int pl_softtimer_reload(struct pl_stimer *timer, bool reload, pl_stimer_fun_t fun,
-                                                u64_t timing_cnt, void *priv_data)
+                        u64_t timing_cnt, u64_t slack_cnt, void *priv_data)
 {
 	if (timer == NULL || fun == NULL || timing_cnt == 0)
 		return -EFAULT;
 
 	pl_softtimer_timer_init(timer, fun, timing_cnt, priv_data);
+	timer->slack_mask = pl_timer_wheel_slack_mask(slack_cnt);
 	timer->reload = reload;
 
 	return OK;
 }
 
+/*************************************************************************************
+ * Function Name: pl_softtimer_get_wakeups_saved
+ *
+ * Description:
+ *   get the count of expiries which shared the tick of another timer because of
+ *   their slack.
+ * 
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  count of wakeups saved.
+ ************************************************************************************/
+u32_t pl_softtimer_get_wakeups_saved(void)
+{
+	u32_t saved;
+
+	pl_port_enter_critical();
+	saved = pl_stimer_ctrl.nr_wakeups_saved;
+	pl_port_exit_critical();
+
+	return saved;
+}
+
 /*************************************************************************************
  * Function Name: pl_softtimer_cancel
  *
@@ -274,21 +377,25 @@ int pl_softtimer_reload(struct pl_stimer *timer, bool reload, pl_stimer_fun_t fu
  ************************************************************************************/
 int pl_softtimer_cancel(struct pl_stimer *timer)
 {
-	if (timer == NULL || timer->fun == NULL)
-		return -EFAULT;
+	int ret = OK;
 
-	if (list_is_empty(&timer->node))
-		return -EEMPTY;
+	if (timer == NULL)
+		return -EFAULT;
 
 	pl_port_enter_critical();
-	list_del_node(&timer->node);
-	pl_port_exit_critical();
+	/* the daemon drops a timer taken but not called, it is left in its list */
+	if (!timer->expired && !list_is_empty(&timer->node)) {
+		list_del_node(&timer->node);
+		list_init(&timer->node);
+	} else if (!timer->expired && !timer->reload) {
+		ret = -EEMPTY;
+	}
 
 	timer->fun = NULL;
 	timer->reload = false;
-	list_init(&timer->node);
+	pl_port_exit_critical();
 
-	return OK;
+	return ret;
 }
 
 /*************************************************************************************
@@ -308,7 +415,7 @@ void pl_softtimer_release(struct pl_stimer *timer)
 	if (timer == NULL)
 		return;
 
-	pl_mempool_free(g_pl_default_mempool, timer);
+	pl_kmem_cache_free(stimer_cache, timer);
 }
 
 /*************************************************************************************
@@ -328,6 +435,59 @@ struct pl_stimer_ctrl *pl_softtimer_get_ctrl(void)
 	return &pl_stimer_ctrl;
 }
 
+/*************************************************************************************
+ * Function Name: pl_softtimer_update
+ *
+ * Description:
+ *   call the hard timers expired, move the others to the daemon list and wake up
+ *   the daemon task, it is called by the systick handler in critical section.
+ * 
+ * Parameters:
+ *  @systicks: current systicks.
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+void pl_softtimer_update(u64_t systicks)
+{
+	bool wakeup = false;
+	uint_t nr_expired = 0;
+	uint_t nr_rounded = 0;
+	struct pl_stimer *timer;
+	struct list_node expired;
+
+	if (pl_stimer_ctrl.daemon == NULL)
+		return;
+
+	list_init(&expired);
+	pl_timer_wheel_advance(&pl_stimer_ctrl.wheel, systicks, &expired);
+
+	/* a timer rounded to this tick saves its own wakeup if it is not alone here */
+	list_for_each_entry(timer, &expired, struct pl_stimer, node) {
+		++nr_expired;
+		if (timer->reach_cnt & timer->slack_mask)
+			++nr_rounded;
+	}
+
+	if (nr_expired > 1)
+		pl_stimer_ctrl.nr_wakeups_saved += min(nr_rounded, nr_expired - 1);
+
+	while (!list_is_empty(&expired)) {
+		timer = container_of(list_del_front_node(&expired), struct pl_stimer, node);
+		/* a hard timer is called here, it may cancel the timers behind it */
+		if (timer->hard) {
+			softtimer_run_expired(timer);
+			continue;
+		}
+
+		list_add_node_at_tail(&pl_stimer_ctrl.head, &timer->node);
+		wakeup = true;
+	}
+
+	if (wakeup)
+		pl_task_resume(pl_stimer_ctrl.daemon);
+}
+
 /*************************************************************************************
  * Function Name: pl_softtimer_core_init
  *
@@ -342,7 +502,19 @@ struct pl_stimer_ctrl *pl_softtimer_get_ctrl(void)
  ************************************************************************************/
 static int pl_softtimer_core_init(void)
 {
+	u64_t syscount;
+
+	pl_task_get_syscount(&syscount);
 	list_init(&pl_stimer_ctrl.head);
+	pl_stimer_ctrl.nr_wakeups_saved = 0;
+	pl_timer_wheel_init(&pl_stimer_ctrl.wheel, syscount + 1);
+	stimer_cache = pl_kmem_cache_create("stimer", sizeof(struct pl_stimer), 0,
+	                                    g_pl_default_mempool);
+	if (stimer_cache == NULL) {
+		pl_syslog_err("soft timer cache create failed\r\n");
+		return -ENOMEM;
+	}
+
 	pl_stimer_ctrl.daemon = pl_task_sys_create("softtimer_daemon",
 	                        softtimer_daemon_task, 0,
 	                        CONFIG_PL_SOFTTIMER_DAEMON_TASK_STACK_SIZE, 0, NULL);
@@ -28,10 +28,13 @@ SOFTWARE.
 #include <kernel/task.h>
 #include <kernel/list.h>
 #include <kernel/softtimer.h>
+#include "timer_wheel.h"
 
 struct pl_stimer_ctrl {
 	pl_tid_t daemon;
 	struct list_node head;
+	struct pl_timer_wheel wheel;
+	u32_t nr_wakeups_saved;
 };
 
 /*************************************************************************************
@@ -48,4 +51,19 @@ struct pl_stimer_ctrl {
  ************************************************************************************/
 struct pl_stimer_ctrl *pl_softtimer_get_ctrl(void);
 
+/*************************************************************************************
+ * Function Name: pl_softtimer_update
+ *
+ * Description:
+ *   call the hard timers expired, move the others to the daemon list and wake up
+ *   the daemon task, it is called by the systick handler in critical section.
+ * 
+ * Parameters:
+ *  @systicks: current systicks.
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+void pl_softtimer_update(u64_t systicks);
+
 #endif /* __KERNEL_SOFTTIMER_PRIVATE_H__ */
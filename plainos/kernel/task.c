@@ -29,11 +29,16 @@ SOFTWARE.
 #include <kernel/kernel.h>
 #include <kernel/syslog.h>
 #include <kernel/mempool.h>
+#include <kernel/kmem_cache.h>
+#include <kernel/arena.h>
 #include <kernel/workqueue.h>
 #include <lib/string.h>
 #include "task.h"
 #include "panic.h"
 #include "softtimer.h"
+#ifdef CONFIG_PL_BOOT_ARENA
+#include "arena.h"
+#endif
 
 /*************************************************************************************
  * Description: Definitions of highest priority of task.
@@ -64,13 +69,13 @@ static u32_t cpu_rate_idle;
  *   @pend_list: list head of pending tasks.
  *   @delay_list: list head of delay tasks.
  *   @exit_list: list head of exit tasks(killed or exited).
- *   @timer_list: list head of soft timer.
  *   @exit_free_work: work for freeing wxit tcb.
  *   @curr_tcb: current context tcb.
  *   @systicks: systicks.
  *   @cpu_rate_base: cpu rate base counter.
  *   @cpu_rate_useful: cpu rate useful counter.
  *   @sched_lock_ref: schedule reference counter.
+ *   @ctx_switches: count of context switches.
  *
  ************************************************************************************/
 struct task_core_blk {
@@ -78,13 +83,13 @@ struct task_core_blk {
 	struct task_list delay_list;
 	struct list_node pend_list;
 	struct list_node exit_list;
-	struct list_node timer_list;
 	struct pl_work exit_free_work;
 	struct tcb *curr_tcb;
 	u64_t systicks;
 	u32_t cpu_rate_base;
 	u32_t cpu_rate_useful;
 	uint_t sched_lock_ref;
+	u32_t ctx_switches;
 };
 
 /*************************************************************************************
@@ -102,19 +107,10 @@ static u32_t g_hiprio_bitmap[(CONFIG_PL_TASK_PRIORITIES_MAX + 31) / 32];
 static struct task_core_blk g_task_core_blk;
 
 /*************************************************************************************
- * Function Name: pl_task_get_timer_list
- * Description: Get timer list tcb.
- *
- * Parameters:
- *   none.
- *
- * Return:
- *   @struct list_node: timer list.
+ * Global Variable Name: tcb_cache
+ * Description:  cache of tcb for the tasks with stack provided.
  ************************************************************************************/
-struct list_node *pl_task_get_timer_list(void)
-{
-	return &g_task_core_blk.timer_list;
-}
+static struct pl_kmem_cache *tcb_cache;
 
 /*************************************************************************************
  * Function Name: pl_task_get_curr_tcb
@@ -146,6 +142,24 @@ int pl_task_get_state(pl_tid_t tid)
 	return ((struct tcb *)tid)->curr_state;
 }
 
+/*************************************************************************************
+ * Function Name: pl_task_get_name
+ * Description: get task name.
+ *
+ * Parameters:
+ *  @tid: task id.
+ *
+ * Return:
+ *   name of task, NULL if tid is NULL.
+ ************************************************************************************/
+const char *pl_task_get_name(pl_tid_t tid)
+{
+	if (tid == NULL)
+		return NULL;
+
+	return ((struct tcb *)tid)->name;
+}
+
 /*************************************************************************************
  * Function Name: get_last_bit
  * Description: Get leading zero of bitmap.
@@ -536,6 +550,9 @@ void *pl_callee_get_next_context_sp(void)
 	/* get highest priority task and switch to it */
 	hiprio = get_hiprio();
 	next_rdy_tcb = g_task_core_blk.ready_list[hiprio].head;
+	if (next_rdy_tcb != g_task_core_blk.curr_tcb)
+		++g_task_core_blk.ctx_switches;
+
 	g_task_core_blk.curr_tcb = next_rdy_tcb;
 	return next_rdy_tcb->context_sp;
 }
@@ -596,7 +613,21 @@ static void pl_task_free_exit_tcb(struct pl_work *work)
 	list_for_each_entry_safe(pos, tmp, &g_task_core_blk.exit_list, struct tcb, node) {
 		list_del_node(&pos->node);
 		list_init(&pos->node);
-		pl_mempool_free(g_pl_default_mempool, pos);
+#if defined(CONFIG_PL_MEMPOOL_OWNER) && defined(CONFIG_PL_MEMPOOL_REGIONS)
+		/* the tcb will be reused, the memory left by task is owned by system */
+		pl_mempool_disown_regions(pos);
+#elif defined(CONFIG_PL_MEMPOOL_OWNER)
+		pl_mempool_disown(g_pl_default_mempool, pos);
+#endif
+		if (pos->mem_src == TCB_MEM_CACHE)
+			pl_kmem_cache_free(tcb_cache, pos);
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+		else if (pos->mem_src == TCB_MEM_POOL)
+			pl_mempool_free_flags(pos);
+#else
+		else if (pos->mem_src == TCB_MEM_POOL)
+			pl_mempool_free(g_pl_default_mempool, pos);
+#endif
 	}
 }
 
@@ -707,6 +738,8 @@ static void task_init_tcb(const char *name, main_t task, u16_t prio,
 	tcb->argc = argc;
 	tcb->argv = argv;
 	tcb->delay_ticks = 0;
+	tcb->notify_cnt = 0;
+	tcb->wait_node = NULL;
 	tcb->curr_state = PL_TASK_STATE_INITED;
 	tcb->parent = g_task_core_blk.curr_tcb;
 	tcb->wait_for_task_ret = -EUNKNOWE;
@@ -775,12 +808,14 @@ pl_tid_t pl_task_sys_create_with_stack(const char *name, main_t task, u16_t prio
 	}
 
 	/* alloc memory */
-	tcb = (struct tcb *)pl_mempool_malloc(g_pl_default_mempool, sizeof(struct tcb));
+	tcb = (struct tcb *)pl_kmem_cache_alloc(tcb_cache);
 	if (tcb == NULL) {
 		pl_early_syslog_err("no mem to alloc\r\n");
 		return NULL;
 	}
 
+	tcb->mem_src = TCB_MEM_CACHE;
+
 	task_init_and_create(name, task, prio, tcb, stack, stack_size, argc, argv);
 	return tcb;
 }
@@ -815,8 +850,8 @@ pl_tid_t pl_task_create_with_stack(const char *name, main_t task, u16_t prio,
 }
 
 /*************************************************************************************
- * Function Name: pl_task_sys_create
- * Description: create a task in system.
+ * Function Name: task_create
+ * Description: allocate the tcb and stack of a task and create it.
  *
  * Parameters:
  *   @name: name of the task (optional).
@@ -825,16 +860,17 @@ pl_tid_t pl_task_create_with_stack(const char *name, main_t task, u16_t prio,
  *   @stack_size: size of the stack (must specify).
  *   @argc: the count of argv (optional).
  *   @argv: argv[] (optional).
+ *   @sys: the task is a system task, it lives forever if created in boot stage.
  *
  * Return:
  *   task id.
  ************************************************************************************/
-pl_tid_t pl_task_sys_create(const char *name, main_t task, u16_t prio,
-                            size_t stack_size, int argc, char *argv[])
+static pl_tid_t task_create(const char *name, main_t task, u16_t prio,
+                            size_t stack_size, int argc, char *argv[], bool sys)
 {
 	void *stack;
 	size_t tcb_actual_size;
-	struct tcb *tcb_and_stack;
+	struct tcb *tcb_and_stack = NULL;
 
 	/* check parameters */
 	if (name == NULL || task == NULL || prio > CONFIG_PL_TASK_PRIORITIES_MAX) {
@@ -844,15 +880,66 @@ pl_tid_t pl_task_sys_create(const char *name, main_t task, u16_t prio,
 
 	/* align address and alloc memory */
 	tcb_actual_size = pl_align_size(sizeof(struct tcb), sizeof(uintptr_t) << 1);
-	tcb_and_stack = pl_mempool_malloc(g_pl_default_mempool, tcb_actual_size + stack_size);
-	if (tcb_and_stack == NULL)
-		return NULL;
+#ifdef CONFIG_PL_BOOT_ARENA
+	/* the system tasks of initcalls never exit, keep them out of the pool */
+	if (sys && pl_arena_is_booting()) {
+		tcb_and_stack = pl_arena_alloc(tcb_actual_size + stack_size);
+		if (tcb_and_stack != NULL)
+			tcb_and_stack->mem_src = TCB_MEM_ARENA;
+	}
+#else
+	USED(sys);
+#endif
+
+	if (tcb_and_stack == NULL) {
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+		/* the stack is the hottest data of task, put it in fast RAM */
+		tcb_and_stack = pl_mempool_malloc_flags(tcb_actual_size + stack_size,
+		                                        PL_MEMPOOL_FAST);
+#else
+		tcb_and_stack = pl_mempool_malloc(g_pl_default_mempool,
+		                                  tcb_actual_size + stack_size);
+#endif
+		if (tcb_and_stack == NULL)
+			return NULL;
+
+#if defined(CONFIG_PL_MEMPOOL_OWNER) && defined(CONFIG_PL_MEMPOOL_REGIONS)
+		/* the task outlives its creator */
+		pl_mempool_set_owner(pl_mempool_region_of(tcb_and_stack),
+		                     tcb_and_stack, NULL);
+#elif defined(CONFIG_PL_MEMPOOL_OWNER)
+		pl_mempool_set_owner(g_pl_default_mempool, tcb_and_stack, NULL);
+#endif
+		tcb_and_stack->mem_src = TCB_MEM_POOL;
+	}
 
 	stack = (u8_t *)tcb_and_stack + tcb_actual_size;
 	task_init_and_create(name, task, prio, tcb_and_stack, stack, stack_size, argc, argv);
 	return tcb_and_stack;
 }
 
+/*************************************************************************************
+ * Function Name: pl_task_sys_create
+ * Description: create a task in system. With the boot arena, the tasks created
+ *              before the late initcalls are put in the arena and never freed.
+ *
+ * Parameters:
+ *   @name: name of the task (optional).
+ *   @task: task, prototype is "int task(int argc, char *argv[])"
+ *   @prio: priority of the task, if is 0, it will be its parent's priority (optional).
+ *   @stack_size: size of the stack (must specify).
+ *   @argc: the count of argv (optional).
+ *   @argv: argv[] (optional).
+ *
+ * Return:
+ *   task id.
+ ************************************************************************************/
+pl_tid_t pl_task_sys_create(const char *name, main_t task, u16_t prio,
+                            size_t stack_size, int argc, char *argv[])
+{
+	return task_create(name, task, prio, stack_size, argc, argv, true);
+}
+
 /*************************************************************************************
  * Function Name: pl_task_create
  * Description: create a task.
@@ -876,7 +963,7 @@ pl_tid_t pl_task_create(const char *name, main_t task, u16_t prio,
 	if (prio < CONFIG_PL_SYS_RSVD_HIGHEST_PRIOTITY)
 		prio = g_task_core_blk.curr_tcb->prio;
 
-	tcb_and_stack = pl_task_sys_create(name, task, prio, stack_size, argc, argv);
+	tcb_and_stack = task_create(name, task, prio, stack_size, argc, argv, false);
 	return tcb_and_stack;
 }
 
@@ -979,6 +1066,73 @@ void pl_task_resume(pl_tid_t tid)
 	pl_task_context_switch();
 }
 
+/*************************************************************************************
+ * Function Name: pl_task_notify
+ *
+ * Description:
+ *   send a direct notification to a task.
+ *
+ * Parameters:
+ *  @tid: task id;
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+void pl_task_notify(pl_tid_t tid)
+{
+	struct tcb *tcb = (struct tcb *)tid;
+
+	if (tcb == NULL)
+		return;
+
+	pl_port_enter_critical();
+	++tcb->notify_cnt;
+	if (tcb->curr_state != PL_TASK_STATE_PENDING) {
+		pl_port_exit_critical();
+		return;
+	}
+
+	pl_task_remove_tcb_from_pendlist(tcb);
+	pl_task_insert_tcb_to_rdylist(tcb);
+	pl_port_exit_critical();
+	pl_task_context_switch();
+}
+
+/*************************************************************************************
+ * Function Name: pl_task_notify_wait
+ *
+ * Description:
+ *   wait for direct notifications of current task.
+ *
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  count of notifications taken.
+ ************************************************************************************/
+u32_t pl_task_notify_wait(void)
+{
+	u32_t cnt;
+	struct tcb *curr;
+
+	while (true) {
+		/* checking and pending is atomic, so no notification will be lost */
+		pl_port_enter_critical();
+		curr = g_task_core_blk.curr_tcb;
+		cnt = curr->notify_cnt;
+		if (cnt != 0) {
+			curr->notify_cnt = 0;
+			pl_port_exit_critical();
+			return cnt;
+		}
+
+		pl_task_remove_tcb_from_rdylist(curr);
+		pl_task_insert_tcb_to_pendlist(curr);
+		pl_port_exit_critical();
+		pl_task_context_switch();
+	}
+}
+
 /*************************************************************************************
  * Function Name: pl_task_restart
  *
@@ -1018,6 +1172,9 @@ void pl_task_restart(pl_tid_t tid)
  ************************************************************************************/
 int pl_task_kill(pl_tid_t tid)
 {
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	size_t leaked;
+#endif
 	struct tcb *tcb = (struct tcb *)tid;
 
 	if (tcb == NULL)
@@ -1029,9 +1186,27 @@ int pl_task_kill(pl_tid_t tid)
 		return -EALREADY;
 	}
 
+	/* the task may be pended or delayed, such as an idle worker of workqueue */
 	pl_task_remove_tcb_from_rdylist(tcb);
+	pl_task_remove_tcb_from_pendlist(tcb);
+	pl_task_remove_tcb_from_delaylist(tcb);
 	pl_task_insert_tcb_to_exitlist(tcb);
+
+	/* the waiter is in the stack which is freed, nothing may walk it any more */
+	if (tcb->wait_node != NULL) {
+		list_del_node(tcb->wait_node);
+		tcb->wait_node = NULL;
+	}
 	pl_port_exit_critical();
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	/* report the memory left by task, pl_mempool_free_owner() can reclaim it */
+	leaked = pl_mempool_get_owner_bytes(g_pl_default_mempool, tcb);
+	if (leaked != 0)
+		pl_syslog_warn("task %s killed with %u bytes allocated\r\n", tcb->name,
+		               (u32_t)leaked);
+#endif
+
 	pl_task_context_switch();
 	return OK;
 }
@@ -1123,49 +1298,6 @@ static void update_delay_task_list(void)
 	}
 }
 
-/*************************************************************************************
- * Function Name: update_softtimer_list
- *
- * Description:
- *   update soft timer list.
- * 
- * Parameters:
- *  none
- *
- * Return:
- *  void.
- ************************************************************************************/
-static void update_softtimer_list(void)
-{
-	bool list_empty;
-	struct pl_stimer *pos;
-	struct pl_stimer *first;
-	struct pl_stimer_ctrl *timer_ctrl;
-
-	timer_ctrl = pl_softtimer_get_ctrl();
-	/* if timer list is empty, we skip it */
-	list_empty = list_is_empty(&g_task_core_blk.timer_list);
-	if (list_empty || timer_ctrl->daemon == NULL)
-		return;
-
-	/* Get the first entry of timer list node, We can know if the timer has timed out */
-	first = list_first_entry(&g_task_core_blk.timer_list, struct pl_stimer, node);
-	if (first->reach_cnt > g_task_core_blk.systicks) {
-		return;
-	}
-
-	/* update soft timer list */
-	list_for_each_entry(pos, &g_task_core_blk.timer_list, struct pl_stimer, node) {
-		if (pos->reach_cnt > g_task_core_blk.systicks)
-			break;
-	}
-
-	/* insert timer node to daemon list and wakeup the daemon task */
-	list_move_chain_to_node_behind(&timer_ctrl->head, g_task_core_blk.timer_list.next,
-	                                pos->node.prev);
-	pl_task_resume(timer_ctrl->daemon);
-}
-
 /*************************************************************************************
  * Function Name: pl_callee_systick_expiration
  *
@@ -1193,8 +1325,8 @@ void pl_callee_systick_expiration(void)
 	update_systick();
 	/* update ready list */
 	update_delay_task_list();
-	/* update soft timer list */
-	update_softtimer_list();
+	/* update soft timer wheel */
+	pl_softtimer_update(g_task_core_blk.systicks);
 
 	/* do not to switch task when state of curr_tcb is not ready. */
 	curr_tcb = g_task_core_blk.curr_tcb;
@@ -1236,6 +1368,30 @@ int pl_task_get_syscount(u64_t *c)
 	return OK;
 }
 
+/*************************************************************************************
+ * Function Name: pl_task_get_switch_count
+ *
+ * Description:
+ *   The function is used to get the count of context switches.
+ * 
+ * Parameters:
+ *  @c: count wanted to get.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_task_get_switch_count(u32_t *c)
+{
+	if (c == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	*c = g_task_core_blk.ctx_switches;
+	pl_port_exit_critical();
+
+	return OK;
+}
+
 /*************************************************************************************
  * Function Name: pl_task_get_cpu_rate_count
  *
@@ -1349,7 +1505,6 @@ int pl_task_core_init(void)
 	cpu_rate_idle = 0;
 	rdytask_list_init();
 	list_init(&g_task_core_blk.pend_list);
-	list_init(&g_task_core_blk.timer_list);
 	list_init(&g_task_core_blk.exit_list);
 
 	/* init delay_dummy_tcb and first_dummy_tcb */
@@ -1367,6 +1522,12 @@ int pl_task_core_init(void)
 	/* init work for freeing exit tcb */
 	pl_work_init(&g_task_core_blk.exit_free_work, pl_task_free_exit_tcb, NULL);
 
+	/* init cache of tcb for tasks with stack provided */
+	tcb_cache = pl_kmem_cache_create("tcb", sizeof(struct tcb), 0,
+	                                 g_pl_default_mempool);
+	if (tcb_cache == NULL)
+		return -ENOMEM;
+
 	pl_early_syslog_info("task core init done\r\n");
 	return OK;
 }
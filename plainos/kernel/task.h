@@ -52,6 +52,21 @@ enum task_state {
 	PL_TASK_STATE_FATAL,
 };
 
+/*************************************************************************************
+ * Type Name: tcb_mem_src
+ * Description: where the tcb is allocated from.
+ *
+ * Members:
+ *   TCB_MEM_POOL: the tcb and stack are allocated from a memory pool region.
+ *   TCB_MEM_CACHE: the tcb is allocated from tcb cache, the stack is provided.
+ *   TCB_MEM_ARENA: the tcb and stack are in the boot arena, they are never freed.
+ ************************************************************************************/
+enum tcb_mem_src {
+	TCB_MEM_POOL = 0,
+	TCB_MEM_CACHE,
+	TCB_MEM_ARENA,
+};
+
 /*************************************************************************************
  * Structure Name: tcb
  * Description: task controller block.
@@ -67,8 +82,12 @@ enum task_state {
  *   @argv: arguments vector.
  *   @node: list node of the same priority tcb.
  *   @curr_state: current state of system.
+ *   @mem_src: where the tcb is allocated from, see enum tcb_mem_src.
  *   @prio: priority of the task, support priority up to 4096.
  *   @delay_ticks: high/low 32bit ticks of delay.
+ *   @notify_cnt: count of direct notifications not yet taken.
+ *   @wait_node: node of a waiter in the stack of the task, such as the one of a
+ *               pipe, it is unlinked when the task is killed.
  *
  ************************************************************************************/
 struct tcb {
@@ -84,8 +103,11 @@ struct tcb {
 	struct list_node wait_head;
 	struct list_node node;
 	u8_t curr_state;
+	u8_t mem_src;
 	u16_t prio;
 	u64_t delay_ticks;
+	u32_t notify_cnt;
+	struct list_node *wait_node;
 };
 
 typedef void (*task_entry_t)(struct tcb *tcb);
@@ -114,18 +136,6 @@ struct tcb *pl_task_get_curr_tcb(void);
  ************************************************************************************/
 int pl_task_get_state(pl_tid_t tid);
 
-/*************************************************************************************
- * Function Name: pl_task_get_timer_list
- * Description: Get timer list tcb.
- *
- * Parameters:
- *   none.
- *
- * Return:
- *   @struct list_node: timer list.
- ************************************************************************************/
-struct list_node *pl_task_get_timer_list(void);
-
 /*************************************************************************************
  * Function Name: pl_task_context_switch
  * Description: switch task.
@@ -282,7 +292,8 @@ pl_tid_t pl_task_sys_create_with_stack(const char *name, main_t task, u16_t prio
 
 /*************************************************************************************
  * Function Name: pl_task_sys_create
- * Description: create a task in system.
+ * Description: create a task in system. With the boot arena, the tasks created
+ *              before the late initcalls are put in the arena and never freed.
  *
  * Parameters:
  *   @name: name of the task (optional).
@@ -0,0 +1,186 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <errno.h>
+#include <types.h>
+#include <config.h>
+#include <port/port.h>
+#include <kernel/list.h>
+#include <kernel/tasklet.h>
+
+/*************************************************************************************
+ * Description: list head of the pending tasklets.
+ ************************************************************************************/
+static LIST_HEAD(pl_tasklet_list);
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_init
+ *
+ * Description:
+ *   initialize a tasklet.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *  @fun: callback function.
+ *  @priv_data: private data.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_tasklet_init(struct pl_tasklet *tasklet, pl_tasklet_fun_t fun, void *priv_data)
+{
+	if (tasklet == NULL || fun == NULL)
+		return -EFAULT;
+
+	list_init(&tasklet->node);
+	tasklet->fun = fun;
+	tasklet->priv_data = priv_data;
+	tasklet->state = PL_TASKLET_STATE_IDLE;
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_schedule
+ *
+ * Description:
+ *   queue a tasklet, it can be called in interrupt context.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EALREADY: the tasklet is already pending, it will run only once.
+ ************************************************************************************/
+int pl_tasklet_schedule(struct pl_tasklet *tasklet)
+{
+	if (tasklet == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	if (tasklet->state == PL_TASKLET_STATE_PENDING) {
+		pl_port_exit_critical();
+		return -EALREADY;
+	}
+
+	tasklet->state = PL_TASKLET_STATE_PENDING;
+	list_add_node_at_tail(&pl_tasklet_list, &tasklet->node);
+	/* the tasklets will be run at the entry of switching context */
+	pl_port_switch_context();
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_cancel
+ *
+ * Description:
+ *   remove a pending tasklet.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_tasklet_cancel(struct pl_tasklet *tasklet)
+{
+	if (tasklet == NULL)
+		return -EFAULT;
+
+	pl_port_enter_critical();
+	if (tasklet->state != PL_TASKLET_STATE_PENDING) {
+		pl_port_exit_critical();
+		return -EEMPTY;
+	}
+
+	list_del_node(&tasklet->node);
+	list_init(&tasklet->node);
+	tasklet->state = PL_TASKLET_STATE_IDLE;
+	pl_port_exit_critical();
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: pl_tasklet_get_private_data
+ *
+ * Description:
+ *   get the private data of tasklet.
+ *
+ * Parameters:
+ *  @tasklet: tasklet.
+ *
+ * Return:
+ *   private data of the tasklet.
+ ************************************************************************************/
+void *pl_tasklet_get_private_data(struct pl_tasklet *tasklet)
+{
+	if (tasklet == NULL)
+		return NULL;
+
+	return tasklet->priv_data;
+}
+
+/*************************************************************************************
+ * Function Name: pl_callee_run_tasklets
+ *
+ * Description:
+ *   run all pending tasklets, the port must call it at the entry of switching
+ *   context with interrupts enabled.
+ *
+ * Parameters:
+ *  none.
+ *
+ * Return:
+ *  none.
+ ************************************************************************************/
+void pl_callee_run_tasklets(void)
+{
+	struct list_node *first;
+	struct pl_tasklet *tasklet;
+
+	while (true) {
+		pl_port_enter_critical();
+		if (list_is_empty(&pl_tasklet_list)) {
+			pl_port_exit_critical();
+			return;
+		}
+
+		first = list_del_front_node(&pl_tasklet_list);
+		tasklet = container_of(first, struct pl_tasklet, node);
+		list_init(&tasklet->node);
+		tasklet->state = PL_TASKLET_STATE_RUNNING;
+		pl_port_exit_critical();
+
+		tasklet->fun(tasklet);
+
+		/* the tasklet may be scheduled again in its callback */
+		pl_port_enter_critical();
+		if (tasklet->state == PL_TASKLET_STATE_RUNNING)
+			tasklet->state = PL_TASKLET_STATE_IDLE;
+		pl_port_exit_critical();
+	}
+}
@@ -0,0 +1,242 @@
+/*
+MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <types.h>
+#include <kernel/kernel.h>
+#include <kernel/list.h>
+#include "timer_wheel.h"
+
+/* ticks covered by all levels */
+#define TIMER_WHEEL_SPAN    (1ull << (PL_TIMER_WHEEL_BITS * PL_TIMER_WHEEL_LEVELS))
+
+/*************************************************************************************
+ * Function Name: timer_wheel_move_slot
+ *
+ * Description:
+ *   move all timers of a slot to the tail of a list.
+ *
+ * Parameters:
+ *   @slot: the slot.
+ *   @list: the list.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+static void timer_wheel_move_slot(struct list_node *slot, struct list_node *list)
+{
+	if (list_is_empty(slot))
+		return;
+
+	list_move_chain_to_node_behind(list->prev, slot->next, slot->prev);
+}
+
+/*************************************************************************************
+ * Function Name: timer_wheel_cascade
+ *
+ * Description:
+ *   hash the timers of a slot to the lower levels again.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @slot: the slot.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+static void timer_wheel_cascade(struct pl_timer_wheel *wheel, struct list_node *slot)
+{
+	struct list_node chain;
+	struct pl_stimer *timer;
+
+	/* detach the slot first, a parked timer may be hashed to the last level again */
+	list_init(&chain);
+	timer_wheel_move_slot(slot, &chain);
+	while (!list_is_empty(&chain)) {
+		timer = container_of(list_del_front_node(&chain), struct pl_stimer, node);
+		pl_timer_wheel_add(wheel, timer);
+	}
+}
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_init
+ *
+ * Description:
+ *   Initialize the wheel.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @clk: the first tick to be processed.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_timer_wheel_init(struct pl_timer_wheel *wheel, u64_t clk)
+{
+	uint_t level;
+	uint_t idx;
+
+	wheel->clk = clk;
+	for (level = 0; level < PL_TIMER_WHEEL_LEVELS; level++) {
+		for (idx = 0; idx < PL_TIMER_WHEEL_SLOTS; idx++)
+			list_init(&wheel->slots[level][idx]);
+	}
+}
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_slack_mask
+ *
+ * Description:
+ *   Get the mask to round the deadline of a timer with slack, the deadline is
+ *   rounded up to the largest power of 2 not greater than slack_cnt + 1, so it is
+ *   never later than slack_cnt and the timers rounded alike expire together.
+ *
+ * Parameters:
+ *   @slack_cnt: ticks the timer may expire late.
+ *
+ * Return:
+ *   the mask, 0 if slack_cnt is 0.
+ ************************************************************************************/
+u32_t pl_timer_wheel_slack_mask(u64_t slack_cnt)
+{
+	u32_t grain = 1;
+
+	/* the grain is 2^31 at most */
+	if (slack_cnt >= UINT32_MAX)
+		return UINT32_MAX >> 1;
+
+	while (grain <= (slack_cnt + 1) / 2)
+		grain <<= 1;
+
+	return grain - 1;
+}
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_add
+ *
+ * Description:
+ *   Add a timer to the wheel by its reach_cnt rounded by its slack_mask, a timer
+ *   whose deadline has passed expires at the next tick processed. It must be
+ *   called in critical section.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @timer: the timer, its node is not in any list.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_timer_wheel_add(struct pl_timer_wheel *wheel, struct pl_stimer *timer)
+{
+	uint_t level;
+	u64_t delta;
+	u64_t reach = timer->reach_cnt;
+
+	/* the same deadline is got again when the timer cascades */
+	reach = (reach + timer->slack_mask) & ~(u64_t)timer->slack_mask;
+	if (reach < wheel->clk)
+		reach = wheel->clk;
+
+	/* park the timer beyond the last level in its farthest slot */
+	delta = reach - wheel->clk;
+	if (delta >= TIMER_WHEEL_SPAN) {
+		reach = wheel->clk + TIMER_WHEEL_SPAN - 1;
+		delta = TIMER_WHEEL_SPAN - 1;
+	}
+
+	for (level = 0; level < PL_TIMER_WHEEL_LEVELS - 1; level++) {
+		if (delta < (1ull << (PL_TIMER_WHEEL_BITS * (level + 1))))
+			break;
+	}
+
+	reach >>= PL_TIMER_WHEEL_BITS * level;
+	list_add_node_at_tail(&wheel->slots[level][reach & PL_TIMER_WHEEL_MASK],
+	                      &timer->node);
+}
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_add_periodic
+ *
+ * Description:
+ *   Add a reload timer again, its reach_cnt is the last deadline plus timing_cnt,
+ *   the periods passed by now are skipped. It must be called in critical section.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @timer: the timer, its node is not in any list and its timing_cnt is not 0.
+ *   @last: the last deadline of timer.
+ *   @now: current tick.
+ *
+ * Return:
+ *   count of periods skipped.
+ ************************************************************************************/
+u32_t pl_timer_wheel_add_periodic(struct pl_timer_wheel *wheel, struct pl_stimer *timer,
+                                  u64_t last, u64_t now)
+{
+	u64_t missed = 0;
+
+	/* the deadline of now has been processed, the next one is after it */
+	timer->reach_cnt = last + timer->timing_cnt;
+	if (timer->reach_cnt <= now) {
+		missed = (now - last) / timer->timing_cnt;
+		timer->reach_cnt = last + (missed + 1) * timer->timing_cnt;
+	}
+
+	pl_timer_wheel_add(wheel, timer);
+	return (missed > UINT32_MAX) ? UINT32_MAX : (u32_t)missed;
+}
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_advance
+ *
+ * Description:
+ *   Process the ticks up to now, the timers expired are moved to the tail of the
+ *   expired list in the order of ticks. It must be called in critical section.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @now: the last tick to be processed.
+ *   @expired: list to hold the timers expired.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_timer_wheel_advance(struct pl_timer_wheel *wheel, u64_t now,
+                            struct list_node *expired)
+{
+	uint_t idx;
+	uint_t level;
+
+	while (wheel->clk <= now) {
+		/* level 0 wraps, bring the next slot of the upper levels down */
+		idx = (uint_t)(wheel->clk & PL_TIMER_WHEEL_MASK);
+		for (level = 1; idx == 0 && level < PL_TIMER_WHEEL_LEVELS; level++) {
+			idx = (uint_t)((wheel->clk >> (PL_TIMER_WHEEL_BITS * level)) &
+			               PL_TIMER_WHEEL_MASK);
+			timer_wheel_cascade(wheel, &wheel->slots[level][idx]);
+		}
+
+		idx = (uint_t)(wheel->clk & PL_TIMER_WHEEL_MASK);
+		timer_wheel_move_slot(&wheel->slots[0][idx], expired);
+		++wheel->clk;
+	}
+}
@@ -0,0 +1,141 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef __KERNEL_INTERNAL_TIMER_WHEEL_H__
+#define __KERNEL_INTERNAL_TIMER_WHEEL_H__
+
+#include <types.h>
+#include <config.h>
+#include <kernel/list.h>
+#include <kernel/softtimer.h>
+
+#define PL_TIMER_WHEEL_BITS             (CONFIG_PL_SOFTTIMER_WHEEL_SLOT_BITS)
+#define PL_TIMER_WHEEL_SLOTS            (1u << PL_TIMER_WHEEL_BITS)
+#define PL_TIMER_WHEEL_MASK             (PL_TIMER_WHEEL_SLOTS - 1)
+#define PL_TIMER_WHEEL_LEVELS           (CONFIG_PL_SOFTTIMER_WHEEL_LEVELS)
+
+/*************************************************************************************
+ * Structure Name: pl_timer_wheel
+ * Description: hierarchical wheel of the soft timers.
+ *
+ * Members:
+ *   @clk: the next tick to be processed, all ticks before it are done.
+ *   @slots: slots of each level, a slot of level n spans SLOTS^n ticks.
+ *
+ * NOTE:
+ *   A timer is hashed by its reach_cnt to the lowest level that covers it, so
+ *   adding and deleting it are O(1). The timers of a slot of level n are moved to
+ *   the lower levels when level n - 1 wraps, the timers beyond the last level are
+ *   parked in its farthest slot and hashed again there.
+ ************************************************************************************/
+struct pl_timer_wheel {
+	u64_t clk;
+	struct list_node slots[PL_TIMER_WHEEL_LEVELS][PL_TIMER_WHEEL_SLOTS];
+};
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_init
+ *
+ * Description:
+ *   Initialize the wheel.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @clk: the first tick to be processed.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_timer_wheel_init(struct pl_timer_wheel *wheel, u64_t clk);
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_slack_mask
+ *
+ * Description:
+ *   Get the mask to round the deadline of a timer with slack, the deadline is
+ *   rounded up to the largest power of 2 not greater than slack_cnt + 1, so it is
+ *   never later than slack_cnt and the timers rounded alike expire together.
+ *
+ * Parameters:
+ *   @slack_cnt: ticks the timer may expire late.
+ *
+ * Return:
+ *   the mask, 0 if slack_cnt is 0.
+ ************************************************************************************/
+u32_t pl_timer_wheel_slack_mask(u64_t slack_cnt);
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_add
+ *
+ * Description:
+ *   Add a timer to the wheel by its reach_cnt rounded by its slack_mask, a timer
+ *   whose deadline has passed expires at the next tick processed. It must be
+ *   called in critical section.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @timer: the timer, its node is not in any list.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_timer_wheel_add(struct pl_timer_wheel *wheel, struct pl_stimer *timer);
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_add_periodic
+ *
+ * Description:
+ *   Add a reload timer again, its reach_cnt is the last deadline plus timing_cnt,
+ *   the periods passed by now are skipped. It must be called in critical section.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @timer: the timer, its node is not in any list and its timing_cnt is not 0.
+ *   @last: the last deadline of timer.
+ *   @now: current tick.
+ *
+ * Return:
+ *   count of periods skipped.
+ ************************************************************************************/
+u32_t pl_timer_wheel_add_periodic(struct pl_timer_wheel *wheel, struct pl_stimer *timer,
+                                  u64_t last, u64_t now);
+
+/*************************************************************************************
+ * Function Name: pl_timer_wheel_advance
+ *
+ * Description:
+ *   Process the ticks up to now, the timers expired are moved to the tail of the
+ *   expired list in the order of ticks. It must be called in critical section.
+ *
+ * Parameters:
+ *   @wheel: timer wheel.
+ *   @now: the last tick to be processed.
+ *   @expired: list to hold the timers expired.
+ *
+ * Return:
+ *   none.
+ ************************************************************************************/
+void pl_timer_wheel_advance(struct pl_timer_wheel *wheel, u64_t now,
+                            struct list_node *expired);
+
+#endif /* __KERNEL_INTERNAL_TIMER_WHEEL_H__ */
@@ -28,9 +28,44 @@ SOFTWARE.
 #include <kernel/mempool.h>
 #include <kernel/syslog.h>
 #include <kernel/initcall.h>
+#include <kernel/list.h>
+#include <kernel/completion.h>
+#include <kernel/softtimer.h>
 #include <kernel/workqueue.h>
 #include "task.h"
 
+/*************************************************************************************
+ * Structure Name: wq_worker
+ * Description: worker task of workqueue.
+ *
+ * Members:
+ *   @node: list node of all workers of the workqueue.
+ *   @idle_node: list node of the idle workers of the workqueue.
+ *   @wq: workqueue the worker belongs to.
+ *   @tid: task of the worker.
+ *   @idle: the worker is on the idle list.
+ ************************************************************************************/
+struct wq_worker {
+	struct list_node node;
+	struct list_node idle_node;
+	struct pl_workqueue *wq;
+	pl_tid_t tid;
+	bool idle;
+};
+
+/*************************************************************************************
+ * Structure Name: wq_flusher
+ * Description: a task waiting in pl_workqueue_flush().
+ *
+ * Members:
+ *   @node: list node of the flushers of the workqueue.
+ *   @comp: completion posted when the workqueue has drained.
+ ************************************************************************************/
+struct wq_flusher {
+	struct list_node node;
+	struct pl_completion comp;
+};
+
 static struct pl_workqueue pl_sys_hiwq;
 static struct pl_workqueue pl_sys_lowq;
 static struct pl_work *pl_sys_hiwq_fifo[CONFIG_PL_HI_WORKQUEUE_FIFO_CAPACITY];
@@ -39,67 +74,269 @@ static struct pl_work *pl_sys_lowq_fifo[CONFIG_PL_LO_WORKQUEUE_FIFO_CAPACITY];
 struct pl_workqueue *g_pl_sys_hiwq_handle = &pl_sys_hiwq;
 struct pl_workqueue *g_pl_sys_lowq_handle = &pl_sys_lowq;
 
+static int workqueue_add_worker(struct pl_workqueue *wq);
+
+/*************************************************************************************
+ * Function Name: workqueue_take_flushers
+ *
+ * Description:
+ *   move the flushers to a local list if the workqueue has drained, it must be
+ *   called in critical section.
+ *
+ * Parameters:
+ *  @wq: workqueue.
+ *  @flushers: local list to hold the flushers.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void workqueue_take_flushers(struct pl_workqueue *wq, struct list_node *flushers)
+{
+	if (pl_work_ring_len(&wq->fifo) != 0 || wq->nr_running != 0)
+		return;
+
+	while (!list_is_empty(&wq->flushers))
+		list_add_node_at_tail(flushers, list_del_front_node(&wq->flushers));
+}
+
+/*************************************************************************************
+ * Function Name: workqueue_wake_flushers
+ *
+ * Description:
+ *   wake up the flushers taken by workqueue_take_flushers().
+ *
+ * Parameters:
+ *  @flushers: local list of the flushers.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void workqueue_wake_flushers(struct list_node *flushers)
+{
+	struct wq_flusher *flusher;
+
+	while (!list_is_empty(flushers)) {
+		flusher = container_of(list_del_front_node(flushers), struct wq_flusher, node);
+		pl_completion_post(&flusher->comp);
+	}
+}
+
+/*************************************************************************************
+ * Function Name: workqueue_drain
+ *
+ * Description:
+ *   drop all works left in the fifo and take all flushers, it is called when the
+ *   workqueue is destroyed and it must be called in critical section. The works
+ *   are not pending any more and can be added to another workqueue.
+ *
+ * Parameters:
+ *  @wq: workqueue.
+ *  @flushers: local list to hold the flushers.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void workqueue_drain(struct pl_workqueue *wq, struct list_node *flushers)
+{
+	struct pl_work *wk;
+
+	while (pl_work_ring_pop(&wq->fifo, &wk)) {
+		if (wk == NULL)
+			continue;
+
+		wk->state &= (u8_t)~(PL_WORK_STATE_PENDING | PL_WORK_STATE_QUEUED);
+		wk->wq = NULL;
+	}
+
+	while (!list_is_empty(&wq->flushers))
+		list_add_node_at_tail(flushers, list_del_front_node(&wq->flushers));
+}
+
+/*************************************************************************************
+ * Function Name: workqueue_run_batch
+ *
+ * Description:
+ *   run all works up to the snapshot of the fifo in index, it must be called in critical
+ *   section and it will exit the critical section. The works are claimed in one
+ *   critical section and released in another one, no matter how many they are.
+ *
+ * Parameters:
+ *  @wq: workqueue.
+ *  @flushers: local list to hold the flushers.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void workqueue_run_batch(struct pl_workqueue *wq, struct list_node *flushers)
+{
+	uint_t seq;
+	uint_t end;
+	struct pl_work *wk;
+
+	/* claim the batch, the slots are not reused until the out index is updated */
+	end = wq->fifo.in;
+	for (seq = wq->fifo.out; seq != end; seq++) {
+		wk = *pl_work_ring_slot(&wq->fifo, seq);
+		/* the slots of the works cancelled have been cleared */
+		if (wk != NULL)
+			wk->state = PL_WORK_STATE_RUNNING;
+	}
+
+	++wq->nr_running;
+	pl_port_exit_critical();
+
+	for (seq = wq->fifo.out; seq != end; seq++) {
+		wk = *pl_work_ring_slot(&wq->fifo, seq);
+		if (wk != NULL && wk->fun != NULL)
+			wk->fun(wk);
+	}
+
+	/* release the batch, the works may be added again in their callbacks */
+	pl_port_enter_critical();
+	for (seq = wq->fifo.out; seq != end; seq++) {
+		wk = *pl_work_ring_slot(&wq->fifo, seq);
+		if (wk != NULL)
+			wk->state &= (u8_t)~PL_WORK_STATE_RUNNING;
+	}
+
+	wq->fifo.out = end;
+	--wq->nr_running;
+	workqueue_take_flushers(wq, flushers);
+	pl_port_exit_critical();
+	workqueue_wake_flushers(flushers);
+}
+
 static int workqueue_task(int argc, char **argv)
 {
 	USED(argc);
-	USED(argv);
+	bool grow;
 	struct pl_work *first;
-	struct pl_workqueue *wq = (struct pl_workqueue *)argv;
+	struct list_node flushers;
+	struct wq_worker *worker = (struct wq_worker *)argv;
+	struct pl_workqueue *wq = worker->wq;
+
+	worker->tid = pl_task_get_curr_tcb();
+	list_init(&flushers);
 
 	while (true) {
-		/* if work fifo is empty, we need to suspend wq task */
-		if (wq->fifo_out == wq->fifo_in) {
-			pl_task_pend(NULL);
+		pl_port_enter_critical();
+		/* if work fifo is empty, we need to sleep on the idle list */
+		if (pl_work_ring_len(&wq->fifo) == 0) {
+			if (!worker->idle) {
+				worker->idle = true;
+				list_add_node_at_tail(&wq->idle_workers, &worker->idle_node);
+			}
+
+			pl_port_exit_critical();
+			pl_task_notify_wait();
+			continue;
+		}
+
+		/* woken by a stale notification while still on the idle list */
+		if (worker->idle) {
+			worker->idle = false;
+			list_del_node(&worker->idle_node);
+		}
+
+		/* a single worker drains the fifo in batches */
+		if (wq->batch) {
+			workqueue_run_batch(wq, &flushers);
 			continue;
 		}
 
 		/* get the first work */
-		pl_port_enter_critical();
-		first = wq->fifo[wq->fifo_out & (wq->fifo_cap - 1)];
-		++wq->fifo_out;
+		pl_work_ring_pop(&wq->fifo, &first);
+
+		/* the work has been cancelled, its slot has been cleared */
+		if (first == NULL) {
+			workqueue_take_flushers(wq, &flushers);
+			pl_port_exit_critical();
+			workqueue_wake_flushers(&flushers);
+			continue;
+		}
+
+		first->state = PL_WORK_STATE_RUNNING;
+		++wq->nr_running;
+
+		/* more works are waiting but no worker is idle, grow the pool */
+		grow = (pl_work_ring_len(&wq->fifo) != 0 && list_is_empty(&wq->idle_workers) &&
+		        wq->nr_workers < wq->max_workers);
+		if (grow)
+			++wq->nr_workers;
 		pl_port_exit_critical();
 
+		if (grow && workqueue_add_worker(wq) < 0) {
+			pl_port_enter_critical();
+			--wq->nr_workers;
+			pl_port_exit_critical();
+		}
+
 		/* call fun of callback */
 		if (first->fun != NULL)
 			first->fun(first);
+
+		/* the work may be added again in its callback, keep the pending bit */
+		pl_port_enter_critical();
+		first->state &= (u8_t)~PL_WORK_STATE_RUNNING;
+		--wq->nr_running;
+		workqueue_take_flushers(wq, &flushers);
+		pl_port_exit_critical();
+		workqueue_wake_flushers(&flushers);
 	}
 
 	return 0;
 }
 
 /*************************************************************************************
- * Function Name: pl_sys_workqueue_init
+ * Function Name: workqueue_add_worker
  *
  * Description:
- *   init a system workqueue.
- * 
+ *   create a worker task for workqueue, the caller must have counted it in
+ *   wq->nr_workers.
+ *
  * Parameters:
- *  @wq: workqueue struct address.
- *  @name: name of workqueue.
- *  @prio: priority of workqueue.
- *  @wq_stack_sz: workqueue task stack size.
- *  @wq_fifo_cap: capacity of workqueue fifo.
- *  @wq_fifo: fifo buffer of workqueue.
+ *  @wq: workqueue.
  *
  * Return:
  *   Greater than or equal to 0 on success, less than 0 on failure.
  ************************************************************************************/
-static int pl_sys_workqueue_init(struct pl_workqueue *wq, const char *name, u16_t prio,
-						size_t wq_stack_sz, u32_t wq_fifo_cap, struct pl_work **wq_fifo)
+static int workqueue_add_worker(struct pl_workqueue *wq)
 {
 	pl_tid_t tid;
+	struct wq_worker *worker;
+
+	worker = pl_mempool_alloc_sized(g_pl_default_mempool, sizeof(struct wq_worker));
+	if (worker == NULL)
+		return -ENOMEM;
+
+	worker->wq = wq;
+	worker->tid = NULL;
+	worker->idle = false;
+	list_init(&worker->idle_node);
 
-	wq->fifo_in = 0;
-	wq->fifo_out = 0;
-	wq->fifo = wq_fifo;
-	wq->fifo_cap = wq_fifo_cap;
-	wq->name = (name == NULL) ? "anonymous sys_wq" : name;
+	pl_port_enter_critical();
+	list_add_node_at_tail(&wq->workers, &worker->node);
+	pl_port_exit_critical();
 
-	tid = pl_task_sys_create(name, workqueue_task, prio, wq_stack_sz, 1, (char **)wq);
-	if (tid == NULL)
+	/* the priority has been checked when the workqueue was created */
+	if (wq == &pl_sys_hiwq || wq == &pl_sys_lowq)
+		tid = pl_task_sys_create(wq->name, workqueue_task, wq->prio, wq->stack_sz,
+		                         1, (char **)worker);
+	else
+		tid = pl_task_create(wq->name, workqueue_task, wq->prio, wq->stack_sz,
+		                     1, (char **)worker);
+	if (tid == NULL) {
+		pl_port_enter_critical();
+		list_del_node(&worker->node);
+		pl_port_exit_critical();
+		pl_mempool_free_sized(g_pl_default_mempool, worker, sizeof(struct wq_worker));
 		return -EUNKNOWE;
+	}
+
+	worker->tid = tid;
+	if (wq->exec_thread == NULL)
+		wq->exec_thread = tid;
 
-	wq->exec_thread = tid;
 	return OK;
 }
 
@@ -116,46 +353,67 @@ static int pl_sys_workqueue_init(struct pl_workqueue *wq, const char *name, u16_
  *  @wq_stack_sz: workqueue task stack size.
  *  @wq_fifo_cap: capacity of workqueue fifo.
  *  @wq_fifo: fifo buffer of workqueue.
+ *  @nr_workers: count of workers created at the beginning.
+ *  @max_workers: max count of workers, the pool grows on demand up to it.
+ *  @batch: the only worker drains the fifo in batches.
  *
  * Return:
  *   Greater than or equal to 0 on success, less than 0 on failure.
  ************************************************************************************/
 static int pl_workqueue_init(struct pl_workqueue *wq, const char *name, u16_t prio,
-					size_t wq_stack_sz, u32_t wq_fifo_cap, struct pl_work **wq_fifo)
+					size_t wq_stack_sz, u32_t wq_fifo_cap, struct pl_work **wq_fifo,
+					u16_t nr_workers, u16_t max_workers, bool batch)
 {
-	pl_tid_t tid;
+	int ret;
+	u16_t i;
 
-	wq->fifo_in = 0;
-	wq->fifo_out = 0;
-	wq->fifo = wq_fifo;
-	wq->fifo_cap = wq_fifo_cap;
-	wq->name = (name == NULL) ? "anonymous wq" : name;
+	ret = pl_work_ring_init(&wq->fifo, wq_fifo, wq_fifo_cap);
+	if (ret < 0)
+		return ret;
 
-	tid = pl_task_create(name, workqueue_task, prio, wq_stack_sz, 1, (char **)wq);
-	if (tid == NULL)
-		return -EUNKNOWE;
+	wq->name = (name == NULL) ? "anonymous wq" : name;
+	wq->exec_thread = NULL;
+	wq->prio = prio;
+	wq->stack_sz = wq_stack_sz;
+	wq->nr_workers = nr_workers;
+	wq->max_workers = max_workers;
+	wq->nr_running = 0;
+	wq->nr_wakeups = 0;
+	wq->batch = batch;
+	list_init(&wq->workers);
+	list_init(&wq->idle_workers);
+	list_init(&wq->flushers);
+
+	for (i = 0; i < nr_workers; i++) {
+		ret = workqueue_add_worker(wq);
+		if (ret < 0)
+			return ret;
+	}
 
-	wq->exec_thread = tid;
 	return OK;
 }
 
 /*************************************************************************************
- * Function Name: pl_workqueue_create
+ * Function Name: workqueue_create
  *
  * Description:
- *   create a workqueue.
+ *   allocate a workqueue with its fifo and create its workers.
  * 
  * Parameters:
  *  @name: workqueue name.
  *  @proi: priority of workqueue.
  *  @wq_stack_sz: workqueue task stack size.
  *  @wq_fifo_cap: capacity of workqueue fifo.
+ *  @nr_workers: count of workers created at the beginning.
+ *  @max_workers: max count of workers.
+ *  @batch: the only worker drains the fifo in batches.
  *
  * Return:
  *  @struct pl_workqueue*: handle of workqueue requested.
  ************************************************************************************/
-struct pl_workqueue *pl_workqueue_create(const char *name, u16_t prio,
-								size_t wq_stack_sz, u32_t wq_fifo_cap)
+static struct pl_workqueue *workqueue_create(const char *name, u16_t prio,
+								size_t wq_stack_sz, u32_t wq_fifo_cap,
+								u16_t nr_workers, u16_t max_workers, bool batch)
 {
 	int ret;
 	struct pl_workqueue *wq;
@@ -163,43 +421,167 @@ struct pl_workqueue *pl_workqueue_create(const char *name, u16_t prio,
 	if (!pl_is_power_of_2(wq_fifo_cap) || wq_fifo_cap == 0)
 		return NULL;
 
-	wq = pl_mempool_malloc(g_pl_default_mempool, sizeof(struct pl_workqueue) +
+	if (nr_workers == 0 || max_workers < nr_workers)
+		return NULL;
+
+	/* same as pl_task_create(), the reserved priorities are not allowed */
+	if (prio < CONFIG_PL_SYS_RSVD_HIGHEST_PRIOTITY)
+		prio = pl_task_get_curr_tcb()->prio;
+
+	wq = pl_mempool_alloc_sized(g_pl_default_mempool, sizeof(struct pl_workqueue) +
 							sizeof(struct pl_work *) * wq_fifo_cap);
 	if (wq == NULL)
 		return NULL;
 
 	ret = pl_workqueue_init(wq, name, prio, wq_stack_sz, wq_fifo_cap,
-							(struct pl_work **)(wq + 1));
-	if (ret < 0)
+							(struct pl_work **)(wq + 1), nr_workers, max_workers,
+							batch);
+	if (ret < 0) {
+		pl_workqueue_destroy(wq);
 		return NULL;
+	}
 
 	return wq;
 }
 
+/*************************************************************************************
+ * Function Name: pl_workqueue_create
+ *
+ * Description:
+ *   create a workqueue.
+ * 
+ * Parameters:
+ *  @name: workqueue name.
+ *  @proi: priority of workqueue.
+ *  @wq_stack_sz: workqueue task stack size.
+ *  @wq_fifo_cap: capacity of workqueue fifo.
+ *
+ * Return:
+ *  @struct pl_workqueue*: handle of workqueue requested.
+ ************************************************************************************/
+struct pl_workqueue *pl_workqueue_create(const char *name, u16_t prio,
+								size_t wq_stack_sz, u32_t wq_fifo_cap)
+{
+	return workqueue_create(name, prio, wq_stack_sz, wq_fifo_cap, 1, 1, false);
+}
+
+/*************************************************************************************
+ * Function Name: pl_workqueue_create_pool
+ *
+ * Description:
+ *   create a workqueue with a pool of workers.
+ * 
+ * Parameters:
+ *  @name: workqueue name.
+ *  @proi: priority of workqueue.
+ *  @wq_stack_sz: workqueue task stack size.
+ *  @wq_fifo_cap: capacity of workqueue fifo.
+ *  @nr_workers: count of workers created at the beginning.
+ *  @max_workers: max count of workers.
+ *
+ * Return:
+ *  @struct pl_workqueue*: handle of workqueue requested.
+ ************************************************************************************/
+struct pl_workqueue *pl_workqueue_create_pool(const char *name, u16_t prio,
+								size_t wq_stack_sz, u32_t wq_fifo_cap,
+								u16_t nr_workers, u16_t max_workers)
+{
+	return workqueue_create(name, prio, wq_stack_sz, wq_fifo_cap, nr_workers,
+	                        max_workers, false);
+}
+
+/*************************************************************************************
+ * Function Name: pl_workqueue_create_batch
+ *
+ * Description:
+ *   create a workqueue whose only worker drains the fifo in batches.
+ * 
+ * Parameters:
+ *  @name: workqueue name.
+ *  @proi: priority of workqueue.
+ *  @wq_stack_sz: workqueue task stack size.
+ *  @wq_fifo_cap: capacity of workqueue fifo.
+ *
+ * Return:
+ *  @struct pl_workqueue*: handle of workqueue requested.
+ ************************************************************************************/
+struct pl_workqueue *pl_workqueue_create_batch(const char *name, u16_t prio,
+								size_t wq_stack_sz, u32_t wq_fifo_cap)
+{
+	return workqueue_create(name, prio, wq_stack_sz, wq_fifo_cap, 1, 1, true);
+}
+
 /*************************************************************************************
  * Function Name: pl_workqueue_destroy
  *
  * Description:
- *   destroy a workqueue.
+ *   destroy a workqueue, the works left in the fifo are dropped and the tasks
+ *   flushing it are woken up. The delayed works still on their timers must be
+ *   cancelled before.
  * 
  * Parameters:
  *  @workqueue: workqueue handle.
  *
  * Return:
  *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EBUSY: a work is running, or it is called by a worker of the workqueue.
  ************************************************************************************/
 int pl_workqueue_destroy(struct pl_workqueue *wq)
 {
-	int ret;
+	int ret = OK;
+	pl_tid_t self;
+	struct wq_worker *worker;
+	struct list_node flushers;
 
 	if (wq == NULL || wq == &pl_sys_hiwq || wq == &pl_sys_lowq)
 		return -EFAULT;
 
-	ret = pl_task_kill(wq->exec_thread);
-	if (ret < 0)
-		return -EINVAL;
+	self = pl_task_get_curr_tcb();
+	list_init(&flushers);
+
+	pl_port_enter_critical();
+	/* a worker can not kill itself, and a work running can not be broken */
+	list_for_each_entry(worker, &wq->workers, struct wq_worker, node) {
+		if (worker->tid == self)
+			ret = -EBUSY;
+	}
+
+	if (ret < 0 || wq->nr_running != 0) {
+		pl_port_exit_critical();
+		return -EBUSY;
+	}
+
+	/* no work is left to the workers, release the works and the flushers */
+	workqueue_drain(wq, &flushers);
+	pl_port_exit_critical();
+	workqueue_wake_flushers(&flushers);
+
+	while (true) {
+		pl_port_enter_critical();
+		if (list_is_empty(&wq->workers)) {
+			pl_port_exit_critical();
+			break;
+		}
+
+		worker = list_first_entry(&wq->workers, struct wq_worker, node);
+		pl_port_exit_critical();
+
+		/* the worker has been killed if a previous destroy failed after it */
+		ret = pl_task_kill(worker->tid);
+		if (ret < 0 && ret != -EALREADY)
+			return ret;
+
+		pl_port_enter_critical();
+		list_del_node(&worker->node);
+		if (worker->idle)
+			list_del_node(&worker->idle_node);
+		pl_port_exit_critical();
+
+		pl_mempool_free_sized(g_pl_default_mempool, worker, sizeof(struct wq_worker));
+	}
 
-	pl_mempool_free(g_pl_default_mempool, wq);
+	pl_mempool_free_sized(g_pl_default_mempool, wq, sizeof(struct pl_workqueue) +
+	                      sizeof(struct pl_work *) * wq->fifo.cap);
 	return OK;
 }
 
@@ -222,6 +604,48 @@ int pl_work_init(struct pl_work *wk, pl_work_fun_t fun, void *priv_data)
 
 	wk->fun = fun;
 	wk->priv_data = priv_data;
+	wk->wq = NULL;
+	wk->seq = 0;
+	wk->state = 0;
+
+	return OK;
+}
+
+/*************************************************************************************
+ * Function Name: work_enqueue
+ *
+ * Description:
+ *   put a work into the fifo and pick an idle worker, it must be called in
+ *   critical section.
+ *
+ * Parameters:
+ *  @wq: workqueue handle.
+ *  @wk: work.
+ *  @worker: the idle worker need to be notified, NULL if no one is idle.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+static int work_enqueue(struct pl_workqueue *wq, struct pl_work *wk,
+                        struct wq_worker **worker)
+{
+	struct list_node *node;
+
+	*worker = NULL;
+	wk->seq = wq->fifo.in;
+	if (!pl_work_ring_push(&wq->fifo, wk))
+		return -EFULL;
+
+	wk->wq = wq;
+	wk->state |= PL_WORK_STATE_QUEUED;
+
+	/* wake up an idle worker, busy workers will find the work by themselves */
+	if (!list_is_empty(&wq->idle_workers)) {
+		node = list_del_front_node(&wq->idle_workers);
+		*worker = container_of(node, struct wq_worker, idle_node);
+		(*worker)->idle = false;
+		++wq->nr_wakeups;
+	}
 
 	return OK;
 }
@@ -241,22 +665,229 @@ int pl_work_init(struct pl_work *wk, pl_work_fun_t fun, void *priv_data)
  ************************************************************************************/
 int pl_work_add(struct pl_workqueue *wq, struct pl_work *wk)
 {
-	uint_t itme_num;
+	int ret;
+	struct wq_worker *worker;
 
 	if (wk == NULL || wq == NULL)
 		return -EFAULT;
 
-	itme_num = wq->fifo_in - wq->fifo_out;
-	if (itme_num >= wq->fifo_cap)
-		return -EFULL;
+	pl_port_enter_critical();
+	/* the work is pending, it will run only once */
+	if (wk->state & PL_WORK_STATE_PENDING) {
+		pl_port_exit_critical();
+		return OK;
+	}
+
+	ret = work_enqueue(wq, wk, &worker);
+	if (ret == OK)
+		wk->state |= PL_WORK_STATE_PENDING;
+	pl_port_exit_critical();
+
+	if (worker != NULL)
+		pl_task_notify(worker->tid);
+
+	return ret;
+}
+
+/*************************************************************************************
+ * Function Name: pl_work_cancel
+ *
+ * Description:
+ *   cancel a pending work, the slot of the work is cleared and it will be
+ *   skipped by the worker, so the work can be freed once it is cancelled.
+ * 
+ * Parameters:
+ *  @wq: workqueue handle.
+ *  @wk: work.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ *  -EBUSY: the work is running and not pending.
+ *  -EEMPTY: the work is not pending.
+ ************************************************************************************/
+int pl_work_cancel(struct pl_workqueue *wq, struct pl_work *wk)
+{
+	int ret = OK;
+
+	if (wk == NULL || wq == NULL)
+		return -EFAULT;
 
 	pl_port_enter_critical();
-	wq->fifo[wq->fifo_in & (wq->fifo_cap - 1)] = wk;
-	++wq->fifo_in;
+	if (wk->wq != wq)
+		ret = -EINVAL;
+	else if (wk->state & PL_WORK_STATE_PENDING) {
+		/* a delayed work may still be pending on its timer, not in the fifo */
+		if (wk->state & PL_WORK_STATE_QUEUED)
+			*pl_work_ring_slot(&wq->fifo, wk->seq) = NULL;
+		wk->state &= (u8_t)~(PL_WORK_STATE_PENDING | PL_WORK_STATE_QUEUED);
+	} else if (wk->state & PL_WORK_STATE_RUNNING)
+		ret = -EBUSY;
+	else
+		ret = -EEMPTY;
 	pl_port_exit_critical();
 
-	pl_task_resume(wq->exec_thread);
-	return OK;
+	return ret;
+}
+
+/*************************************************************************************
+ * Function Name: pl_workqueue_flush
+ *
+ * Description:
+ *   wait until the fifo of workqueue is empty and no work is running.
+ * 
+ * Parameters:
+ *  @wq: workqueue handle.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_workqueue_flush(struct pl_workqueue *wq)
+{
+	struct wq_flusher flusher;
+
+	if (wq == NULL)
+		return -EFAULT;
+
+	pl_completion_init(&flusher.comp);
+
+	pl_port_enter_critical();
+	if (pl_work_ring_len(&wq->fifo) == 0 && wq->nr_running == 0) {
+		pl_port_exit_critical();
+		return OK;
+	}
+
+	list_add_node_at_tail(&wq->flushers, &flusher.node);
+	pl_port_exit_critical();
+
+	return pl_completion_wait(&flusher.comp);
+}
+
+/*************************************************************************************
+ * Function Name: delayed_work_timer_fun
+ *
+ * Description:
+ *   callback of the softtimer of delayed work, it queues the work.
+ * 
+ * Parameters:
+ *  @timer: softtimer of the delayed work.
+ *
+ * Return:
+ *  void.
+ ************************************************************************************/
+static void delayed_work_timer_fun(struct pl_stimer *timer)
+{
+	struct wq_worker *worker = NULL;
+	struct pl_delayed_work *dwk;
+
+	dwk = container_of(timer, struct pl_delayed_work, timer);
+
+	pl_port_enter_critical();
+	/* the work has been cancelled while the timer was running */
+	if ((dwk->work.state & PL_WORK_STATE_PENDING) &&
+	    work_enqueue(dwk->work.wq, &dwk->work, &worker) < 0)
+		dwk->work.state &= (u8_t)~PL_WORK_STATE_PENDING;
+	pl_port_exit_critical();
+
+	if (worker != NULL)
+		pl_task_notify(worker->tid);
+}
+
+/*************************************************************************************
+ * Function Name: pl_delayed_work_init
+ *
+ * Description:
+ *   initialize a delayed work.
+ * 
+ * Parameters:
+ *  @dwk: delayed work.
+ *  @fun: callback function.
+ *  @priv_data: private data.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_delayed_work_init(struct pl_delayed_work *dwk, pl_work_fun_t fun, void *priv_data)
+{
+	if (dwk == NULL)
+		return -EFAULT;
+
+	dwk->timer.name = "delayed_work";
+	dwk->timer.reload = false;
+	dwk->timer.expired = false;
+	dwk->timer.hard = false;
+	list_init(&dwk->timer.node);
+	pl_softtimer_timer_init(&dwk->timer, delayed_work_timer_fun, 0, NULL);
+
+	return pl_work_init(&dwk->work, fun, priv_data);
+}
+
+/*************************************************************************************
+ * Function Name: pl_work_add_delayed
+ *
+ * Description:
+ *   add a work to the workqueue after ticks.
+ * 
+ * Parameters:
+ *  @wq: workqueue handle.
+ *  @dwk: delayed work.
+ *  @ticks: delay ticks, the work is added at once if it is 0.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_work_add_delayed(struct pl_workqueue *wq, struct pl_delayed_work *dwk, u64_t ticks)
+{
+	int ret;
+
+	if (wq == NULL || dwk == NULL)
+		return -EFAULT;
+
+	if (ticks == 0)
+		return pl_work_add(wq, &dwk->work);
+
+	pl_port_enter_critical();
+	if (dwk->work.state & PL_WORK_STATE_PENDING) {
+		pl_port_exit_critical();
+		return OK;
+	}
+
+	dwk->work.wq = wq;
+	dwk->work.state |= PL_WORK_STATE_PENDING;
+	pl_port_exit_critical();
+
+	pl_softtimer_timer_init(&dwk->timer, delayed_work_timer_fun, ticks, NULL);
+	ret = pl_softtimer_start(&dwk->timer);
+	if (ret < 0) {
+		pl_port_enter_critical();
+		dwk->work.state &= (u8_t)~PL_WORK_STATE_PENDING;
+		pl_port_exit_critical();
+	}
+
+	return ret;
+}
+
+/*************************************************************************************
+ * Function Name: pl_delayed_work_cancel
+ *
+ * Description:
+ *   cancel a delayed work, whether its timer is running or it is in the fifo.
+ * 
+ * Parameters:
+ *  @dwk: delayed work.
+ *
+ * Return:
+ *  Greater than or equal to 0 on success, less than 0 on failure.
+ ************************************************************************************/
+int pl_delayed_work_cancel(struct pl_delayed_work *dwk)
+{
+	if (dwk == NULL)
+		return -EFAULT;
+
+	pl_softtimer_cancel(&dwk->timer);
+	if (dwk->work.wq == NULL)
+		return -EEMPTY;
+
+	return pl_work_cancel(dwk->work.wq, &dwk->work);
 }
 
 /*************************************************************************************
@@ -295,21 +926,23 @@ static int pl_sys_wq_init(void)
 {
 	int ret;
 
-	ret = pl_sys_workqueue_init(&pl_sys_hiwq, "pl_sys_hiwq", 1,
-								CONFIG_PL_HI_WORKQUEUE_TASK_STACK_SIZE,
-								CONFIG_PL_HI_WORKQUEUE_FIFO_CAPACITY,
-								pl_sys_hiwq_fifo);
+	ret = pl_workqueue_init(&pl_sys_hiwq, "pl_sys_hiwq", 1,
+							CONFIG_PL_HI_WORKQUEUE_TASK_STACK_SIZE,
+							CONFIG_PL_HI_WORKQUEUE_FIFO_CAPACITY,
+							pl_sys_hiwq_fifo, 1,
+							CONFIG_PL_HI_WORKQUEUE_WORKERS_MAX, false);
 	if (ret < 0) {
 		g_pl_sys_hiwq_handle = NULL;
 		pl_early_syslog_err("hi workqueue request failed, ret:%d\r\n", ret);
 		return ret;
 	}
 
-	ret = pl_sys_workqueue_init(&pl_sys_lowq, "pl_sys_lowq",
-								CONFIG_PL_LO_WORKQUEUE_TASK_PRIORITY,
-								CONFIG_PL_LO_WORKQUEUE_TASK_STACK_SIZE,
-								CONFIG_PL_LO_WORKQUEUE_FIFO_CAPACITY,
-								pl_sys_lowq_fifo);
+	ret = pl_workqueue_init(&pl_sys_lowq, "pl_sys_lowq",
+							CONFIG_PL_LO_WORKQUEUE_TASK_PRIORITY,
+							CONFIG_PL_LO_WORKQUEUE_TASK_STACK_SIZE,
+							CONFIG_PL_LO_WORKQUEUE_FIFO_CAPACITY,
+							pl_sys_lowq_fifo, 1,
+							CONFIG_PL_LO_WORKQUEUE_WORKERS_MAX, false);
 	if (ret < 0) {
 		g_pl_sys_lowq_handle = NULL;
 		pl_early_syslog_err("hi workqueue request failed, ret:%d\r\n", ret);
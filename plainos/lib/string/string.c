@@ -25,6 +25,28 @@ SOFTWARE.
 #include <errno.h>
 #include <lib/string.h>
 
+/* keep gcc from turning the byte and word loops back into calls of libc */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("no-tree-loop-distribute-patterns")
+#endif
+
+/* Cortex-M3/M4 move 4 words by one LDM/STM pair */
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define STRING_ARM_BURST
+#endif
+
+/* the native word, rv32 and Cortex-M use 4 bytes, it may alias any object */
+typedef uintptr_t __attribute__((__may_alias__)) string_word_t;
+
+#define STRING_WORD_SIZE                 (sizeof(string_word_t))
+#define STRING_WORD_MASK                 (STRING_WORD_SIZE - 1)
+#define STRING_WORD_BITS                 (STRING_WORD_SIZE << 3)
+#define STRING_BLOCK_SIZE                (STRING_WORD_SIZE << 2)
+#define STRING_ONES                      ((uintptr_t)-1 / 0xff)
+#define STRING_HIGHS                     (STRING_ONES << 7)
+#define string_has_zero(w)               (((w) - STRING_ONES) & ~(w) & STRING_HIGHS)
+#define string_is_aligned(p)             (((uintptr_t)(p) & STRING_WORD_MASK) == 0)
+
 int pl_lib_ull2str(char *str, unsigned long long n, unsigned char base)
 {
 	int ret;
@@ -66,27 +88,384 @@ int pl_lib_ll2str(char *str, long long n, unsigned char base)
 	return ret;
 }
 
+/*************************************************************************************
+ * Function Name: string_copy_words
+ *
+ * Description:
+ *   Copy aligned words forward, 4 words a round.
+ *
+ * Parameters:
+ *   @d: destination, aligned.
+ *   @s: source, aligned.
+ *   @words: the number of words.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void string_copy_words(string_word_t *d, const string_word_t *s, size_t words)
+{
+#ifdef STRING_ARM_BURST
+	size_t blocks = words >> 2;
+	string_word_t *bd = d;
+	const string_word_t *bs = s;
+
+	if (blocks != 0) {
+		__asm__ volatile("1:\n\t"
+		                 "ldmia %1!, {r3, r4, r5, r6}\n\t"
+		                 "stmia %0!, {r3, r4, r5, r6}\n\t"
+		                 "subs  %2, %2, #1\n\t"
+		                 "bne   1b\n\t"
+		                 : "+r"(bd), "+r"(bs), "+r"(blocks)
+		                 :
+		                 : "r3", "r4", "r5", "r6", "cc", "memory");
+		d += words & ~(size_t)3;
+		s += words & ~(size_t)3;
+	}
+#else
+	for (; words >= 4; words -= 4) {
+		d[0] = s[0];
+		d[1] = s[1];
+		d[2] = s[2];
+		d[3] = s[3];
+		d += 4;
+		s += 4;
+	}
+#endif
+
+	for (words &= 3; words != 0; words--)
+		*d++ = *s++;
+}
+
+/*************************************************************************************
+ * Function Name: string_copy_shifted
+ *
+ * Description:
+ *   Copy words forward from a misaligned source: the source is read by aligned
+ *   words and each destination word is merged from two of them, so no access is
+ *   misaligned. It never reads beyond the last source byte.
+ *
+ * Parameters:
+ *   @d: destination, aligned.
+ *   @s: source, misaligned.
+ *   @words: the number of words, one word less than the bytes left.
+ *
+ * Return:
+ *   void.
+ ************************************************************************************/
+static void string_copy_shifted(string_word_t *d, const u8_t *s, size_t words)
+{
+	uintptr_t w0;
+	uintptr_t w1;
+	uint_t shift = (uint_t)((uintptr_t)s & STRING_WORD_MASK) << 3;
+	const string_word_t *sw = (const string_word_t *)((uintptr_t)s & ~STRING_WORD_MASK);
+
+	w0 = *sw++;
+	while (words--) {
+		w1 = *sw++;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		*d++ = (w0 << shift) | (w1 >> (STRING_WORD_BITS - shift));
+#else
+		*d++ = (w0 >> shift) | (w1 << (STRING_WORD_BITS - shift));
+#endif
+		w0 = w1;
+	}
+}
+
+/*************************************************************************************
+ * Function Name: pl_memcpy
+ *
+ * Description:
+ *   Copy memory, the memory must not overlap. The head is copied by bytes until
+ *   the destination is aligned, the body by words and the tail by bytes.
+ *
+ * Parameters:
+ *   @dest: destination.
+ *   @src: source.
+ *   @len: bytes to copy.
+ *
+ * Return:
+ *   dest.
+ ************************************************************************************/
+void *pl_memcpy(void *dest, const void *src, size_t len)
+{
+	size_t words;
+	u8_t *d = dest;
+	const u8_t *s = src;
+
+	if (len >= STRING_BLOCK_SIZE) {
+		for (; !string_is_aligned(d); len--)
+			*d++ = *s++;
+
+		if (string_is_aligned(s)) {
+			words = len / STRING_WORD_SIZE;
+			string_copy_words((string_word_t *)d, (const string_word_t *)s, words);
+		} else {
+			words = len / STRING_WORD_SIZE - 1;
+			string_copy_shifted((string_word_t *)d, s, words);
+		}
+
+		d += words * STRING_WORD_SIZE;
+		s += words * STRING_WORD_SIZE;
+		len -= words * STRING_WORD_SIZE;
+	}
+
+	while (len--)
+		*d++ = *s++;
+
+	return dest;
+}
+
+/*************************************************************************************
+ * Function Name: pl_memset
+ *
+ * Description:
+ *   Fill memory with a byte, the aligned body is filled by words.
+ *
+ * Parameters:
+ *   @dest: memory to fill.
+ *   @c: value, only the low byte is used.
+ *   @len: bytes to fill.
+ *
+ * Return:
+ *   dest.
+ ************************************************************************************/
+void *pl_memset(void *dest, int c, size_t len)
+{
+	size_t words;
+	u8_t *d = dest;
+	string_word_t *dw;
+	uintptr_t w = STRING_ONES * (u8_t)c;
+
+	if (len >= STRING_BLOCK_SIZE) {
+		for (; !string_is_aligned(d); len--)
+			*d++ = (u8_t)c;
+
+		dw = (string_word_t *)d;
+		words = len / STRING_WORD_SIZE;
+		len -= words * STRING_WORD_SIZE;
+#ifdef STRING_ARM_BURST
+		if (words >= 4) {
+			size_t blocks = words >> 2;
+
+			__asm__ volatile("mov   r3, %2\n\t"
+			                 "mov   r4, %2\n\t"
+			                 "mov   r5, %2\n\t"
+			                 "mov   r6, %2\n\t"
+			                 "1:\n\t"
+			                 "stmia %0!, {r3, r4, r5, r6}\n\t"
+			                 "subs  %1, %1, #1\n\t"
+			                 "bne   1b\n\t"
+			                 : "+r"(dw), "+r"(blocks)
+			                 : "r"(w)
+			                 : "r3", "r4", "r5", "r6", "cc", "memory");
+			words &= 3;
+		}
+#else
+		for (; words >= 4; words -= 4) {
+			dw[0] = w;
+			dw[1] = w;
+			dw[2] = w;
+			dw[3] = w;
+			dw += 4;
+		}
+#endif
+		while (words--)
+			*dw++ = w;
+
+		d = (u8_t *)dw;
+	}
+
+	while (len--)
+		*d++ = (u8_t)c;
+
+	return dest;
+}
+
+/*************************************************************************************
+ * Function Name: pl_memmove
+ *
+ * Description:
+ *   Copy memory which may overlap. It copies forward by pl_memcpy() unless the
+ *   destination is inside the source, then it copies backward, by words if
+ *   both ends have the same alignment.
+ *
+ * Parameters:
+ *   @dest: destination.
+ *   @src: source.
+ *   @len: bytes to copy.
+ *
+ * Return:
+ *   dest, NULL if an address is NULL or len is 0.
+ ************************************************************************************/
 void *pl_memmove(void *dest, const void *src, size_t len)
 {
-	char *d;
-	const char *s;
-	const char *lasts;
-	char *lastd;
+	size_t words;
+	u8_t *d;
+	const u8_t *s;
+	string_word_t *dw;
+	const string_word_t *sw;
 
 	if (dest == NULL || src == NULL || len == 0)
 		return NULL;
 
 	d = dest;
 	s = src;
-	if (d < s) {
-		while (len--)
-			*d++ = *s++;
-	} else {
-		lasts = s + (len - 1);
-		lastd = d + (len - 1);
-		while (len--)
-			*lastd-- = *lasts--;
+	if (d <= s || d >= s + len)
+		return pl_memcpy(dest, src, len);
+
+	d += len;
+	s += len;
+	if (len >= STRING_BLOCK_SIZE &&
+	    ((uintptr_t)d & STRING_WORD_MASK) == ((uintptr_t)s & STRING_WORD_MASK)) {
+		for (; !string_is_aligned(d); len--)
+			*--d = *--s;
+
+		dw = (string_word_t *)d;
+		sw = (const string_word_t *)s;
+		words = len / STRING_WORD_SIZE;
+		len -= words * STRING_WORD_SIZE;
+		for (; words >= 4; words -= 4) {
+			dw -= 4;
+			sw -= 4;
+			dw[3] = sw[3];
+			dw[2] = sw[2];
+			dw[1] = sw[1];
+			dw[0] = sw[0];
+		}
+
+		while (words--)
+			*--dw = *--sw;
+
+		d = (u8_t *)dw;
+		s = (const u8_t *)sw;
 	}
 
+	while (len--)
+		*--d = *--s;
+
 	return dest;
 }
+
+/*************************************************************************************
+ * Function Name: pl_memcmp
+ *
+ * Description:
+ *   Compare memory, by words while both are aligned the same way.
+ *
+ * Parameters:
+ *   @s1: memory 1.
+ *   @s2: memory 2.
+ *   @len: bytes to compare.
+ *
+ * Return:
+ *   0 if equal, less or greater than 0 as the first different byte of s1 is.
+ ************************************************************************************/
+int pl_memcmp(const void *s1, const void *s2, size_t len)
+{
+	const u8_t *p1 = s1;
+	const u8_t *p2 = s2;
+	const string_word_t *w1;
+	const string_word_t *w2;
+
+	if (len >= STRING_BLOCK_SIZE &&
+	    ((uintptr_t)p1 & STRING_WORD_MASK) == ((uintptr_t)p2 & STRING_WORD_MASK)) {
+		for (; !string_is_aligned(p1); len--, p1++, p2++) {
+			if (*p1 != *p2)
+				return *p1 - *p2;
+		}
+
+		w1 = (const string_word_t *)p1;
+		w2 = (const string_word_t *)p2;
+		for (; len >= STRING_WORD_SIZE && *w1 == *w2; len -= STRING_WORD_SIZE) {
+			w1++;
+			w2++;
+		}
+
+		p1 = (const u8_t *)w1;
+		p2 = (const u8_t *)w2;
+	}
+
+	for (; len != 0; len--, p1++, p2++) {
+		if (*p1 != *p2)
+			return *p1 - *p2;
+	}
+
+	return 0;
+}
+
+/*************************************************************************************
+ * Function Name: pl_strlen
+ *
+ * Description:
+ *   Get the length of string, the aligned words are checked for a zero byte.
+ *   A word never crosses the end of the memory which holds the string.
+ *
+ * Parameters:
+ *   @str: string.
+ *
+ * Return:
+ *   length of string.
+ ************************************************************************************/
+size_t pl_strlen(const char *str)
+{
+	const char *p = str;
+	const string_word_t *w;
+
+	for (; !string_is_aligned(p); p++) {
+		if (*p == '\0')
+			return (size_t)(p - str);
+	}
+
+	w = (const string_word_t *)p;
+	while (!string_has_zero(*w))
+		w++;
+
+	for (p = (const char *)w; *p != '\0'; p++)
+		;
+
+	return (size_t)(p - str);
+}
+
+/*************************************************************************************
+ * Function Name: pl_strcmp
+ *
+ * Description:
+ *   Compare strings, by words while both are aligned the same way and no word
+ *   has the end of string.
+ *
+ * Parameters:
+ *   @s1: string 1.
+ *   @s2: string 2.
+ *
+ * Return:
+ *   0 if equal, less or greater than 0 as the first different char of s1 is.
+ ************************************************************************************/
+int pl_strcmp(const char *s1, const char *s2)
+{
+	const u8_t *p1 = (const u8_t *)s1;
+	const u8_t *p2 = (const u8_t *)s2;
+	const string_word_t *w1;
+	const string_word_t *w2;
+
+	if (((uintptr_t)p1 & STRING_WORD_MASK) == ((uintptr_t)p2 & STRING_WORD_MASK)) {
+		for (; !string_is_aligned(p1); p1++, p2++) {
+			if (*p1 != *p2 || *p1 == '\0')
+				return *p1 - *p2;
+		}
+
+		w1 = (const string_word_t *)p1;
+		w2 = (const string_word_t *)p2;
+		while (*w1 == *w2 && !string_has_zero(*w1)) {
+			w1++;
+			w2++;
+		}
+
+		p1 = (const u8_t *)w1;
+		p2 = (const u8_t *)w2;
+	}
+
+	for (; *p1 == *p2 && *p1 != '\0'; p1++, p2++)
+		;
+
+	return *p1 - *p2;
+}
@@ -0,0 +1,233 @@
+#include <config.h>
+#include <errno.h>
+#include <types.h>
+#include <kernel/initcall.h>
+#include <kernel/bitops.h>
+#include <port/port.h>
+#include <kernel/syslog.h>
+
+#define BITOPS_TEST_LOOPS                   (2000)
+#define BITOPS_BENCH_WORDS                  (64)
+
+static uintptr_t bitops_rand_state = 0x5a17;
+static volatile uintptr_t bitops_sink;
+
+static uintptr_t bitops_rand(void)
+{
+	uchar_t i;
+	uintptr_t x = 0;
+
+	/* 16 bits xorshift, repeated to fill a word */
+	for (i = 0; i < UINTPTR_T_BITS; i += 16) {
+		bitops_rand_state ^= (u16_t)(bitops_rand_state << 7);
+		bitops_rand_state ^= (u16_t)(bitops_rand_state >> 9);
+		bitops_rand_state ^= (u16_t)(bitops_rand_state << 8);
+		x = (x << 8) << 8;
+		x |= (u16_t)bitops_rand_state;
+	}
+
+	return x;
+}
+
+/* random words with long runs of set and clear bits, like the bitmaps of mempool */
+static uintptr_t bitops_rand_bitmap(void)
+{
+	uintptr_t x = bitops_rand();
+
+	switch (x & 3) {
+	case 0:
+		return x;
+	case 1:
+		return x | bitops_rand() | bitops_rand();
+	case 2:
+		return UINTPTR_T_MAX << (x % UINTPTR_T_BITS);
+	default:
+		return ~(bitops_rand() & bitops_rand() & bitops_rand());
+	}
+}
+
+/* the per-bit loops replaced by bitops */
+static void ref_blk_bits(uintptr_t x, uchar_t *first_bits, uchar_t *max_bits)
+{
+	size_t i;
+	uchar_t fbits = 0;
+	uchar_t bits = 0;
+	uchar_t mbits = 0;
+	uchar_t fbits_inc = 1;
+
+	for (i = 0; i < UINTPTR_T_BITS; i++) {
+		if (x & ((uintptr_t)1 << i)) {
+			fbits += fbits_inc;
+			++bits;
+		} else {
+			fbits_inc = 0;
+			mbits = bits > mbits ? bits : mbits;
+			bits = 0;
+		}
+	}
+
+	*first_bits = fbits;
+	*max_bits = bits > mbits ? bits : mbits;
+}
+
+static uchar_t ref_first_run(uintptr_t x, uchar_t n)
+{
+	size_t i;
+	size_t bits = 0;
+
+	for (i = 0; i < UINTPTR_T_BITS; i++) {
+		bits = x & ((uintptr_t)1 << i) ? bits + 1 : 0;
+		if (bits >= n)
+			return (uchar_t)(i + 1 - bits);
+	}
+
+	return UINTPTR_T_BITS;
+}
+
+static uchar_t ref_popcount(uintptr_t x)
+{
+	size_t i;
+	uchar_t cnt = 0;
+
+	for (i = 0; i < UINTPTR_T_BITS; i++) {
+		if (x & ((uintptr_t)1 << i))
+			++cnt;
+	}
+
+	return cnt;
+}
+
+static uchar_t ref_ctz(uintptr_t x)
+{
+	uchar_t i;
+
+	for (i = 0; i < UINTPTR_T_BITS; i++) {
+		if (x & ((uintptr_t)1 << i))
+			break;
+	}
+
+	return i;
+}
+
+static uchar_t ref_clz(uintptr_t x)
+{
+	uchar_t i;
+
+	for (i = 0; i < UINTPTR_T_BITS; i++) {
+		if (x & ((uintptr_t)1 << (UINTPTR_T_BITS - 1 - i)))
+			break;
+	}
+
+	return i;
+}
+
+static int bitops_check(uintptr_t x)
+{
+	uchar_t n;
+	uchar_t fbits;
+	uchar_t mbits;
+
+	ref_blk_bits(x, &fbits, &mbits);
+	if (pl_ctz(~x) != fbits || pl_bits_max_run(x) != mbits ||
+	    pl_ctz(x) != ref_ctz(x) || pl_clz(x) != ref_clz(x) ||
+	    pl_popcount(x) != ref_popcount(x))
+		return -EFAULT;
+
+	for (n = 1; n <= UINTPTR_T_BITS; n++) {
+		if (pl_bits_first_run(x, n) != ref_first_run(x, n))
+			return -EFAULT;
+	}
+
+	return 0;
+}
+
+static int bitops_diff_test(void)
+{
+	size_t i;
+	uintptr_t x;
+
+	for (i = 0; i < UINTPTR_T_BITS; i++) {
+		if (bitops_check((uintptr_t)1 << i) < 0 ||
+		    bitops_check(~((uintptr_t)1 << i)) < 0)
+			return -EFAULT;
+	}
+
+	if (bitops_check(0) < 0 || bitops_check(UINTPTR_T_MAX) < 0)
+		return -EFAULT;
+
+	for (i = 0; i < BITOPS_TEST_LOOPS; i++) {
+		x = bitops_rand_bitmap();
+		if (bitops_check(x) < 0) {
+			pl_syslog_err("bitops mismatch, x:0x%lx\r\n", (ul_t)x);
+			return -EFAULT;
+		}
+	}
+
+	return 0;
+}
+
+static void bitops_bench(void)
+{
+	int i;
+	u32_t t;
+	uchar_t fbits;
+	uchar_t mbits;
+	uintptr_t words[BITOPS_BENCH_WORDS];
+	uintptr_t sum;
+
+	for (i = 0; i < BITOPS_BENCH_WORDS; i++)
+		words[i] = bitops_rand_bitmap();
+
+	sum = 0;
+	t = pl_port_cpu_cycles();
+	for (i = 0; i < BITOPS_BENCH_WORDS; i++) {
+		ref_blk_bits(words[i], &fbits, &mbits);
+		sum += fbits + mbits + ref_first_run(words[i], 3);
+	}
+	t = pl_port_cpu_cycles() - t;
+	bitops_sink = sum;
+	pl_syslog_info("bitops loop: %u cycles/op\r\n", t / BITOPS_BENCH_WORDS);
+
+	sum = 0;
+	t = pl_port_cpu_cycles();
+	for (i = 0; i < BITOPS_BENCH_WORDS; i++) {
+		sum += pl_ctz(~words[i]) + pl_bits_max_run(words[i]);
+		sum += pl_bits_first_run(words[i], 3);
+	}
+	t = pl_port_cpu_cycles() - t;
+	bitops_sink = sum;
+	pl_syslog_info("bitops scan: %u cycles/op\r\n", t / BITOPS_BENCH_WORDS);
+
+	sum = 0;
+	t = pl_port_cpu_cycles();
+	for (i = 0; i < BITOPS_BENCH_WORDS; i++)
+		sum += ref_popcount(words[i]);
+	t = pl_port_cpu_cycles() - t;
+	bitops_sink = sum;
+	pl_syslog_info("popcount loop: %u cycles/op\r\n", t / BITOPS_BENCH_WORDS);
+
+	sum = 0;
+	t = pl_port_cpu_cycles();
+	for (i = 0; i < BITOPS_BENCH_WORDS; i++)
+		sum += pl_popcount(words[i]);
+	t = pl_port_cpu_cycles() - t;
+	bitops_sink = sum;
+	pl_syslog_info("popcount: %u cycles/op\r\n", t / BITOPS_BENCH_WORDS);
+}
+
+static int bitops_test(void)
+{
+	int ret;
+
+	pl_syslog_info("bitops test\r\n");
+	ret = bitops_diff_test();
+	if (ret < 0) {
+		pl_syslog_err("bitops differential test failed\r\n");
+		return ret;
+	}
+
+	bitops_bench();
+	pl_syslog_info("bitops test done\r\n");
+	return 0;
+}
+pl_late_initcall(bitops_test);
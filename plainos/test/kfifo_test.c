@@ -1,4 +1,5 @@
 
+#include <errno.h>
 #include <port/port.h>
 #include <kernel/assert.h>
 #include <kernel/initcall.h>
@@ -8,9 +9,85 @@
 
 
 static char read_data[100] = {0};
+static char span_buff[16];
+
+/* reserve/commit and peek/consume around the end of the buffer */
+static int kfifo_span_test(void)
+{
+	uint_t i;
+	uint_t len;
+	char *buff;
+	struct pl_kfifo kfifo;
+	struct pl_kfifo_iovec iov[2];
+
+	if (pl_kfifo_init(&kfifo, span_buff, sizeof(span_buff)) < 0)
+		return -EFAULT;
+
+	/* move the indexes to 12, the free space wraps */
+	pl_kfifo_commit(&kfifo, 12);
+	pl_kfifo_consume(&kfifo, 12);
+	len = pl_kfifo_reserve(&kfifo, &buff);
+	if (len != 4 || buff != span_buff + 12)
+		return -EINVAL;
+
+	if (pl_kfifo_reserve_iov(&kfifo, iov) != 16 || iov[0].len != 4 ||
+	    iov[1].base != span_buff || iov[1].len != 12)
+		return -EINVAL;
+
+	for (i = 0; i < 4; i++)
+		iov[0].base[i] = (char)('a' + i);
+
+	for (i = 0; i < 6; i++)
+		iov[1].base[i] = (char)('e' + i);
+
+	if (pl_kfifo_commit(&kfifo, 10) != 10 || pl_kfifo_len(&kfifo) != 10)
+		return -EINVAL;
+
+	if (pl_kfifo_peek_iov(&kfifo, iov) != 10 || iov[0].len != 4 || iov[1].len != 6 ||
+	    iov[0].base[0] != 'a' || iov[1].base[5] != 'j')
+		return -EINVAL;
+
+	if (pl_kfifo_peek(&kfifo, &buff) != 4 || pl_kfifo_consume(&kfifo, 20) != 10)
+		return -EINVAL;
+
+	return (pl_kfifo_peek(&kfifo, &buff) == 0) ? 0 : -EINVAL;
+}
+
+/* records wrap around the end of the buffer, a full record is refused */
+static int kfifo_rec_test(void)
+{
+	uint_t i;
+	char rec[8];
+	struct pl_kfifo kfifo;
+
+	if (pl_kfifo_init(&kfifo, span_buff, sizeof(span_buff)) < 0)
+		return -EFAULT;
+
+	for (i = 0; i < 5; i++) {
+		if (pl_kfifo_rec_put(&kfifo, "abcdef", 1 + i) != 1 + i)
+			return -EINVAL;
+
+		if (pl_kfifo_rec_put(&kfifo, "0123456789abcdef", 16) != 0)
+			return -EINVAL;
+
+		if (pl_kfifo_rec_peek_len(&kfifo) != 1 + i ||
+		    pl_kfifo_rec_get(&kfifo, rec, i) != 0 ||
+		    pl_kfifo_rec_get(&kfifo, rec, sizeof(rec)) != 1 + i || rec[i] != (char)('a' + i))
+			return -EINVAL;
+	}
+
+	pl_kfifo_rec_put(&kfifo, "abc", 3);
+	pl_kfifo_rec_put(&kfifo, "defg", 4);
+	if (pl_kfifo_rec_skip(&kfifo) != 3 || pl_kfifo_rec_get(&kfifo, rec, 4) != 4 ||
+	    rec[0] != 'd')
+		return -EINVAL;
+
+	return (pl_kfifo_rec_peek_len(&kfifo) == 0) ? 0 : -EINVAL;
+}
 
 static int kfifo_test(void)
 {
+	int ret;
 	uint_t data_num;
 	struct pl_kfifo *kfifo = pl_kfifo_request(128);
 
@@ -32,6 +109,14 @@ static int kfifo_test(void)
 
 	data_num = pl_kfifo_get(kfifo, read_data, 50);
 
+	ret = kfifo_span_test();
+	if (ret < 0)
+		pl_syslog_err("kfifo span test failed, ret:%d\r\n", ret);
+
+	ret = kfifo_rec_test();
+	if (ret < 0)
+		pl_syslog_err("kfifo record test failed, ret:%d\r\n", ret);
+
 	pl_port_enter_critical();
 	pl_syslog_info("data_num:%d, get3:%s end\r\n", data_num, read_data);
 	pl_syslog_info("%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%\r\n");
@@ -0,0 +1,104 @@
+#include <config.h>
+#include <errno.h>
+#include <types.h>
+#include <kernel/initcall.h>
+#include <port/port.h>
+#include <kernel/syslog.h>
+#include <kernel/mempool.h>
+#include <kernel/kmem_cache.h>
+#include <kernel/softtimer.h>
+
+#define KMEM_TEST_TIMERS                    (100)
+
+static void *kmem_test_objs[KMEM_TEST_TIMERS];
+
+static int kmem_cache_api_test(void)
+{
+	int i;
+	int ret;
+	struct pl_kmem_cache *cache;
+
+	cache = pl_kmem_cache_create("test", 20, 4, g_pl_default_mempool);
+	if (cache == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < 10; i++) {
+		kmem_test_objs[i] = pl_kmem_cache_alloc(cache);
+		if (kmem_test_objs[i] == NULL)
+			return -ENOMEM;
+
+		pl_mempool_set(g_pl_default_mempool, kmem_test_objs[i], (u8_t)i, 20);
+	}
+
+	for (i = 0; i < 10; i++) {
+		if (*(u8_t *)kmem_test_objs[i] != (u8_t)i ||
+		    ((u8_t *)kmem_test_objs[i])[19] != (u8_t)i)
+			return -EFAULT;
+	}
+
+	if (cache->nr_slabs != 3 || pl_kmem_cache_destroy(cache) != -EBUSY)
+		return -EFAULT;
+
+	for (i = 0; i < 10; i++)
+		pl_kmem_cache_free(cache, kmem_test_objs[i]);
+
+	ret = pl_kmem_cache_destroy(cache);
+	return ret;
+}
+
+static void kmem_cache_timer_bench(void)
+{
+	int i;
+	u32_t t_alloc;
+	u32_t t_free;
+	size_t free_bytes;
+	size_t used_bytes;
+
+	/* soft timers from cache */
+	free_bytes = pl_mempool_get_free_bytes(g_pl_default_mempool);
+	t_alloc = pl_port_cpu_cycles();
+	for (i = 0; i < KMEM_TEST_TIMERS; i++)
+		kmem_test_objs[i] = pl_softtimer_request("kmem_test");
+	t_alloc = pl_port_cpu_cycles() - t_alloc;
+	used_bytes = free_bytes - pl_mempool_get_free_bytes(g_pl_default_mempool);
+
+	t_free = pl_port_cpu_cycles();
+	for (i = 0; i < KMEM_TEST_TIMERS; i++)
+		pl_softtimer_release(kmem_test_objs[i]);
+	t_free = pl_port_cpu_cycles() - t_free;
+	pl_syslog_info("cache: %u bytes, alloc %u cycles, free %u cycles\r\n",
+	               (u32_t)used_bytes, t_alloc, t_free);
+
+	/* the same objects from mempool */
+	free_bytes = pl_mempool_get_free_bytes(g_pl_default_mempool);
+	t_alloc = pl_port_cpu_cycles();
+	for (i = 0; i < KMEM_TEST_TIMERS; i++)
+		kmem_test_objs[i] = pl_mempool_malloc(g_pl_default_mempool,
+		                                      sizeof(struct pl_stimer));
+	t_alloc = pl_port_cpu_cycles() - t_alloc;
+	used_bytes = free_bytes - pl_mempool_get_free_bytes(g_pl_default_mempool);
+
+	t_free = pl_port_cpu_cycles();
+	for (i = 0; i < KMEM_TEST_TIMERS; i++)
+		pl_mempool_free(g_pl_default_mempool, kmem_test_objs[i]);
+	t_free = pl_port_cpu_cycles() - t_free;
+	pl_syslog_info("mempool: %u bytes, alloc %u cycles, free %u cycles\r\n",
+	               (u32_t)used_bytes, t_alloc, t_free);
+}
+
+static int kmem_cache_test(void)
+{
+	int ret;
+
+	pl_syslog_info("kmem cache test\r\n");
+	ret = kmem_cache_api_test();
+	if (ret < 0) {
+		pl_syslog_err("kmem cache api test failed, ret:%d\r\n", ret);
+		return ret;
+	}
+
+	kmem_cache_timer_bench();
+	pl_syslog_info("kmem cache test done\r\n");
+	return 0;
+}
+pl_late_initcall(kmem_cache_test);
@@ -1,22 +1,51 @@
+#include <config.h>
+#include <errno.h>
 #include <kernel/initcall.h>
 #include <kernel/mempool.h>
+#include <kernel/arena.h>
+#include <kernel/semaphore.h>
 #include <kernel/syslog.h>
+#include <kernel/task.h>
 
+#define MEMPOOL_BENCH_TASKS             (4)
+#define MEMPOOL_BENCH_OPS               (2000)
+#define MEMPOOL_BENCH_SLOTS             (4)
+/* the free lists of TLSF take about 300 bytes of a small pool */
+#ifdef CONFIG_PL_MEMPOOL_TLSF
+#define MEMPOOL_BENCH_POOL_SIZE         (768)
+#else
+#define MEMPOOL_BENCH_POOL_SIZE         (512)
+#endif
+#define MEMPOOL_REALLOC_POOL_SIZE       (2048)
+
+#ifndef CONFIG_PL_MEMPOOL_TLSF
 struct mempool {
 	ushrt_t id;
 	uchar_t state;
 	uchar_t grain_order;
+	uchar_t lock;
 	size_t blk_num;
 	uintptr_t *blk_bitmaps;
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	uintptr_t *blk_heads;
+#endif
 	uchar_t *blk_first_bits;
 	uchar_t *blk_max_bits;
 	size_t data_pool_size;
 	uchar_t *data_pool;
+	size_t used_bytes;
+	size_t peak_used;
+	size_t nr_allocs;
+	size_t nr_fails;
+	struct pl_sem sem;
 };
 
 struct mempool_data {
 	size_t bit_idx;
 	size_t bit_num;
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	void *owner;
+#endif
 	uchar_t *data[0];
 };
 
@@ -32,9 +61,366 @@ static void dump_mempool(void)
 		pl_syslog_info("----------------------------------------------------\r\n");
 	}
 }
+#else
+static void dump_mempool(void)
+{
+}
+#endif
+
+static char *bench_argv[MEMPOOL_BENCH_TASKS][2];
+static void *bench_pool_data[MEMPOOL_BENCH_TASKS];
+
+static int mempool_bench_task(int argc, char *argv[])
+{
+	int i;
+	void *p[MEMPOOL_BENCH_SLOTS] = {NULL};
+	pl_mempool_handle_t mp = (pl_mempool_handle_t)argv[0];
+
+	USED(argc);
+	for (i = 0; i < MEMPOOL_BENCH_OPS; i++) {
+		pl_mempool_free(mp, p[i % MEMPOOL_BENCH_SLOTS]);
+		p[i % MEMPOOL_BENCH_SLOTS] = pl_mempool_malloc(mp, 16 + (i & 31));
+	}
+
+	for (i = 0; i < MEMPOOL_BENCH_SLOTS; i++)
+		pl_mempool_free(mp, p[i]);
+
+	return 0;
+}
+
+/* four tasks of the same priority, each task allocates from bench_argv[i][0] */
+static int mempool_bench_round(const char *name)
+{
+	int i;
+	int ret;
+	u64_t ticks;
+	u64_t now;
+	u32_t switches;
+	u32_t now_switches;
+	pl_tid_t tids[MEMPOOL_BENCH_TASKS];
+
+	pl_task_get_syscount(&ticks);
+	pl_task_get_switch_count(&switches);
+	for (i = 0; i < MEMPOOL_BENCH_TASKS; i++) {
+		tids[i] = pl_task_create("mp_bench", mempool_bench_task,
+		                         CONFIG_PL_TASK_PRIORITIES_MAX - 3, 256, 1,
+		                         bench_argv[i]);
+		if (tids[i] == NULL) {
+			pl_syslog_err("mempool bench task create failed\r\n");
+			return -ENOMEM;
+		}
+	}
+
+	for (i = 0; i < MEMPOOL_BENCH_TASKS; i++)
+		pl_task_join(tids[i], &ret);
+
+	pl_task_get_syscount(&now);
+	pl_task_get_switch_count(&now_switches);
+	pl_syslog_info("%s: %u ops in %u ticks, %u switches\r\n", name,
+	               MEMPOOL_BENCH_TASKS * MEMPOOL_BENCH_OPS * 2,
+	               (u32_t)(now - ticks), now_switches - switches);
+	return 0;
+}
+
+static int mempool_bench_init_pools(enum pl_mempool_lock lock)
+{
+	int i;
+	pl_mempool_handle_t mp;
+
+	for (i = 0; i < MEMPOOL_BENCH_TASKS; i++) {
+		mp = pl_mempool_init_lock(bench_pool_data[i], (ushrt_t)(i + 1),
+		                          MEMPOOL_BENCH_POOL_SIZE, 4, lock);
+		if (mp == NULL)
+			return -ENOMEM;
+
+		bench_argv[i][0] = (char *)mp;
+	}
+
+	return 0;
+}
+
+static int mempool_bench(int argc, char *argv[])
+{
+	int i;
+	void *p;
+
+	USED(argc);
+	USED(argv);
+	for (i = 0; i < MEMPOOL_BENCH_TASKS; i++) {
+		bench_pool_data[i] = pl_mempool_malloc(g_pl_default_mempool,
+		                                       MEMPOOL_BENCH_POOL_SIZE);
+		if (bench_pool_data[i] == NULL) {
+			pl_syslog_err("mempool bench pool alloc failed\r\n");
+			return -ENOMEM;
+		}
+	}
+
+	for (i = 0; i < MEMPOOL_BENCH_TASKS; i++)
+		bench_argv[i][0] = (char *)g_pl_default_mempool;
+	mempool_bench_round("shared pool");
+
+	if (mempool_bench_init_pools(PL_MEMPOOL_LOCK_SEM) < 0)
+		return -ENOMEM;
+	mempool_bench_round("own pool, sem");
+
+	p = pl_mempool_malloc_isr(bench_argv[0][0], 16);
+	if (p != NULL)
+		pl_syslog_err("malloc_isr from semaphore pool\r\n");
+
+	if (mempool_bench_init_pools(PL_MEMPOOL_LOCK_CRITICAL) < 0)
+		return -ENOMEM;
+	mempool_bench_round("own pool, critical");
+
+	p = pl_mempool_malloc_isr(bench_argv[0][0], 16);
+	if (p == NULL)
+		pl_syslog_err("malloc_isr from ISR-safe pool failed\r\n");
+	pl_mempool_free_isr(bench_argv[0][0], p);
+
+	if (mempool_bench_init_pools(PL_MEMPOOL_LOCK_NONE) < 0)
+		return -ENOMEM;
+	mempool_bench_round("own pool, none");
+
+	for (i = 0; i < MEMPOOL_BENCH_TASKS; i++)
+		pl_mempool_free(g_pl_default_mempool, bench_pool_data[i]);
+
+	pl_syslog_info("mempool bench done\r\n");
+	return 0;
+}
+
+static u8_t realloc_pool_data[MEMPOOL_REALLOC_POOL_SIZE];
+
+/* a pool of its own, so the memory after the first allocation is known free */
+static int mempool_realloc_test(void)
+{
+	u8_t *p;
+	u8_t *q;
+	u8_t *guard;
+	size_t align;
+	size_t free_bytes;
+	pl_mempool_handle_t mp;
+
+	mp = pl_mempool_init(realloc_pool_data, 0, MEMPOOL_REALLOC_POOL_SIZE, 4);
+	if (mp == NULL)
+		return -ENOMEM;
+
+	/* growth in place */
+	free_bytes = pl_mempool_get_free_bytes(mp);
+	p = pl_mempool_malloc(mp, 40);
+	if (p == NULL)
+		return -ENOMEM;
+
+	pl_mempool_set(mp, p, 0x5a, 40);
+	if (pl_mempool_realloc(mp, p, 200) != p)
+		return -EFAULT;
+
+	/* growth with a move, the memory after p is in use */
+	guard = pl_mempool_malloc(mp, 16);
+	q = pl_mempool_realloc(mp, p, 400);
+	if (q == NULL || q == p || q[0] != 0x5a || q[39] != 0x5a)
+		return -EFAULT;
+
+	/* shrink in place */
+	p = pl_mempool_realloc(mp, q, 20);
+	if (p != q)
+		return -EFAULT;
+
+	pl_mempool_free(mp, p);
+	pl_mempool_free(mp, guard);
+
+	/* DMA descriptors need 32 to 1024 bytes */
+	for (align = 32; align <= 1024; align <<= 1) {
+		p = pl_mempool_memalign(mp, align, 64);
+		if (p == NULL)
+			return -ENOMEM;
+
+		pl_mempool_set(mp, p, 0, 64);
+		pl_mempool_free(mp, p);
+		if (((uintptr_t)p & (align - 1)) != 0)
+			return -EFAULT;
+	}
+
+	return (pl_mempool_get_free_bytes(mp) == free_bytes) ? 0 : -EFAULT;
+}
+
+static int mempool_stats_test(void)
+{
+	int i;
+	u8_t *p[4];
+	struct pl_mempool_stats stats;
+	pl_mempool_handle_t mp;
+
+	mp = pl_mempool_init(realloc_pool_data, 0, MEMPOOL_REALLOC_POOL_SIZE, 4);
+	if (mp == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < 4; i++) {
+		p[i] = pl_mempool_malloc(mp, 100);
+		if (p[i] == NULL)
+			return -ENOMEM;
+	}
+
+	/* a hole between p[0] and p[2] */
+	pl_mempool_free(mp, p[1]);
+	if (pl_mempool_malloc(mp, MEMPOOL_REALLOC_POOL_SIZE) != NULL)
+		return -EFAULT;
+
+	if (pl_mempool_get_stats(mp, &stats) < 0)
+		return -EFAULT;
+
+	if (stats.nr_allocs != 3 || stats.nr_fails != 1 || stats.free_frags != 2 ||
+	    stats.free_bytes != pl_mempool_get_free_bytes(mp) ||
+	    stats.largest_free >= stats.free_bytes ||
+	    stats.peak_used < stats.total_bytes - stats.free_bytes)
+		return -EFAULT;
+
+#ifdef CONFIG_PL_MEMPOOL_OWNER
+	/* p[0] and p[3] are leaked by a dead owner */
+	pl_mempool_set_owner(mp, p[0], p);
+	pl_mempool_set_owner(mp, p[3], p);
+	if (pl_mempool_get_owner_bytes(mp, p) < 200 ||
+	    pl_mempool_free_owner(mp, p) != 2 ||
+	    pl_mempool_get_owner_bytes(mp, p) != 0)
+		return -EFAULT;
+
+	pl_mempool_free(mp, p[2]);
+#else
+	for (i = 0; i < 4; i++) {
+		if (i != 1)
+			pl_mempool_free(mp, p[i]);
+	}
+#endif
+
+	pl_mempool_get_stats(mp, &stats);
+	return (stats.nr_allocs == 0 && stats.free_frags == 1) ? 0 : -EFAULT;
+}
+
+/* objects of the size fit in the pool with and without header */
+static void mempool_sized_count(pl_mempool_handle_t mp, size_t size)
+{
+	void *p;
+	u8_t *prev;
+	size_t nr_malloc = 0;
+	size_t nr_sized = 0;
+
+	for (prev = NULL; (p = pl_mempool_malloc(mp, size)) != NULL; prev = p) {
+		*(u8_t **)p = prev;
+		nr_malloc++;
+	}
+
+	for (p = prev; p != NULL; p = prev) {
+		prev = *(u8_t **)p;
+		pl_mempool_free(mp, p);
+	}
+
+	for (prev = NULL; (p = pl_mempool_alloc_sized(mp, size)) != NULL; prev = p) {
+		*(u8_t **)p = prev;
+		nr_sized++;
+	}
+
+	for (p = prev; p != NULL; p = prev) {
+		prev = *(u8_t **)p;
+		pl_mempool_free_sized(mp, p, size);
+	}
+
+	pl_syslog_info("%u bytes objects: malloc %u, sized %u\r\n",
+	               (u32_t)size, (u32_t)nr_malloc, (u32_t)nr_sized);
+}
+
+static int mempool_sized_test(void)
+{
+	int i;
+	u8_t *p[8];
+	size_t size;
+	size_t free_bytes;
+	pl_mempool_handle_t mp;
+
+	mp = pl_mempool_init(realloc_pool_data, 0, MEMPOOL_REALLOC_POOL_SIZE,
+	                     CONFIG_PL_DEFAULT_MEMPOOL_GRAIN_ORDER);
+	if (mp == NULL)
+		return -ENOMEM;
+
+	free_bytes = pl_mempool_get_free_bytes(mp);
+	for (i = 0; i < 8; i++) {
+		p[i] = pl_mempool_alloc_sized(mp, 24);
+		if (p[i] == NULL)
+			return -ENOMEM;
+
+		pl_mempool_set(mp, p[i], (u8_t)i, 24);
+	}
+
+#if defined(CONFIG_PL_MEMPOOL_OWNER) && !defined(CONFIG_PL_MEMPOOL_TLSF)
+	/* the memory without header is not walked */
+	if (pl_mempool_get_owner_bytes(mp, NULL) != 0)
+		return -EFAULT;
+#endif
+
+	for (i = 0; i < 8; i++) {
+		if (p[i][0] != (u8_t)i || p[i][23] != (u8_t)i)
+			return -EFAULT;
+
+		pl_mempool_free_sized(mp, p[i], 24);
+	}
+
+	if (pl_mempool_get_free_bytes(mp) != free_bytes)
+		return -EFAULT;
+
+	for (size = 16; size <= 64; size += 8)
+		mempool_sized_count(mp, size);
+
+	return (pl_mempool_get_free_bytes(mp) == free_bytes) ? 0 : -EFAULT;
+}
+
+#ifdef CONFIG_PL_BOOT_ARENA
+/* the late initcalls run before the arena is sealed */
+static int mempool_arena_test(void)
+{
+	u8_t *p;
+	size_t used;
+
+	used = pl_arena_get_used_bytes();
+
+	p = pl_arena_alloc(1);
+	if (p == NULL)
+		return -ENOMEM;
+
+	if (!pl_arena_contains(p) || pl_arena_contains(realloc_pool_data) ||
+	    ((uintptr_t)p & (2 * sizeof(uintptr_t) - 1)) != 0 ||
+	    pl_arena_get_used_bytes() <= used)
+		return -EFAULT;
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+/* the default pool serves every flag, the memory comes back to its region */
+static int mempool_region_test(void)
+{
+	void *p;
+	size_t free_bytes;
+	struct pl_mempool_region region;
+
+	if (pl_mempool_get_region(0, &region) < 0 || pl_mempool_region_of(&region) != NULL)
+		return -EFAULT;
+
+	free_bytes = pl_mempool_get_free_bytes(g_pl_default_mempool);
+	p = pl_mempool_malloc_flags(64, PL_MEMPOOL_DMA);
+	if (p == NULL)
+		return -ENOMEM;
+
+	if (pl_mempool_region_of(p) != g_pl_default_mempool) {
+		pl_mempool_free_flags(p);
+		return -EFAULT;
+	}
+
+	pl_mempool_free_flags(p);
+	return (pl_mempool_get_free_bytes(g_pl_default_mempool) == free_bytes) ? 0 : -EFAULT;
+}
+#endif
 
 static int mempool_test(void)
 {
+	int ret;
 	void *p;
 	size_t mempool_size;
 	
@@ -54,6 +440,34 @@ static int mempool_test(void)
 	pl_syslog_info("free 200 after - mempool_size:%d\r\n", mempool_size);
 	dump_mempool();
 
+	ret = mempool_realloc_test();
+	if (ret < 0)
+		pl_syslog_err("mempool realloc test failed, ret:%d\r\n", ret);
+
+	ret = mempool_stats_test();
+	if (ret < 0)
+		pl_syslog_err("mempool stats test failed, ret:%d\r\n", ret);
+
+	ret = mempool_sized_test();
+	if (ret < 0)
+		pl_syslog_err("mempool sized test failed, ret:%d\r\n", ret);
+
+#ifdef CONFIG_PL_BOOT_ARENA
+	ret = mempool_arena_test();
+	if (ret < 0)
+		pl_syslog_err("mempool arena test failed, ret:%d\r\n", ret);
+#endif
+
+#ifdef CONFIG_PL_MEMPOOL_REGIONS
+	ret = mempool_region_test();
+	if (ret < 0)
+		pl_syslog_err("mempool region test failed, ret:%d\r\n", ret);
+#endif
+
+	if (pl_task_create("mp_bench", mempool_bench, CONFIG_PL_TASK_PRIORITIES_MAX - 2,
+	                   512, 0, NULL) == NULL)
+		pl_syslog_err("mempool bench task create failed\r\n");
+
 	return 0;
 }
 pl_late_initcall(mempool_test);
@@ -0,0 +1,139 @@
+#include <config.h>
+#include <errno.h>
+#include <types.h>
+#include <lib/string.h>
+#include <kernel/initcall.h>
+#include <kernel/kfifo.h>
+#include <kernel/pipe.h>
+#include <kernel/syslog.h>
+#include <kernel/task.h>
+
+#define PIPE_BENCH_BYTES                (1024)
+#define PIPE_BENCH_WAKE_CHARS           (16)
+#define PIPE_BENCH_LATENCY_US           (2000)
+
+static char pipe_buff[64];
+static char pipe_data[64];
+static struct pl_kfifo pipe_fifo;
+static struct pl_pipe test_pipe;
+static volatile uint_t bench_read;
+
+/* a full or empty pipe returns at once or after the timeout */
+static int pipe_basic_test(void)
+{
+	int i;
+	int ret;
+
+	pl_kfifo_init(&pipe_fifo, pipe_buff, sizeof(pipe_buff));
+	pl_pipe_init(&test_pipe, &pipe_fifo);
+	if (pl_pipe_read(&test_pipe, pipe_data, sizeof(pipe_data), PL_PIPE_NOWAIT) != -EAGAIN)
+		return -EINVAL;
+
+	if (pl_pipe_read(&test_pipe, pipe_data, sizeof(pipe_data), 5) != -ETIMEOUT)
+		return -EINVAL;
+
+	for (i = 0; i < (int)sizeof(pipe_data); i++)
+		pipe_data[i] = (char)i;
+
+	ret = pl_pipe_write(&test_pipe, pipe_data, sizeof(pipe_data), PL_PIPE_NOWAIT);
+	if (ret != (int)sizeof(pipe_buff))
+		return -EINVAL;
+
+	if (pl_pipe_write(&test_pipe, pipe_data, 1, 5) != -ETIMEOUT)
+		return -EINVAL;
+
+	pl_pipe_set_read_wake(&test_pipe, 32, '\r', 0);
+	pl_memset(pipe_data, 0, sizeof(pipe_data));
+	if (pl_pipe_read(&test_pipe, pipe_data, sizeof(pipe_data), PL_PIPE_NOWAIT) != 64 ||
+	    pipe_data[63] != 63)
+		return -EINVAL;
+
+	/* 10 bytes are below the watermark, the delimiter wakes the reader */
+	pl_pipe_write(&test_pipe, "led on\r", 7, PL_PIPE_NOWAIT);
+	pl_pipe_write(&test_pipe, "led", 3, PL_PIPE_NOWAIT);
+	if (pl_pipe_read(&test_pipe, pipe_data, sizeof(pipe_data), PL_PIPE_NOWAIT) != 10)
+		return -EINVAL;
+
+	/* no delimiter left, 3 bytes are kept until the timeout */
+	pl_pipe_write(&test_pipe, "led", 3, PL_PIPE_NOWAIT);
+	if (pl_pipe_read(&test_pipe, pipe_data, sizeof(pipe_data), 5) != 3)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int pipe_bench_reader(int argc, char *argv[])
+{
+	int ret;
+	char chars[PIPE_BENCH_WAKE_CHARS];
+
+	USED(argc);
+	USED(argv);
+	while (bench_read < PIPE_BENCH_BYTES) {
+		ret = pl_pipe_read(&test_pipe, chars, sizeof(chars), PL_PIPE_WAIT_FOREVER);
+		if (ret > 0)
+			bench_read += ret;
+	}
+
+	return 0;
+}
+
+/* console lines arrive one byte a tick, as the interrupts of a slow uart */
+static int pipe_bench(uint_t wake_len, int delim, u32_t latency)
+{
+	uint_t i;
+	const char *line = "gpio set 3 1\r";
+
+	pl_kfifo_init(&pipe_fifo, pipe_buff, sizeof(pipe_buff));
+	pl_pipe_init(&test_pipe, &pipe_fifo);
+	pl_pipe_set_read_wake(&test_pipe, wake_len, delim, latency);
+	bench_read = 0;
+	if (pl_task_create("pipe_reader", pipe_bench_reader,
+	                   CONFIG_PL_TASK_PRIORITIES_MAX - 3, 512, 0, NULL) == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < PIPE_BENCH_BYTES; i++) {
+		pl_pipe_write(&test_pipe, line + i % 13, 1, PL_PIPE_WAIT_FOREVER);
+		pl_task_delay_ticks(1);
+	}
+
+	while (bench_read < PIPE_BENCH_BYTES)
+		pl_task_delay_ticks(10);
+
+	pl_syslog_info("pipe wake:%u delim:%d latency:%u wakeups per KB:%u\r\n",
+	               wake_len, delim, (uint_t)latency, (uint_t)test_pipe.nr_wakeups);
+	return 0;
+}
+
+static int pipe_test_task(int argc, char *argv[])
+{
+	int ret;
+
+	USED(argc);
+	USED(argv);
+	ret = pipe_basic_test();
+	if (ret < 0) {
+		pl_syslog_err("pipe basic test failed, ret:%d\r\n", ret);
+		return ret;
+	}
+
+	/* waking per byte, as the shell did, then the watermarks of the shell */
+	pipe_bench(1, PL_PIPE_NO_DELIM, 0);
+	pipe_bench(PIPE_BENCH_WAKE_CHARS, '\r',
+	           PIPE_BENCH_LATENCY_US / CONFIG_PL_SYSTICK_TIME_SLICE_US);
+	pl_syslog_info("pipe test done\r\n");
+	return 0;
+}
+
+static int pipe_test(void)
+{
+	pl_syslog_info("pipe test\r\n");
+	if (pl_task_create("pipe_test", pipe_test_task,
+	                   CONFIG_PL_TASK_PRIORITIES_MAX - 2, 512, 0, NULL) == NULL) {
+		pl_syslog_err("pipe test task create failed\r\n");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+pl_late_initcall(pipe_test);
@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <kernel/initcall.h>
 #include <kernel/softtimer.h>
 #include <kernel/syslog.h>
@@ -8,6 +9,8 @@
 static struct pl_stimer *stimer;
 static struct pl_stimer *stimer2;
 static struct gpio_desc *gpio_desc;
+static struct pl_stimer *siblings[2];
+static volatile u8_t sibling_runs;
 
 static void stimer_callback(struct pl_stimer *timer)
 {
@@ -17,7 +20,7 @@ static void stimer_callback(struct pl_stimer *timer)
 
 	pl_softtimer_get_private_data(timer, &data);
 	pl_port_putc('A');
-	ret = pl_softtimer_reload(timer, true, stimer_callback, 20, data);
+	ret = pl_softtimer_reload(timer, true, stimer_callback, 20, 0, data);
 	if (ret < 0) {
 		pl_syslog_err("pl_softtimer_add failed, ret:%d\r\n", ret);
 	}
@@ -35,13 +38,73 @@ static void stimer_callback2(struct pl_stimer *timer)
 
 	pl_softtimer_get_private_data(timer, &data);
 	pl_port_putc('B');
-	ret = pl_softtimer_reload(timer, true, stimer_callback2, 99, data);
+	ret = pl_softtimer_reload(timer, true, stimer_callback2, 99, 0, data);
 	if (ret < 0) {
 		pl_syslog_err("pl_softtimer_add failed, ret:%d\r\n", ret);
 		return;
 	}
 }
 
+/* the first sibling called cancels and releases the other one of the same tick */
+static void sibling_callback(struct pl_stimer *timer)
+{
+	uintptr_t other = !(uintptr_t)timer->priv_data;
+
+	++sibling_runs;
+	if (siblings[other] != NULL) {
+		pl_softtimer_cancel(siblings[other]);
+		pl_softtimer_release(siblings[other]);
+		siblings[other] = NULL;
+	}
+}
+
+static void sibling_reuse_callback(struct pl_stimer *timer)
+{
+	USED(timer);
+	++sibling_runs;
+}
+
+static int stimer_sibling_test(void)
+{
+	uintptr_t i;
+	struct pl_stimer *reuse;
+
+	sibling_runs = 0;
+	for (i = 0; i < 2; i++) {
+		siblings[i] = pl_softtimer_request("sibling");
+		if (siblings[i] == NULL)
+			return -ENOMEM;
+
+		pl_softtimer_reload(siblings[i], false, sibling_callback, 10, 0, (void *)i);
+	}
+
+	/* both expire on the same tick and are taken by the daemon together */
+	pl_port_enter_critical();
+	pl_softtimer_start(siblings[0]);
+	pl_softtimer_start(siblings[1]);
+	pl_port_exit_critical();
+	pl_task_delay_ticks(30);
+	if (sibling_runs != 1)
+		return -EINVAL;
+
+	/* the memory of the sibling released is taken again, the daemon must not
+	 * touch it any more */
+	reuse = pl_softtimer_request("sibling_reuse");
+	if (reuse == NULL)
+		return -ENOMEM;
+
+	pl_softtimer_reload(reuse, false, sibling_reuse_callback, 5, 0, NULL);
+	pl_softtimer_start(reuse);
+	pl_task_delay_ticks(20);
+	pl_softtimer_release(reuse);
+	for (i = 0; i < 2; i++) {
+		if (siblings[i] != NULL)
+			pl_softtimer_release(siblings[i]);
+	}
+
+	return (sibling_runs == 2) ? 0 : -EINVAL;
+}
+
 static int stimer_test(void)
 {
 	int ret;
@@ -81,8 +144,14 @@ static int stimer_test(void)
 
 static int softtimer_test_task(int argc, char *argv[])
 {
+	int ret;
+
 	USED(argc);
 	USED(argv);
+	ret = stimer_sibling_test();
+	if (ret < 0)
+		pl_syslog_err("softtimer sibling test failed, ret:%d\r\n", ret);
+
 	stimer_test();
 	return 900;
 }
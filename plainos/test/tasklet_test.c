@@ -0,0 +1,128 @@
+#include <config.h>
+#include <errno.h>
+#include <types.h>
+#include <kernel/initcall.h>
+#include <port/port.h>
+#include <kernel/syslog.h>
+#include <kernel/task.h>
+#include <kernel/tasklet.h>
+#include <kernel/softtimer.h>
+#include <kernel/workqueue.h>
+
+#define TASKLET_TEST_LOOPS                  (64)
+
+static struct pl_tasklet tasklet;
+static struct pl_work work;
+static struct pl_stimer *trigger_timer;
+static volatile bool trigger_work;
+static volatile int trigger_ret;
+static volatile u32_t trigger_cycles;
+static volatile u32_t latency_cycles;
+static volatile bool done;
+
+static void tasklet_fun(struct pl_tasklet *t)
+{
+	USED(t);
+	latency_cycles = pl_port_cpu_cycles() - trigger_cycles;
+	done = true;
+}
+
+static void work_fun(struct pl_work *w)
+{
+	USED(w);
+	latency_cycles = pl_port_cpu_cycles() - trigger_cycles;
+	done = true;
+}
+
+/* hard timer, both legs are triggered in the systick interrupt */
+static void trigger_fun(struct pl_stimer *t)
+{
+	USED(t);
+	trigger_cycles = pl_port_cpu_cycles();
+	if (trigger_work)
+		trigger_ret = pl_work_add(g_pl_sys_hiwq_handle, &work);
+	else
+		trigger_ret = pl_tasklet_schedule(&tasklet);
+
+	if (trigger_ret < 0)
+		done = true;
+}
+
+static int tasklet_test_run(const char *name, bool use_work)
+{
+	int i;
+	int ret;
+	u32_t sum = 0;
+	u32_t max_lat = 0;
+
+	trigger_work = use_work;
+	for (i = 0; i < TASKLET_TEST_LOOPS; i++) {
+		done = false;
+		pl_softtimer_timer_init(trigger_timer, trigger_fun, 1, NULL);
+		ret = pl_softtimer_start(trigger_timer);
+		if (ret < 0) {
+			pl_syslog_err("%s trigger timer start failed, ret:%d\r\n", name, ret);
+			return ret;
+		}
+
+		while (!done)
+			pl_task_delay_ticks(1);
+
+		if (trigger_ret < 0) {
+			pl_syslog_err("%s trigger failed, ret:%d\r\n", name, trigger_ret);
+			return trigger_ret;
+		}
+
+		sum += latency_cycles;
+		max_lat = max(max_lat, latency_cycles);
+		pl_task_delay_ticks(1);
+	}
+
+	pl_syslog_info("%s latency: avg:%u max:%u cycles\r\n", name,
+	               sum / TASKLET_TEST_LOOPS, max_lat);
+	return OK;
+}
+
+static int tasklet_test_task(int argc, char *argv[])
+{
+	int ret;
+
+	USED(argc);
+	USED(argv);
+	pl_tasklet_init(&tasklet, tasklet_fun, NULL);
+	pl_work_init(&work, work_fun, NULL);
+
+	trigger_timer = pl_softtimer_request("tasklet_trigger");
+	if (trigger_timer == NULL) {
+		pl_syslog_err("tasklet trigger timer request failed\r\n");
+		return -ENOMEM;
+	}
+
+	pl_softtimer_set_hard(trigger_timer, true);
+	ret = tasklet_test_run("tasklet", false);
+	if (ret < 0)
+		return ret;
+
+	ret = tasklet_test_run("workqueue", true);
+	if (ret < 0)
+		return ret;
+
+	pl_syslog_info("tasklet test done\r\n");
+	return 0;
+}
+
+static int tasklet_test(void)
+{
+	pl_tid_t tid;
+
+	pl_syslog_info("tasklet test\r\n");
+	tid = pl_task_create("tasklet_test", tasklet_test_task,
+	                     CONFIG_PL_TASK_PRIORITIES_MAX - 2, 512, 0, NULL);
+	if (tid == NULL) {
+		pl_syslog_err("tasklet test task create failed\r\n");
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+pl_late_initcall(tasklet_test);
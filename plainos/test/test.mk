@@ -50,4 +50,24 @@ ifeq ($(PL_OS_TEST_WORKQUEUE), y)
 C_SRCS += $(OSTEST_DIR)/workqueue_test.c
 endif
 
+# tasklet test
+ifeq ($(PL_OS_TEST_TASKLET), y)
+C_SRCS += $(OSTEST_DIR)/tasklet_test.c
+endif
+
+# bitops test
+ifeq ($(PL_OS_TEST_BITOPS), y)
+C_SRCS += $(OSTEST_DIR)/bitops_test.c
+endif
+
+# kmem cache test
+ifeq ($(PL_OS_TEST_KMEM_CACHE), y)
+C_SRCS += $(OSTEST_DIR)/kmem_cache_test.c
+endif
+
+# pipe test
+ifeq ($(PL_OS_TEST_PIPE), y)
+C_SRCS += $(OSTEST_DIR)/pipe_test.c
+endif
+
 endif
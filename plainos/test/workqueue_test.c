@@ -4,14 +4,342 @@
 #include <kernel/initcall.h>
 #include <port/port.h>
 #include <kernel/syslog.h>
+#include <kernel/task.h>
 #include <kernel/workqueue.h>
 
+#define WQ_BENCH_WORKS                  (40)
+#define WQ_BENCH_SLOW_EVERY             (10)
+
+struct bench_work {
+	struct pl_work work;
+	u64_t add_ticks;
+	u32_t cost_ticks;
+};
+
+static struct bench_work bench_works[WQ_BENCH_WORKS];
+static u32_t bench_latency[WQ_BENCH_WORKS];
+static volatile u32_t bench_done;
+
 static void work_fun(struct pl_work *work)
 {
 	USED(work);
 	pl_syslog_info("%s\r\n", (char *)pl_work_get_private_data(work));
 }
 
+static void bench_work_fun(struct pl_work *work)
+{
+	u64_t now;
+	struct bench_work *bw = container_of(work, struct bench_work, work);
+
+	pl_task_get_syscount(&now);
+	bench_latency[bw - bench_works] = (u32_t)(now - bw->add_ticks);
+	pl_task_delay_ticks(bw->cost_ticks);
+	++bench_done;
+}
+
+static void bench_sort(u32_t *a, int n)
+{
+	int i;
+	int j;
+	u32_t v;
+
+	for (i = 1; i < n; i++) {
+		v = a[i];
+		for (j = i - 1; j >= 0 && a[j] > v; j--)
+			a[j + 1] = a[j];
+		a[j + 1] = v;
+	}
+}
+
+static int workqueue_bench(u16_t nr_workers, u16_t max_workers)
+{
+	int i;
+	int ret;
+	struct pl_workqueue *wq;
+
+	wq = pl_workqueue_create_pool("bench_wq", CONFIG_PL_TASK_PRIORITIES_MAX - 3,
+	                              512, 64, nr_workers, max_workers);
+	if (wq == NULL) {
+		pl_syslog_err("bench workqueue create failed\r\n");
+		return -ENOMEM;
+	}
+
+	/* 1-tick works with a 100-tick work every WQ_BENCH_SLOW_EVERY works */
+	bench_done = 0;
+	for (i = 0; i < WQ_BENCH_WORKS; i++) {
+		bench_works[i].cost_ticks = (i % WQ_BENCH_SLOW_EVERY == 0) ? 100 : 1;
+		pl_work_init(&bench_works[i].work, bench_work_fun, NULL);
+		pl_task_get_syscount(&bench_works[i].add_ticks);
+		ret = pl_work_add(wq, &bench_works[i].work);
+		if (ret < 0) {
+			pl_syslog_err("bench work add failed, ret:%d\r\n", ret);
+			return ret;
+		}
+	}
+
+	while (bench_done < WQ_BENCH_WORKS)
+		pl_task_delay_ticks(10);
+
+	/* the last work may still be running, destroy refuses a busy workqueue */
+	pl_workqueue_flush(wq);
+
+	bench_sort(bench_latency, WQ_BENCH_WORKS);
+	pl_syslog_info("workers:%u-%u grown:%u latency ticks p50:%u p90:%u p99:%u\r\n",
+	               (uint_t)nr_workers, (uint_t)max_workers, (uint_t)wq->nr_workers,
+	               bench_latency[WQ_BENCH_WORKS / 2],
+	               bench_latency[WQ_BENCH_WORKS * 9 / 10],
+	               bench_latency[WQ_BENCH_WORKS * 99 / 100]);
+
+	return pl_workqueue_destroy(wq);
+}
+
+#define WQ_FLOOD_BYTES                  (1024)
+#define WQ_FLOOD_BURST                  (16)
+
+static struct pl_work flood_work;
+static volatile u32_t flood_runs;
+
+static void flood_work_fun(struct pl_work *work)
+{
+	USED(work);
+	++flood_runs;
+	/* the shell consumes the received characters here */
+	pl_task_delay_ticks(1);
+}
+
+/* a 115200-baud RX flood: every byte adds the same receiving work */
+static int workqueue_rx_flood(void)
+{
+	int i;
+	int ret;
+	u32_t depth;
+	u32_t max_depth = 0;
+	struct pl_workqueue *wq;
+
+	wq = pl_workqueue_create("flood_wq", CONFIG_PL_TASK_PRIORITIES_MAX - 3, 512, 128);
+	if (wq == NULL) {
+		pl_syslog_err("flood workqueue create failed\r\n");
+		return -ENOMEM;
+	}
+
+	flood_runs = 0;
+	pl_work_init(&flood_work, flood_work_fun, NULL);
+	for (i = 0; i < WQ_FLOOD_BYTES; i++) {
+		ret = pl_work_add(wq, &flood_work);
+		if (ret < 0) {
+			pl_syslog_err("flood work add failed, ret:%d\r\n", ret);
+			break;
+		}
+
+		depth = pl_work_ring_len(&wq->fifo);
+		max_depth = max(max_depth, depth);
+
+		/* the uart interrupts come back to back, then the line is idle a while */
+		if (i % WQ_FLOOD_BURST == WQ_FLOOD_BURST - 1)
+			pl_task_delay_ticks(1);
+	}
+
+	pl_workqueue_flush(wq);
+	pl_syslog_info("rx flood: bytes:%u max fifo depth:%u runs:%u wakeups:%u\r\n",
+	               (uint_t)WQ_FLOOD_BYTES, max_depth, flood_runs, wq->nr_wakeups);
+
+	return pl_workqueue_destroy(wq);
+}
+
+#define WQ_SWITCH_WORKS                 (1000)
+#define WQ_SWITCH_BURST                 (20)
+
+static struct pl_work switch_works[WQ_SWITCH_BURST];
+
+static void switch_work_fun(struct pl_work *work)
+{
+	USED(work);
+}
+
+/* context switches per 1000 works, per-item draining vs. batched draining */
+static int workqueue_switches(bool batch)
+{
+	int i;
+	u32_t start;
+	u32_t end;
+	u32_t cycles;
+	struct pl_workqueue *wq;
+
+	/* the producer has a higher priority, as an interrupt does */
+	if (batch)
+		wq = pl_workqueue_create_batch("switch_wq", CONFIG_PL_TASK_PRIORITIES_MAX - 1,
+		                               512, 32);
+	else
+		wq = pl_workqueue_create("switch_wq", CONFIG_PL_TASK_PRIORITIES_MAX - 1, 512, 32);
+
+	if (wq == NULL) {
+		pl_syslog_err("switch workqueue create failed\r\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < WQ_SWITCH_BURST; i++)
+		pl_work_init(&switch_works[i], switch_work_fun, NULL);
+
+	cycles = pl_port_cpu_cycles();
+	pl_task_get_switch_count(&start);
+	for (i = 0; i < WQ_SWITCH_WORKS; i++) {
+		pl_work_add(wq, &switch_works[i % WQ_SWITCH_BURST]);
+		if (i % WQ_SWITCH_BURST == WQ_SWITCH_BURST - 1)
+			pl_workqueue_flush(wq);
+	}
+
+	pl_task_get_switch_count(&end);
+	cycles = pl_port_cpu_cycles() - cycles;
+	pl_syslog_info("%s: per %u works, context switches:%u wakeups:%u cycles:%u\r\n",
+	               batch ? "batched" : "per-item", (uint_t)WQ_SWITCH_WORKS,
+	               end - start, wq->nr_wakeups, cycles);
+
+	return pl_workqueue_destroy(wq);
+}
+
+#define WQ_CHECK_WORKS                  (4)
+#define WQ_CHECK(cond)                                                              \
+	do {                                                                            \
+		if (!(cond)) {                                                              \
+			pl_syslog_err("workqueue check failed in %d\r\n", __LINE__);            \
+			return -EINVAL;                                                         \
+		}                                                                           \
+	} while (0)
+
+static struct pl_work check_works[WQ_CHECK_WORKS];
+static struct pl_work check_blocker;
+static struct pl_delayed_work check_dwk;
+static volatile u8_t check_runs[WQ_CHECK_WORKS + 1];
+static struct pl_workqueue *check_flush_wq;
+static volatile int check_flush_ret;
+static volatile bool check_flush_done;
+
+static void check_work_fun(struct pl_work *work)
+{
+	++check_runs[(uintptr_t)pl_work_get_private_data(work)];
+}
+
+/* keeps the only worker busy, the works added behind it stay in the fifo */
+static void check_blocker_fun(struct pl_work *work)
+{
+	USED(work);
+	pl_task_delay_ticks(20);
+}
+
+static int check_flusher_task(int argc, char *argv[])
+{
+	USED(argc);
+	USED(argv);
+	check_flush_ret = pl_workqueue_flush(check_flush_wq);
+	check_flush_done = true;
+	return 0;
+}
+
+/* the worker has a lower priority than this task, it only runs when this sleeps */
+static int workqueue_check(void)
+{
+	uintptr_t i;
+	struct pl_workqueue *wq;
+
+	wq = pl_workqueue_create("check_wq", CONFIG_PL_TASK_PRIORITIES_MAX - 1, 512, 8);
+	WQ_CHECK(wq != NULL);
+	for (i = 0; i < WQ_CHECK_WORKS; i++) {
+		pl_work_init(&check_works[i], check_work_fun, (void *)i);
+		check_runs[i] = 0;
+	}
+	pl_work_init(&check_blocker, check_blocker_fun, NULL);
+	pl_delayed_work_init(&check_dwk, check_work_fun, (void *)WQ_CHECK_WORKS);
+	check_runs[WQ_CHECK_WORKS] = 0;
+
+	/* a work added while pending runs once */
+	WQ_CHECK(pl_work_add(wq, &check_works[0]) == OK);
+	WQ_CHECK(pl_work_add(wq, &check_works[0]) == OK);
+	WQ_CHECK(pl_work_ring_len(&wq->fifo) == 1);
+	WQ_CHECK(pl_workqueue_flush(wq) == OK);
+	WQ_CHECK(check_runs[0] == 1);
+
+	/* a work cancelled has its slot cleared and never runs */
+	WQ_CHECK(pl_work_cancel(wq, &check_works[1]) == -EINVAL);
+	WQ_CHECK(pl_work_add(wq, &check_works[1]) == OK);
+	WQ_CHECK(*pl_work_ring_slot(&wq->fifo, check_works[1].seq) == &check_works[1]);
+	WQ_CHECK(pl_work_cancel(wq, &check_works[1]) == OK);
+	WQ_CHECK(*pl_work_ring_slot(&wq->fifo, check_works[1].seq) == NULL);
+	WQ_CHECK(pl_work_cancel(wq, &check_works[1]) == -EEMPTY);
+	WQ_CHECK(pl_workqueue_flush(wq) == OK);
+	WQ_CHECK(check_runs[1] == 0);
+
+	/* a running work can not be cancelled, nor its workqueue destroyed */
+	WQ_CHECK(pl_work_add(wq, &check_blocker) == OK);
+	pl_task_delay_ticks(5);
+	WQ_CHECK(pl_work_cancel(wq, &check_blocker) == -EBUSY);
+	WQ_CHECK(pl_workqueue_destroy(wq) == -EBUSY);
+	WQ_CHECK(pl_workqueue_flush(wq) == OK);
+	WQ_CHECK(pl_work_cancel(wq, &check_blocker) == -EEMPTY);
+
+	/* a delayed work cancelled on its timer never runs */
+	WQ_CHECK(pl_work_add_delayed(wq, &check_dwk, 10) == OK);
+	WQ_CHECK(pl_delayed_work_cancel(&check_dwk) == OK);
+	pl_task_delay_ticks(20);
+	WQ_CHECK(check_runs[WQ_CHECK_WORKS] == 0);
+
+	/* a delayed work cancelled in the fifo, its timer has fired behind the blocker */
+	WQ_CHECK(pl_work_add(wq, &check_blocker) == OK);
+	WQ_CHECK(pl_work_add_delayed(wq, &check_dwk, 5) == OK);
+	pl_task_delay_ticks(10);
+	WQ_CHECK(check_dwk.work.state & PL_WORK_STATE_QUEUED);
+	WQ_CHECK(pl_delayed_work_cancel(&check_dwk) == OK);
+	WQ_CHECK(pl_workqueue_flush(wq) == OK);
+	WQ_CHECK(check_runs[WQ_CHECK_WORKS] == 0);
+
+	/* a delayed work runs once after its timer, then it is not pending */
+	WQ_CHECK(pl_work_add_delayed(wq, &check_dwk, 5) == OK);
+	pl_task_delay_ticks(20);
+	WQ_CHECK(pl_workqueue_flush(wq) == OK);
+	WQ_CHECK(check_runs[WQ_CHECK_WORKS] == 1);
+	WQ_CHECK(pl_delayed_work_cancel(&check_dwk) == -EEMPTY);
+
+	/* destroy drops the works pending and wakes a flusher blocked on them, the
+	 * flusher has a higher priority and blocks as soon as it is created */
+	check_flush_wq = pl_workqueue_create("check_wq2", CONFIG_PL_TASK_PRIORITIES_MAX - 1,
+	                                     512, 8);
+	WQ_CHECK(check_flush_wq != NULL);
+	WQ_CHECK(pl_work_add(check_flush_wq, &check_works[2]) == OK);
+	WQ_CHECK(pl_work_add(check_flush_wq, &check_works[3]) == OK);
+	check_flush_done = false;
+	WQ_CHECK(pl_task_create("wq_flusher", check_flusher_task,
+	                        CONFIG_PL_TASK_PRIORITIES_MAX - 3, 512, 0, NULL) != NULL);
+	WQ_CHECK(!check_flush_done);
+	WQ_CHECK(pl_workqueue_destroy(check_flush_wq) == OK);
+	WQ_CHECK(check_flush_done && check_flush_ret == OK);
+	WQ_CHECK(check_runs[2] == 0 && check_runs[3] == 0);
+	WQ_CHECK(check_works[2].wq == NULL && !(check_works[2].state & PL_WORK_STATE_PENDING));
+
+	/* the works dropped can be added to another workqueue */
+	WQ_CHECK(pl_work_add(wq, &check_works[2]) == OK);
+	WQ_CHECK(pl_workqueue_flush(wq) == OK);
+	WQ_CHECK(check_runs[2] == 1);
+
+	WQ_CHECK(pl_workqueue_destroy(wq) == OK);
+	pl_syslog_info("workqueue check passed\r\n");
+	return 0;
+}
+
+static int workqueue_bench_task(int argc, char *argv[])
+{
+	USED(argc);
+	USED(argv);
+
+	workqueue_check();
+	workqueue_bench(1, 1);
+	workqueue_bench(4, 4);
+	workqueue_bench(1, 4);
+	workqueue_rx_flood();
+	workqueue_switches(false);
+	workqueue_switches(true);
+	pl_syslog_info("workqueue bench done\r\n");
+	return 0;
+}
+
 static struct pl_work hiwork;
 static struct pl_work lowork;
 
@@ -44,6 +372,12 @@ static int workqueue_test(void)
 		return ret;
 	}
 
+	if (pl_task_create("wq_bench", workqueue_bench_task,
+	                   CONFIG_PL_TASK_PRIORITIES_MAX - 2, 512, 0, NULL) == NULL) {
+		pl_syslog_err("workqueue bench task create failed\r\n");
+		return -ENOMEM;
+	}
+
 	pl_syslog_info("workqueue test done\r\n");
 	return 0;
 }
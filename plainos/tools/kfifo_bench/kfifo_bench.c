@@ -0,0 +1,308 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host benchmark of the serial RX path. The DMA of serial is a memcpy from the
+ * line into its target, it is the same in both paths and not counted as a copy
+ * of the CPU:
+ *   copy: DMA into a block buffer, pl_kfifo_put(), pl_kfifo_get() into the
+ *         buffer of reader, then the reader parses it.
+ *   span: DMA into pl_kfifo_reserve(), pl_kfifo_commit(), then the reader parses
+ *         pl_kfifo_peek() in place and calls pl_kfifo_consume().
+ *
+ * The rec mode pushes records of random sizes from 1 to 256 bytes:
+ *   framed: the length is put by hand before the data, the reader gets the
+ *           length and then the data, two calls each side.
+ *   rec: pl_kfifo_rec_put() and pl_kfifo_rec_get().
+ *
+ * usage: kfifo_bench [bytes]
+ *        kfifo_bench rec [records]
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <types.h>
+#include <lib/string.h>
+#include <kernel/kernel.h>
+#include <kernel/mempool.h>
+#include <kernel/kfifo.h>
+
+#define BENCH_DEFAULT_BYTES     (256ull << 20)
+#define BENCH_FIFO_SIZE         (1024)
+#define BENCH_LINE_SIZE         (4096)
+#define BENCH_REC_RECORDS       (4000000)
+#define BENCH_REC_MAX           (256)
+
+pl_mempool_handle_t g_pl_default_mempool;
+
+/*************************************************************************************
+ * Description: stubs of kernel.
+ ************************************************************************************/
+/* a single core MCU only needs the compiler to keep the order */
+void pl_port_cpu_dmb(void)
+{
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+void *pl_mempool_alloc_sized(pl_mempool_handle_t mempool, size_t size)
+{
+	(void)mempool;
+	return malloc(size);
+}
+
+void pl_mempool_free_sized(pl_mempool_handle_t mempool, void *p, size_t size)
+{
+	(void)mempool;
+	(void)size;
+	free(p);
+}
+
+/*************************************************************************************
+ * Description: benchmark.
+ ************************************************************************************/
+struct bench_stat {
+	uint64_t bytes;
+	uint64_t copied;
+	uint32_t sum;
+};
+
+static char fifo_buff[BENCH_FIFO_SIZE];
+static char dma_buff[BENCH_FIFO_SIZE];
+static char read_buff[BENCH_FIFO_SIZE];
+static char line[BENCH_LINE_SIZE * 2];
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* the parser of reader, as the shell looks for the end of line */
+static uint32_t bench_parse(const char *chars, uint_t len, uint32_t sum)
+{
+	uint_t i;
+
+	for (i = 0; i < len; i++)
+		sum += (chars[i] == '\n') ? 0x10000 : (uint8_t)chars[i];
+
+	return sum;
+}
+
+static void bench_copy(struct pl_kfifo *fifo, uint_t block, uint64_t total,
+                       struct bench_stat *stat)
+{
+	uint_t len;
+	uint_t pos = 0;
+
+	while (stat->bytes < total) {
+		memcpy(dma_buff, line + pos, block);
+		pos = (pos + block) & (BENCH_LINE_SIZE - 1);
+		stat->copied += pl_kfifo_put(fifo, dma_buff, block);
+
+		len = pl_kfifo_get(fifo, read_buff, sizeof(read_buff));
+		stat->copied += len;
+		stat->sum = bench_parse(read_buff, len, stat->sum);
+		stat->bytes += len;
+	}
+}
+
+static void bench_span(struct pl_kfifo *fifo, uint_t block, uint64_t total,
+                       struct bench_stat *stat)
+{
+	uint_t len;
+	uint_t span;
+	uint_t pos = 0;
+	char *buff;
+
+	while (stat->bytes < total) {
+		/* the DMA block is split if the free span wraps */
+		for (len = 0; len < block; len += span) {
+			span = min(pl_kfifo_reserve(fifo, &buff), block - len);
+			memcpy(buff, line + pos, span);
+			pos = (pos + span) & (BENCH_LINE_SIZE - 1);
+			pl_kfifo_commit(fifo, span);
+		}
+
+		while ((len = pl_kfifo_peek(fifo, &buff)) != 0) {
+			stat->sum = bench_parse(buff, len, stat->sum);
+			pl_kfifo_consume(fifo, len);
+			stat->bytes += len;
+		}
+	}
+}
+
+static uint64_t rand_state = 0x2545f4914f6cdd1dull;
+
+static uint64_t bench_rand(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return rand_state;
+}
+
+/* the producer fills the fifo, then the reader drains it */
+static void bench_framed(struct pl_kfifo *fifo, uint64_t records,
+                         struct bench_stat *stat)
+{
+	uint16_t len;
+	uint64_t n = 0;
+
+	while (n < records) {
+		for (; n < records; n++) {
+			len = (uint16_t)(1 + bench_rand() % BENCH_REC_MAX);
+			if (BENCH_FIFO_SIZE - pl_kfifo_len(fifo) < len + sizeof(len))
+				break;
+
+			pl_kfifo_put(fifo, (char *)&len, sizeof(len));
+			pl_kfifo_put(fifo, line + n % BENCH_LINE_SIZE, len);
+		}
+
+		while (pl_kfifo_get(fifo, (char *)&len, sizeof(len)) == sizeof(len)) {
+			stat->bytes += pl_kfifo_get(fifo, read_buff, len);
+			stat->sum = bench_parse(read_buff, len, stat->sum);
+			stat->copied++;
+		}
+	}
+}
+
+static void bench_rec(struct pl_kfifo *fifo, uint64_t records,
+                      struct bench_stat *stat)
+{
+	uint_t len;
+	uint64_t n = 0;
+
+	while (n < records) {
+		for (; n < records; n++) {
+			len = (uint_t)(1 + bench_rand() % BENCH_REC_MAX);
+			if (pl_kfifo_rec_put(fifo, line + n % BENCH_LINE_SIZE, len) == 0)
+				break;
+		}
+
+		while ((len = pl_kfifo_rec_get(fifo, read_buff, sizeof(read_buff))) != 0) {
+			stat->bytes += len;
+			stat->sum = bench_parse(read_buff, len, stat->sum);
+			stat->copied++;
+		}
+	}
+}
+
+/* the same random sizes in both cases, the record count is kept in copied */
+static int bench_records(uint64_t records)
+{
+	size_t k;
+	uint64_t t;
+	uint64_t ns[2];
+	struct pl_kfifo fifo;
+	struct bench_stat stat[2];
+
+	printf("kfifo rec: %llu records of 1-%u bytes, fifo:%u\n",
+	       (unsigned long long)records, BENCH_REC_MAX, BENCH_FIFO_SIZE);
+	printf("%-8s %10s %12s\n", "", "MB/s", "records/s");
+
+	for (k = 0; k < 2; k++) {
+		rand_state = 0x2545f4914f6cdd1dull;
+		pl_kfifo_init(&fifo, fifo_buff, BENCH_FIFO_SIZE);
+		memset(&stat[k], 0, sizeof(stat[k]));
+		t = bench_now_ns();
+		if (k == 0)
+			bench_framed(&fifo, records, &stat[k]);
+		else
+			bench_rec(&fifo, records, &stat[k]);
+		ns[k] = bench_now_ns() - t;
+
+		printf("%-8s %10.1f %12.0f\n", k == 0 ? "framed" : "rec",
+		       (double)stat[k].bytes * 1000.0 / 1.048576 / (double)ns[k],
+		       (double)stat[k].copied * 1e9 / (double)ns[k]);
+	}
+
+	if (stat[0].sum != stat[1].sum || stat[0].copied != records ||
+	    stat[1].copied != records) {
+		printf("the records of both cases differ\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static const uint_t bench_blocks[] = {1, 16, 64, 256, 1000};
+
+int main(int argc, char *argv[])
+{
+	size_t i;
+	size_t k;
+	uint64_t t;
+	uint64_t ns[2];
+	uint64_t total = BENCH_DEFAULT_BYTES;
+	struct pl_kfifo fifo;
+	struct bench_stat stat[2];
+
+	if (argc > 1 && strcmp(argv[1], "rec") == 0) {
+		total = argc > 2 ? strtoull(argv[2], NULL, 0) : BENCH_REC_RECORDS;
+		return bench_records(total) < 0 ? 1 : 0;
+	}
+
+	if (argc > 1)
+		total = strtoull(argv[1], NULL, 0);
+
+	/* the second half repeats the first, a block at any position is contiguous */
+	for (i = 0; i < sizeof(line); i++) {
+		k = i % BENCH_LINE_SIZE;
+		line[i] = (k % 80 == 79) ? '\n' : (char)(' ' + k % 95);
+	}
+
+	printf("kfifo bench: %llu bytes, fifo:%u (MB/s, CPU copies per byte)\n",
+	       (unsigned long long)total, BENCH_FIFO_SIZE);
+	printf("%6s %10s %8s %10s %8s\n", "block", "copy", "copies", "span", "copies");
+
+	for (i = 0; i < sizeof(bench_blocks) / sizeof(bench_blocks[0]); i++) {
+		for (k = 0; k < 2; k++) {
+			pl_kfifo_init(&fifo, fifo_buff, BENCH_FIFO_SIZE);
+			memset(&stat[k], 0, sizeof(stat[k]));
+			t = bench_now_ns();
+			if (k == 0)
+				bench_copy(&fifo, bench_blocks[i], total / 4, &stat[k]);
+			else
+				bench_span(&fifo, bench_blocks[i], total / 4, &stat[k]);
+			ns[k] = bench_now_ns() - t;
+		}
+
+		if (stat[0].sum != stat[1].sum || stat[0].bytes != stat[1].bytes) {
+			printf("block %u: the data of both paths differ\n", bench_blocks[i]);
+			return 1;
+		}
+
+		printf("%6u %10.1f %8.2f %10.1f %8.2f\n", bench_blocks[i],
+		       (double)stat[0].bytes * 1000.0 / 1.048576 / (double)ns[0],
+		       (double)stat[0].copied / (double)stat[0].bytes,
+		       (double)stat[1].bytes * 1000.0 / 1.048576 / (double)ns[1],
+		       (double)stat[1].copied / (double)stat[1].bytes);
+	}
+
+	return 0;
+}
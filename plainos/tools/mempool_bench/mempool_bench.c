@@ -0,0 +1,876 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host benchmark of the memory pool, the allocator is built with the config.h of
+ * the tree (mempool_bench_tlsf is built with CONFIG_PL_MEMPOOL_TLSF), the kernel
+ * services it needs are stubbed below.
+ *
+ * usage: mempool_bench [ops] [grain_order]
+ *        mempool_bench stress [ops] [grain_order]
+ *        mempool_bench grow [ops] [grain_order]
+ *        mempool_bench boot [ops] [grain_order]
+ *        mempool_bench region [rounds]
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <types.h>
+#include <kernel/task.h>
+#include <kernel/mempool.h>
+#include <kernel/semaphore.h>
+#include <kernel/arena.h>
+#include "../../kernel/arena.h"
+
+#define BENCH_DEFAULT_OPS       (200000)
+#define BENCH_GRAIN_ORDER       (5)
+#define BENCH_MAX_LIVE          (65536)
+#define BENCH_MIN_POOL          (4 * 1024)
+#define BENCH_MAX_POOL          (16 * 1024 * 1024)
+#define BENCH_STRESS_OPS        (1000000)
+#define BENCH_STRESS_POOL       (1024 * 1024)
+#define BENCH_STRESS_LIVE       (2048)
+#define BENCH_GROW_OPS          (2000)
+#define BENCH_GROW_POOL         (14 * 1024)
+#define BENCH_GROW_BUFS         (4)
+#define BENCH_GROW_STEP         (16)
+#define BENCH_GROW_MAX          (1024)
+#define BENCH_BOOT_OPS          (20000)
+#define BENCH_BOOT_POOL         (14 * 1024)
+#define BENCH_BOOT_ARENA        (3 * 1024)
+#define BENCH_BOOT_TCB          (128)
+#define BENCH_BOOT_TEMPS        (8)
+#define BENCH_BOOT_LIVE         (8)
+#define BENCH_REGION_ROUNDS     (24)
+#define BENCH_REGION_KINDS      (3)
+#define BENCH_REGION_NUM        (3)
+
+struct bench_obj {
+	uint8_t *p;
+	size_t size;
+	uint8_t tag;
+};
+
+struct bench_result {
+	double mean;
+	uint64_t p99;
+	size_t cnt;
+};
+
+static uint64_t rand_state = 0x2545f4914f6cdd1dull;
+
+/*************************************************************************************
+ * Description: kernel stubs.
+ ************************************************************************************/
+int pl_semaphore_init(struct pl_sem *sem, int val)
+{
+	(void)sem;
+	(void)val;
+	return 0;
+}
+
+int pl_semaphore_wait(struct pl_sem *sem)
+{
+	(void)sem;
+	return 0;
+}
+
+int pl_semaphore_post(struct pl_sem *sem)
+{
+	(void)sem;
+	return 0;
+}
+
+void pl_put_format_log_locked(int (*putc)(const char c), const char *fmt, ...)
+{
+	(void)putc;
+	(void)fmt;
+}
+
+void pl_put_format_log(const char *fmt, ...)
+{
+	(void)fmt;
+}
+
+int pl_port_putc(const char c)
+{
+	return putchar(c);
+}
+
+u8_t pl_port_rodata_read8(void *addr)
+{
+	return *(u8_t *)addr;
+}
+
+void pl_port_enter_critical(void)
+{
+}
+
+void pl_port_exit_critical(void)
+{
+}
+
+void pl_task_pend(pl_tid_t tid)
+{
+	(void)tid;
+	abort();
+}
+
+struct tcb *pl_task_get_curr_tcb(void)
+{
+	return NULL;
+}
+
+/*************************************************************************************
+ * Description: benchmark.
+ ************************************************************************************/
+static uint64_t bench_rand(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return rand_state;
+}
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* cycle counter if the host has one, otherwise ns */
+static uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	return bench_now_ns();
+#endif
+}
+
+/* mostly small objects, some of them cross several blocks */
+static size_t bench_rand_size(size_t pool_size)
+{
+	uint64_t r = bench_rand();
+	size_t size;
+
+	if ((r & 0xf) != 0)
+		size = 8 + (size_t)((r >> 8) % 248);
+	else
+		size = 256 + (size_t)((r >> 8) % 3840);
+
+	return size < pool_size / 16 ? size : pool_size / 16;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void bench_result(uint64_t *lat, size_t cnt, struct bench_result *res)
+{
+	size_t i;
+	uint64_t sum = 0;
+
+	res->cnt = cnt;
+	res->mean = 0;
+	res->p99 = 0;
+	if (cnt == 0)
+		return;
+
+	for (i = 0; i < cnt; i++)
+		sum += lat[i];
+
+	qsort(lat, cnt, sizeof(uint64_t), bench_cmp);
+	res->mean = (double)sum / cnt;
+	res->p99 = lat[(cnt * 99) / 100];
+}
+
+static int bench_check(struct bench_obj *obj)
+{
+	size_t i;
+
+	for (i = 0; i < obj->size; i++) {
+		if (obj->p[i] != obj->tag)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int bench_pool(size_t pool_size, size_t ops, uint8_t grain_order)
+{
+	size_t i;
+	size_t live = 0;
+	size_t n_malloc = 0;
+	size_t n_free = 0;
+	size_t n_fail = 0;
+	size_t max_live;
+	size_t free_bytes;
+	uint64_t t;
+	uint8_t *pool;
+	struct bench_obj *objs;
+	uint64_t *lat_malloc;
+	uint64_t *lat_free;
+	struct bench_result res_malloc;
+	struct bench_result res_free;
+	pl_mempool_handle_t mp;
+
+	pool = malloc(pool_size);
+	objs = calloc(BENCH_MAX_LIVE, sizeof(struct bench_obj));
+	lat_malloc = malloc(ops * sizeof(uint64_t));
+	lat_free = malloc(ops * sizeof(uint64_t));
+	if (pool == NULL || objs == NULL || lat_malloc == NULL || lat_free == NULL)
+		return -1;
+
+	mp = pl_mempool_init(pool, 0, pool_size, grain_order);
+	if (mp == NULL) {
+		printf("pool %zu init failed\n", pool_size);
+		return -1;
+	}
+	free_bytes = pl_mempool_get_free_bytes(mp);
+
+	/* keep about a half of pool in use, with an average object of 400 bytes */
+	max_live = pool_size / 2 / 400;
+	max_live = max_live < 4 ? 4 : max_live;
+	max_live = max_live > BENCH_MAX_LIVE ? BENCH_MAX_LIVE : max_live;
+
+	for (i = 0; i < ops; i++) {
+		struct bench_obj *obj;
+		size_t k;
+
+		if (live < max_live && (live == 0 || (bench_rand() & 1) ||
+		    live < max_live / 2)) {
+			obj = &objs[live];
+			obj->size = bench_rand_size(pool_size);
+			t = bench_now_ns();
+			obj->p = pl_mempool_malloc(mp, obj->size);
+			lat_malloc[n_malloc++] = bench_now_ns() - t;
+			if (obj->p == NULL) {
+				n_fail++;
+				continue;
+			}
+
+			obj->tag = (uint8_t)bench_rand();
+			memset(obj->p, obj->tag, obj->size);
+			live++;
+			continue;
+		}
+
+		k = (size_t)(bench_rand() % live);
+		obj = &objs[k];
+		if (bench_check(obj) < 0) {
+			printf("pool %zu: object %p corrupted\n", pool_size, obj->p);
+			return -1;
+		}
+
+		t = bench_now_ns();
+		pl_mempool_free(mp, obj->p);
+		lat_free[n_free++] = bench_now_ns() - t;
+		objs[k] = objs[--live];
+	}
+
+	for (i = 0; i < live; i++) {
+		if (bench_check(&objs[i]) < 0) {
+			printf("pool %zu: object %p corrupted\n", pool_size, objs[i].p);
+			return -1;
+		}
+		pl_mempool_free(mp, objs[i].p);
+	}
+
+	if (pl_mempool_get_free_bytes(mp) != free_bytes) {
+		printf("pool %zu: leaked %zu bytes\n", pool_size,
+		       free_bytes - pl_mempool_get_free_bytes(mp));
+		return -1;
+	}
+
+	bench_result(lat_malloc, n_malloc, &res_malloc);
+	bench_result(lat_free, n_free, &res_free);
+	printf("%10zu %8zu %10.1f %8llu %10.1f %8llu %8zu %10zu\n", pool_size, max_live,
+	       res_malloc.mean, (unsigned long long)res_malloc.p99,
+	       res_free.mean, (unsigned long long)res_free.p99, n_fail, free_bytes);
+
+	free(lat_free);
+	free(lat_malloc);
+	free(objs);
+	free(pool);
+	return 0;
+}
+
+/* the largest block which can be allocated now, found by bisection */
+static size_t bench_largest_block(pl_mempool_handle_t mp, size_t hi)
+{
+	void *p;
+	size_t lo = 0;
+	size_t mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo + 1) / 2;
+		p = pl_mempool_malloc(mp, mid);
+		if (p != NULL) {
+			pl_mempool_free(mp, p);
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return lo;
+}
+
+/*
+ * Random malloc and free with sizes from 8 bytes to 16KB on a fixed pool, the
+ * pool is mostly full, so the worst case of both paths shows up. The largest
+ * block and the fragmentation are measured with a half of the last objects alive.
+ */
+static int bench_stress(size_t ops, uint8_t grain_order)
+{
+	size_t i;
+	size_t k;
+	size_t live = 0;
+	size_t n_fail = 0;
+	size_t free_bytes;
+	size_t largest;
+	uint64_t t;
+	size_t n_malloc = 0;
+	size_t n_free = 0;
+	uint8_t *pool;
+	struct bench_obj *objs;
+	uint64_t *lat_malloc;
+	uint64_t *lat_free;
+	struct bench_result res_malloc;
+	struct bench_result res_free;
+	pl_mempool_handle_t mp;
+
+	pool = malloc(BENCH_STRESS_POOL);
+	objs = calloc(BENCH_STRESS_LIVE, sizeof(struct bench_obj));
+	lat_malloc = malloc(ops * sizeof(uint64_t));
+	lat_free = malloc(ops * sizeof(uint64_t));
+	if (pool == NULL || objs == NULL || lat_malloc == NULL || lat_free == NULL)
+		return -1;
+
+	mp = pl_mempool_init(pool, 0, BENCH_STRESS_POOL, grain_order);
+	if (mp == NULL) {
+		printf("stress pool init failed\n");
+		return -1;
+	}
+	free_bytes = pl_mempool_get_free_bytes(mp);
+
+	for (i = 0; i < ops; i++) {
+		struct bench_obj *obj;
+		uint64_t r = bench_rand();
+
+		/* slightly more malloc than free, so the pool stays nearly full */
+		if (live < BENCH_STRESS_LIVE && (live == 0 || (r & 15) < 9)) {
+			obj = &objs[live];
+			obj->size = (size_t)8 << ((r >> 8) % 12);
+			obj->size += (size_t)((r >> 16) % obj->size);
+			t = bench_cycles();
+			obj->p = pl_mempool_malloc(mp, obj->size);
+			lat_malloc[n_malloc++] = bench_cycles() - t;
+			if (obj->p == NULL) {
+				n_fail++;
+				continue;
+			}
+
+			obj->tag = (uint8_t)r;
+			memset(obj->p, obj->tag, obj->size);
+			live++;
+			continue;
+		}
+
+		k = (size_t)((r >> 8) % live);
+		obj = &objs[k];
+		if (bench_check(obj) < 0) {
+			printf("stress: object %p corrupted\n", obj->p);
+			return -1;
+		}
+
+		t = bench_cycles();
+		pl_mempool_free(mp, obj->p);
+		lat_free[n_free++] = bench_cycles() - t;
+		objs[k] = objs[--live];
+	}
+
+	/* the max is disturbed by host interrupts, p99.9 is shown as well */
+	bench_result(lat_malloc, n_malloc, &res_malloc);
+	bench_result(lat_free, n_free, &res_free);
+	printf("malloc: mean %.1f p99.9 %llu max %llu (cycles)\n", res_malloc.mean,
+	       (unsigned long long)lat_malloc[n_malloc * 999 / 1000],
+	       (unsigned long long)lat_malloc[n_malloc - 1]);
+	printf("free:   mean %.1f p99.9 %llu max %llu (cycles)\n", res_free.mean,
+	       (unsigned long long)lat_free[n_free * 999 / 1000],
+	       (unsigned long long)lat_free[n_free - 1]);
+
+	/* free a half of the objects left, the holes between them are measured */
+	for (i = live; i > 0; i--) {
+		if ((i & 1) == 0) {
+			pl_mempool_free(mp, objs[i - 1].p);
+			objs[i - 1] = objs[--live];
+		}
+	}
+
+	largest = bench_largest_block(mp, BENCH_STRESS_POOL);
+	printf("live %zu, failed %zu of %zu malloc\n", live, n_fail, n_malloc);
+	printf("free %zu bytes, largest block %zu bytes, fragmentation %.1f%%\n",
+	       pl_mempool_get_free_bytes(mp), largest,
+	       100.0 * (1.0 - (double)largest / pl_mempool_get_free_bytes(mp)));
+
+	for (i = 0; i < live; i++)
+		pl_mempool_free(mp, objs[i].p);
+
+	if (pl_mempool_get_free_bytes(mp) != free_bytes) {
+		printf("stress: leaked %zu bytes\n",
+		       free_bytes - pl_mempool_get_free_bytes(mp));
+		return -1;
+	}
+
+	free(lat_free);
+	free(lat_malloc);
+	free(objs);
+	free(pool);
+	return 0;
+}
+
+/* grow a buffer by malloc, copy and free, as the callers without realloc do */
+static void *bench_grow_copy(pl_mempool_handle_t mp, void *p, size_t old_size,
+                             size_t size, size_t *min_free)
+{
+	size_t free_bytes;
+	void *new_p;
+
+	new_p = pl_mempool_malloc(mp, size);
+	if (new_p == NULL)
+		return NULL;
+
+	/* both buffers are alive here */
+	if (min_free != NULL) {
+		free_bytes = pl_mempool_get_free_bytes(mp);
+		*min_free = free_bytes < *min_free ? free_bytes : *min_free;
+	}
+
+	memcpy(new_p, p, old_size);
+	pl_mempool_free(mp, p);
+	return new_p;
+}
+
+/*
+ * Some line buffers grow by BENCH_GROW_STEP bytes up to BENCH_GROW_MAX, a small
+ * object is allocated between the steps as the other users of the pool do. The
+ * lowest free bytes are recorded if min_free is not NULL.
+ */
+static size_t bench_grow_rounds(pl_mempool_handle_t mp, size_t rounds,
+                                bool use_realloc, size_t *min_free)
+{
+	size_t i;
+	size_t r;
+	size_t len;
+	size_t n_fail = 0;
+	size_t free_bytes;
+	uint8_t *q;
+	uint8_t *bufs[BENCH_GROW_BUFS];
+	void *small[BENCH_GROW_BUFS];
+
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < BENCH_GROW_BUFS; i++) {
+			bufs[i] = pl_mempool_malloc(mp, BENCH_GROW_STEP);
+			small[i] = NULL;
+		}
+
+		for (len = BENCH_GROW_STEP; len < BENCH_GROW_MAX; len += BENCH_GROW_STEP) {
+			for (i = 0; i < BENCH_GROW_BUFS; i++) {
+				if (bufs[i] == NULL)
+					continue;
+
+				if (use_realloc)
+					q = pl_mempool_realloc(mp, bufs[i], len + BENCH_GROW_STEP);
+				else
+					q = bench_grow_copy(mp, bufs[i], len, len + BENCH_GROW_STEP,
+					                    min_free);
+
+				if (q == NULL) {
+					n_fail++;
+					continue;
+				}
+
+				bufs[i] = q;
+				pl_mempool_free(mp, small[i]);
+				small[i] = pl_mempool_malloc(mp, 24);
+			}
+
+			if (min_free != NULL) {
+				free_bytes = pl_mempool_get_free_bytes(mp);
+				*min_free = free_bytes < *min_free ? free_bytes : *min_free;
+			}
+		}
+
+		for (i = 0; i < BENCH_GROW_BUFS; i++) {
+			pl_mempool_free(mp, bufs[i]);
+			pl_mempool_free(mp, small[i]);
+		}
+	}
+
+	return n_fail;
+}
+
+/* the time is taken without the peak tracking, the peak is taken by one round */
+static int bench_grow_case(size_t rounds, uint8_t grain_order, bool use_realloc)
+{
+	size_t n_fail;
+	size_t free_bytes;
+	size_t min_free;
+	uint64_t t;
+	uint8_t *pool;
+	pl_mempool_handle_t mp;
+
+	pool = malloc(BENCH_GROW_POOL);
+	if (pool == NULL)
+		return -1;
+
+	mp = pl_mempool_init(pool, 0, BENCH_GROW_POOL, grain_order);
+	if (mp == NULL) {
+		printf("grow pool init failed\n");
+		return -1;
+	}
+
+	t = bench_cycles();
+	n_fail = bench_grow_rounds(mp, rounds, use_realloc, NULL);
+	t = bench_cycles() - t;
+
+	free_bytes = pl_mempool_get_free_bytes(mp);
+	min_free = free_bytes;
+	n_fail += bench_grow_rounds(mp, 1, use_realloc, &min_free);
+
+	printf("%-14s %12llu %10zu %8zu\n", use_realloc ? "realloc" : "malloc+copy",
+	       (unsigned long long)(t / rounds), free_bytes - min_free, n_fail);
+	free(pool);
+	return 0;
+}
+
+static int bench_grow(size_t rounds, uint8_t grain_order)
+{
+	printf("%-14s %12s %10s %8s\n", "", "cycles/round", "peak", "fail");
+	if (bench_grow_case(rounds, grain_order, false) < 0)
+		return -1;
+
+	return bench_grow_case(rounds, grain_order, true);
+}
+
+/* stacks of the system tasks created by initcalls, as stm32f103c8t6 */
+static const size_t bench_boot_stacks[] = {512, 512, 1024, 512};
+#define BENCH_BOOT_TASKS        (sizeof(bench_boot_stacks) / sizeof(bench_boot_stacks[0]))
+
+/*
+ * Boot the pool as the initcalls do: the system tasks are created between
+ * temporary buffers which are freed when the boot is done. The tasks come from
+ * the arena with use_arena. Then random malloc and free of up to 4KB run on the
+ * pool, the holes left by the boot make them fail more.
+ */
+static int bench_boot_case(size_t ops, uint8_t grain_order, bool use_arena)
+{
+	size_t i;
+	size_t k;
+	size_t size;
+	size_t n_temp = 0;
+	size_t live = 0;
+	size_t n_fail = 0;
+	uint64_t r;
+	uint64_t t;
+	uint64_t t_boot = 0;
+	uint8_t *pool;
+	void *task;
+	void *temps[BENCH_BOOT_TEMPS * BENCH_BOOT_TASKS];
+	void *objs[BENCH_BOOT_LIVE];
+	struct pl_mempool_stats stats;
+	pl_mempool_handle_t mp;
+
+	pool = malloc(BENCH_BOOT_POOL);
+	if (pool == NULL)
+		return -1;
+
+	rand_state = 0x2545f4914f6cdd1dull;
+	if (use_arena) {
+		pl_arena_init(pool, BENCH_BOOT_ARENA);
+		pl_arena_boot_begin();
+		mp = pl_mempool_init(pool + BENCH_BOOT_ARENA, 0,
+		                     BENCH_BOOT_POOL - BENCH_BOOT_ARENA, grain_order);
+	} else {
+		mp = pl_mempool_init(pool, 0, BENCH_BOOT_POOL, grain_order);
+	}
+
+	if (mp == NULL) {
+		printf("boot pool init failed\n");
+		return -1;
+	}
+
+	for (i = 0; i < BENCH_BOOT_TASKS; i++) {
+		for (k = 0; k < BENCH_BOOT_TEMPS; k++) {
+			r = bench_rand();
+			temps[n_temp] = pl_mempool_malloc(mp, 16 + (size_t)(r % 240));
+			if (temps[n_temp] != NULL)
+				n_temp++;
+		}
+
+		size = BENCH_BOOT_TCB + bench_boot_stacks[i];
+		t = bench_cycles();
+		task = use_arena ? pl_arena_alloc(size) : pl_mempool_malloc(mp, size);
+		t_boot += bench_cycles() - t;
+		if (task == NULL) {
+			printf("boot task %zu failed\n", i);
+			return -1;
+		}
+	}
+
+	for (i = 0; i < n_temp; i++)
+		pl_mempool_free(mp, temps[i]);
+
+	if (use_arena) {
+		pl_arena_boot_end();
+		pl_arena_seal();
+	}
+
+	pl_mempool_get_stats(mp, &stats);
+	printf("%-8s %10llu %8zu %8zu %8zu", use_arena ? "arena" : "mempool",
+	       (unsigned long long)t_boot, stats.free_bytes, stats.largest_free,
+	       stats.free_frags);
+
+	/* the runtime users of pool */
+	for (i = 0; i < ops; i++) {
+		r = bench_rand();
+		if (live < BENCH_BOOT_LIVE && (live == 0 || (r & 1) != 0)) {
+			objs[live] = pl_mempool_malloc(mp, 16 + (size_t)((r >> 8) % 4096));
+			if (objs[live] == NULL)
+				n_fail++;
+			else
+				live++;
+			continue;
+		}
+
+		k = (size_t)((r >> 8) % live);
+		pl_mempool_free(mp, objs[k]);
+		objs[k] = objs[--live];
+	}
+
+	printf(" %8zu\n", n_fail);
+	free(pool);
+	return 0;
+}
+
+static int bench_boot(size_t ops, uint8_t grain_order)
+{
+	printf("%-8s %10s %8s %8s %8s %8s\n", "", "boot_cyc", "free", "largest",
+	       "frags", "fail");
+	if (bench_boot_case(ops, grain_order, false) < 0)
+		return -1;
+
+	return bench_boot_case(ops, grain_order, true);
+}
+
+/* the RAM of stm32f407vet6: CCM, main SRAM and an external SRAM */
+static const char *const bench_region_names[] = {"ccm", "sram", "ext"};
+static const size_t bench_region_sizes[] = {8 * 1024, 14 * 1024, 32 * 1024};
+static const uint8_t bench_region_flags[] = {
+	PL_MEMPOOL_FAST,
+	PL_MEMPOOL_FAST | PL_MEMPOOL_DMA | PL_MEMPOOL_LARGE,
+	PL_MEMPOOL_LARGE,
+};
+
+/* task stacks, DMA buffers and large buffers, as the users of the regions */
+static const char *const bench_region_kinds[] = {"stack", "dma", "large"};
+static const size_t bench_region_kind_sizes[] = {1024 + 128, 512, 4096};
+static const uint8_t bench_region_kind_flags[] = {
+	PL_MEMPOOL_FAST, PL_MEMPOOL_DMA, PL_MEMPOOL_LARGE,
+};
+
+/*
+ * Allocate a stack, a DMA buffer and a large buffer each round until all the
+ * regions are exhausted, then show where each kind was placed, the statistics
+ * of each region, and that all memory comes back by pl_mempool_free_flags().
+ */
+static int bench_region(size_t rounds)
+{
+	size_t i;
+	size_t k;
+	size_t r;
+	size_t n_objs = 0;
+	size_t placed[BENCH_REGION_KINDS][BENCH_REGION_NUM + 1];
+	void *objs[BENCH_REGION_ROUNDS * BENCH_REGION_KINDS];
+	uint8_t *pools[BENCH_REGION_NUM];
+	pl_mempool_handle_t mps[BENCH_REGION_NUM];
+	pl_mempool_handle_t mp;
+	struct pl_mempool_stats stats;
+
+	if (rounds > BENCH_REGION_ROUNDS)
+		rounds = BENCH_REGION_ROUNDS;
+
+	for (r = 0; r < BENCH_REGION_NUM; r++) {
+		pools[r] = malloc(bench_region_sizes[r]);
+		if (pools[r] == NULL)
+			return -1;
+
+		mps[r] = pl_mempool_add_region(pools[r], bench_region_sizes[r],
+		                               bench_region_flags[r]);
+		if (mps[r] == NULL) {
+			printf("region %s init failed\n", bench_region_names[r]);
+			return -1;
+		}
+	}
+
+	memset(placed, 0, sizeof(placed));
+	for (i = 0; i < rounds; i++) {
+		for (k = 0; k < BENCH_REGION_KINDS; k++) {
+			objs[n_objs] = pl_mempool_malloc_flags(bench_region_kind_sizes[k],
+			                                       bench_region_kind_flags[k]);
+			if (objs[n_objs] == NULL) {
+				placed[k][BENCH_REGION_NUM]++;
+				continue;
+			}
+
+			mp = pl_mempool_region_of(objs[n_objs]);
+			for (r = 0; r < BENCH_REGION_NUM && mps[r] != mp; r++)
+				;
+
+			placed[k][r]++;
+			n_objs++;
+		}
+	}
+
+	printf("%-8s", "");
+	for (r = 0; r < BENCH_REGION_NUM; r++)
+		printf(" %8s", bench_region_names[r]);
+	printf(" %8s\n", "fail");
+
+	for (k = 0; k < BENCH_REGION_KINDS; k++) {
+		printf("%-8s", bench_region_kinds[k]);
+		for (r = 0; r <= BENCH_REGION_NUM; r++)
+			printf(" %8zu", placed[k][r]);
+		printf("\n");
+	}
+
+	printf("\n%-8s %8s %8s %8s %8s %8s %8s\n", "region", "total", "free",
+	       "largest", "peak", "allocs", "fails");
+	for (r = 0; r < BENCH_REGION_NUM; r++) {
+		pl_mempool_get_stats(mps[r], &stats);
+		printf("%-8s %8zu %8zu %8zu %8zu %8zu %8zu\n", bench_region_names[r],
+		       stats.total_bytes, stats.free_bytes, stats.largest_free,
+		       stats.peak_used, stats.nr_allocs, stats.nr_fails);
+	}
+
+	for (i = 0; i < n_objs; i++)
+		pl_mempool_free_flags(objs[i]);
+
+	for (r = 0; r < BENCH_REGION_NUM; r++) {
+		pl_mempool_get_stats(mps[r], &stats);
+		if (stats.free_bytes != stats.total_bytes || stats.nr_allocs != 0) {
+			printf("region %s leaked %zu bytes\n", bench_region_names[r],
+			       stats.total_bytes - stats.free_bytes);
+			return -1;
+		}
+
+		free(pools[r]);
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t pool_size;
+	bool stress = false;
+	bool grow = false;
+	bool boot = false;
+	bool region = false;
+	size_t ops = BENCH_DEFAULT_OPS;
+	uint8_t grain_order = BENCH_GRAIN_ORDER;
+
+	if (argc > 1 && strcmp(argv[1], "stress") == 0) {
+		stress = true;
+		ops = BENCH_STRESS_OPS;
+		argc--;
+		argv++;
+	} else if (argc > 1 && strcmp(argv[1], "grow") == 0) {
+		grow = true;
+		ops = BENCH_GROW_OPS;
+		argc--;
+		argv++;
+	} else if (argc > 1 && strcmp(argv[1], "boot") == 0) {
+		boot = true;
+		ops = BENCH_BOOT_OPS;
+		argc--;
+		argv++;
+	} else if (argc > 1 && strcmp(argv[1], "region") == 0) {
+		region = true;
+		ops = BENCH_REGION_ROUNDS;
+		argc--;
+		argv++;
+	}
+
+	if (argc > 1)
+		ops = (size_t)strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		grain_order = (uint8_t)strtoul(argv[2], NULL, 0);
+
+	if (stress) {
+		printf("mempool stress: ops:%zu pool:%u grain:%u\n", ops,
+		       BENCH_STRESS_POOL, 1u << grain_order);
+		return bench_stress(ops, grain_order) < 0 ? 1 : 0;
+	}
+
+	if (grow) {
+		printf("mempool grow: rounds:%zu pool:%u grain:%u\n", ops,
+		       BENCH_GROW_POOL, 1u << grain_order);
+		return bench_grow(ops, grain_order) < 0 ? 1 : 0;
+	}
+
+	if (boot) {
+		printf("mempool boot: ops:%zu pool:%u arena:%u grain:%u\n", ops,
+		       BENCH_BOOT_POOL, BENCH_BOOT_ARENA, 1u << grain_order);
+		return bench_boot(ops, grain_order) < 0 ? 1 : 0;
+	}
+
+	if (region) {
+		printf("mempool region: rounds:%zu grain:%u\n", ops,
+		       1u << CONFIG_PL_DEFAULT_MEMPOOL_GRAIN_ORDER);
+		return bench_region(ops) < 0 ? 1 : 0;
+	}
+
+	printf("mempool bench: ops:%zu grain:%u (latency in ns)\n", ops,
+	       1u << grain_order);
+	printf("%10s %8s %10s %8s %10s %8s %8s %10s\n", "pool", "live",
+	       "malloc", "p99", "free", "p99", "fail", "free_bytes");
+
+	for (pool_size = BENCH_MIN_POOL; pool_size <= BENCH_MAX_POOL; pool_size <<= 2) {
+		if (bench_pool(pool_size, ops, grain_order) < 0)
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,292 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host test of the mpsc ring, the producers are pthreads as the interrupts and
+ * tasks of a board, they are preempted at any point of pl_mpsc_push():
+ *   stress: producers push numbered entries, the consumer checks that no entry
+ *           is lost or repeated and that the entries of a producer keep order.
+ *   bench: cycles per push and pop with 1 to 4 producers, the mpsc ring against
+ *          a ring whose indexes are updated under a lock, as pl_work_add() does
+ *          in a critical section.
+ *
+ * usage: mpsc_bench [entries]
+ *        mpsc_bench stress [entries]
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <pthread.h>
+#include <types.h>
+#include <kernel/kernel.h>
+#include <kernel/mpsc.h>
+
+#define BENCH_SLOTS             (256)
+#define BENCH_PRODUCERS_MAX     (4)
+#define BENCH_DEFAULT_ENTRIES   (4000000)
+#define STRESS_DEFAULT_ENTRIES  (1000000)
+
+/*************************************************************************************
+ * Description: stubs of port, the threads may run on other cores.
+ ************************************************************************************/
+/* the ring needs acquire and release order, never a store before a later load */
+void pl_port_cpu_dmb(void)
+{
+	__atomic_thread_fence(__ATOMIC_ACQ_REL);
+}
+
+uint_t pl_port_atomic_cmpxchg(volatile uint_t *ptr, uint_t old, uint_t val)
+{
+	__atomic_compare_exchange_n(ptr, &old, val, false, __ATOMIC_SEQ_CST,
+	                            __ATOMIC_SEQ_CST);
+	return old;
+}
+
+/*************************************************************************************
+ * Description: the ring with a lock, the lock stands for the critical section.
+ ************************************************************************************/
+struct locked_ring {
+	pthread_spinlock_t lock;
+	uint_t in;
+	uint_t out;
+	void *slots[BENCH_SLOTS];
+};
+
+static int locked_push(struct locked_ring *ring, void *data)
+{
+	int ret = -EFULL;
+
+	pthread_spin_lock(&ring->lock);
+	if (ring->in - ring->out < BENCH_SLOTS) {
+		ring->slots[ring->in % BENCH_SLOTS] = data;
+		++ring->in;
+		ret = OK;
+	}
+	pthread_spin_unlock(&ring->lock);
+
+	return ret;
+}
+
+static void *locked_pop(struct locked_ring *ring)
+{
+	void *data = NULL;
+
+	pthread_spin_lock(&ring->lock);
+	if (ring->in != ring->out) {
+		data = ring->slots[ring->out % BENCH_SLOTS];
+		++ring->out;
+	}
+	pthread_spin_unlock(&ring->lock);
+
+	return data;
+}
+
+/*************************************************************************************
+ * Description: producers.
+ ************************************************************************************/
+struct producer {
+	pthread_t thread;
+	uintptr_t id;
+	uint64_t entries;
+	bool locked;
+};
+
+static struct pl_mpsc_slot mpsc_slots[BENCH_SLOTS];
+static struct pl_mpsc mpsc;
+static struct locked_ring locked;
+static volatile int producers_go;
+
+/* an entry is the id of producer in the high bits and its number from 1 */
+static void *producer_task(void *arg)
+{
+	int ret;
+	uint64_t i;
+	struct producer *p = arg;
+
+	while (!producers_go)
+		sched_yield();
+
+	for (i = 1; i <= p->entries; i++) {
+		do {
+			if (p->locked)
+				ret = locked_push(&locked, (void *)((p->id << 40) | i));
+			else
+				ret = pl_mpsc_push(&mpsc, (void *)((p->id << 40) | i));
+
+			if (ret < 0)
+				sched_yield();
+		} while (ret < 0);
+	}
+
+	return NULL;
+}
+
+static uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* all the entries are popped, the last number of each producer is checked */
+static int run_producers(int nr_producers, uint64_t entries, bool locked_ring,
+                         uint64_t *cycles)
+{
+	int i;
+	void *data;
+	uintptr_t id;
+	uint64_t num;
+	uint64_t popped = 0;
+	uint64_t start;
+	uint64_t last[BENCH_PRODUCERS_MAX + 1];
+	struct producer producers[BENCH_PRODUCERS_MAX];
+
+	pl_mpsc_init(&mpsc, mpsc_slots, BENCH_SLOTS);
+	pthread_spin_init(&locked.lock, PTHREAD_PROCESS_PRIVATE);
+	locked.in = 0;
+	locked.out = 0;
+	memset(last, 0, sizeof(last));
+	producers_go = 0;
+	for (i = 0; i < nr_producers; i++) {
+		producers[i].id = (uintptr_t)i + 1;
+		producers[i].entries = entries / (uint64_t)nr_producers;
+		producers[i].locked = locked_ring;
+		pthread_create(&producers[i].thread, NULL, producer_task, &producers[i]);
+	}
+
+	start = bench_cycles();
+	producers_go = 1;
+	while (popped < entries / (uint64_t)nr_producers * (uint64_t)nr_producers) {
+		data = locked_ring ? locked_pop(&locked) : pl_mpsc_pop(&mpsc);
+		if (data == NULL) {
+			sched_yield();
+			continue;
+		}
+
+		id = (uintptr_t)data >> 40;
+		num = (uintptr_t)data & ((1ull << 40) - 1);
+		if (id == 0 || id > (uintptr_t)nr_producers || num != last[id] + 1) {
+			printf("producer %u: entry %llu after %llu\n", (unsigned int)id,
+			       (unsigned long long)num, (unsigned long long)last[id]);
+			return -1;
+		}
+
+		last[id] = num;
+		++popped;
+	}
+
+	*cycles = bench_cycles() - start;
+	for (i = 0; i < nr_producers; i++)
+		pthread_join(producers[i].thread, NULL);
+
+	if (!locked_ring && (pl_mpsc_pop(&mpsc) != NULL || pl_mpsc_len(&mpsc) != 0)) {
+		printf("ring not empty after %llu entries\n", (unsigned long long)popped);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int stress(uint64_t entries)
+{
+	int n;
+	int round;
+	uint64_t cycles;
+
+	for (round = 0; round < 4; round++) {
+		for (n = 1; n <= BENCH_PRODUCERS_MAX; n++) {
+			if (run_producers(n, entries, false, &cycles) < 0) {
+				printf("stress failed, producers:%d round:%d\n", n, round);
+				return -1;
+			}
+		}
+	}
+
+	printf("stress: %llu entries x %d producer counts x 4 rounds ok\n",
+	       (unsigned long long)entries, BENCH_PRODUCERS_MAX);
+	return 0;
+}
+
+/* push and pop on one thread, then the same with producers on threads */
+static int bench(uint64_t entries)
+{
+	int n;
+	uint64_t i;
+	uint64_t t;
+	uint64_t cycles[2];
+
+	pl_mpsc_init(&mpsc, mpsc_slots, BENCH_SLOTS);
+	pthread_spin_init(&locked.lock, PTHREAD_PROCESS_PRIVATE);
+	locked.in = 0;
+	locked.out = 0;
+
+	t = bench_cycles();
+	for (i = 1; i <= entries; i++) {
+		pl_mpsc_push(&mpsc, (void *)(uintptr_t)i);
+		pl_mpsc_pop(&mpsc);
+	}
+	cycles[0] = bench_cycles() - t;
+
+	t = bench_cycles();
+	for (i = 1; i <= entries; i++) {
+		locked_push(&locked, (void *)(uintptr_t)i);
+		locked_pop(&locked);
+	}
+	cycles[1] = bench_cycles() - t;
+
+	printf("mpsc bench: %llu entries, %d slots, cycles per push and pop\n",
+	       (unsigned long long)entries, BENCH_SLOTS);
+	printf("%-12s %10s %10s\n", "", "mpsc", "locked");
+	printf("%-12s %10.1f %10.1f\n", "uncontended", (double)cycles[0] / (double)entries,
+	       (double)cycles[1] / (double)entries);
+
+	for (n = 1; n <= BENCH_PRODUCERS_MAX; n++) {
+		if (run_producers(n, entries, false, &cycles[0]) < 0 ||
+		    run_producers(n, entries, true, &cycles[1]) < 0)
+			return -1;
+
+		printf("%d producers  %10.1f %10.1f\n", n, (double)cycles[0] / (double)entries,
+		       (double)cycles[1] / (double)entries);
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "stress") == 0)
+		return stress(argc > 2 ? strtoull(argv[2], NULL, 0) :
+		              STRESS_DEFAULT_ENTRIES) < 0 ? 1 : 0;
+
+	return bench(argc > 1 ? strtoull(argv[1], NULL, 0) :
+	             BENCH_DEFAULT_ENTRIES) < 0 ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host benchmark of the shell input path. The uart puts the received bytes into
+ * the kfifo of serial and calls pl_pipe_notify() as the shell does, the shell
+ * task reads 16 bytes at most with PL_PIPE_WAIT_FOREVER. The scheduler is
+ * simulated on a 15 us tick: while the shell sleeps, the ticks run and the uart
+ * puts the bytes due, until the pipe wakes it or its deadline expires.
+ *   per-byte: the shell is woken by every byte, as it was before the pipe.
+ *   shell: woken at 16 bytes, at a '\r' or 2 ms after the first byte.
+ * The input is 1 KB of "gpio set 3 1\r" lines:
+ *   typed: a key every 125 ms.
+ *   paste: back to back at 115200 baud, a byte every 87 us.
+ *   flood: a byte every tick.
+ * A wakeup is a sleep of the shell ended, latency is the time from a byte put to
+ * the read returning it, empty is the count of reads returning no byte.
+ *
+ * usage: pipe_bench [bytes]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <types.h>
+#include <errno.h>
+#include <port/port.h>
+#include <kernel/kernel.h>
+#include <kernel/mempool.h>
+#include <kernel/kfifo.h>
+#include <kernel/pipe.h>
+#include "../../kernel/task.h"
+
+#define BENCH_DEFAULT_BYTES     (1024)
+#define BENCH_TICK_US           (15)
+#define BENCH_FIFO_SIZE         (1024)
+#define BENCH_READ_CHARS        (16)
+#define BENCH_LATENCY_US        (2000)
+
+pl_mempool_handle_t g_pl_default_mempool;
+
+static struct tcb shell_tcb;
+static u64_t bench_ticks;
+static bool bench_in_tick;
+
+/* input of the uart */
+static const char *bench_line = "gpio set 3 1\r";
+static uint_t bench_bytes;
+static uint_t bench_put;
+static u64_t bench_interval_ns;
+static u64_t bench_put_ticks[BENCH_FIFO_SIZE];
+
+static char bench_buff[BENCH_FIFO_SIZE];
+static struct pl_kfifo bench_fifo;
+static struct pl_pipe bench_pipe;
+
+/*************************************************************************************
+ * Description: stubs of kernel, the shell is the only task.
+ ************************************************************************************/
+void pl_port_cpu_dmb(void)
+{
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+void pl_port_enter_critical(void)
+{
+}
+
+void pl_port_exit_critical(void)
+{
+}
+
+void *pl_mempool_alloc_sized(pl_mempool_handle_t mempool, size_t size)
+{
+	(void)mempool;
+	return malloc(size);
+}
+
+void pl_mempool_free_sized(pl_mempool_handle_t mempool, void *p, size_t size)
+{
+	(void)mempool;
+	(void)size;
+	free(p);
+}
+
+struct tcb *pl_task_get_curr_tcb(void)
+{
+	return &shell_tcb;
+}
+
+int pl_task_get_syscount(u64_t *c)
+{
+	*c = bench_ticks;
+	return OK;
+}
+
+void pl_task_remove_tcb_from_rdylist(struct tcb *tcb)
+{
+	(void)tcb;
+}
+
+void pl_task_insert_tcb_to_rdylist(struct tcb *tcb)
+{
+	tcb->curr_state = PL_TASK_STATE_READY;
+}
+
+void pl_task_insert_tcb_to_delaylist(struct tcb *tcb)
+{
+	tcb->curr_state = PL_TASK_STATE_DELAY;
+}
+
+void pl_task_remove_tcb_from_delaylist(struct tcb *tcb)
+{
+	(void)tcb;
+}
+
+/* the uart puts the bytes received by the end of the tick */
+static void bench_uart_tick(void)
+{
+	char c;
+
+	while (bench_put < bench_bytes &&
+	       bench_put * bench_interval_ns <= bench_ticks * BENCH_TICK_US * 1000) {
+		c = bench_line[bench_put % 13];
+		if (pl_kfifo_put(&bench_fifo, &c, 1) != 1)
+			break;
+
+		bench_put_ticks[bench_fifo.in % BENCH_FIFO_SIZE] = bench_ticks;
+		++bench_put;
+		pl_pipe_notify(&bench_pipe, &c, 1);
+	}
+}
+
+/* the ticks run while the shell sleeps, the interrupts may wake it */
+void pl_task_context_switch(void)
+{
+	if (bench_in_tick)
+		return;
+
+	bench_in_tick = true;
+	while (shell_tcb.curr_state == PL_TASK_STATE_DELAY) {
+		++bench_ticks;
+		bench_uart_tick();
+		if (shell_tcb.curr_state == PL_TASK_STATE_DELAY &&
+		    bench_ticks >= shell_tcb.delay_ticks)
+			shell_tcb.curr_state = PL_TASK_STATE_READY;
+	}
+
+	bench_in_tick = false;
+}
+
+/*************************************************************************************
+ * Description: benchmark.
+ ************************************************************************************/
+static void bench_run(const char *mode, const char *input, u64_t interval_ns,
+                      uint_t wake_len, int delim, u32_t latency)
+{
+	int i;
+	int ret;
+	uint_t got = 0;
+	uint_t empty = 0;
+	u64_t lat;
+	u64_t lat_sum = 0;
+	u64_t lat_max = 0;
+	char chars[BENCH_READ_CHARS];
+
+	pl_kfifo_init(&bench_fifo, bench_buff, sizeof(bench_buff));
+	pl_pipe_init(&bench_pipe, &bench_fifo);
+	pl_pipe_set_read_wake(&bench_pipe, wake_len, delim, latency);
+	shell_tcb.curr_state = PL_TASK_STATE_READY;
+	bench_ticks = 0;
+	bench_put = 0;
+	bench_interval_ns = interval_ns;
+
+	while (got < bench_bytes) {
+		ret = pl_pipe_read(&bench_pipe, chars, sizeof(chars), PL_PIPE_WAIT_FOREVER);
+		if (ret <= 0) {
+			++empty;
+			continue;
+		}
+
+		for (i = 0; i < ret; i++) {
+			lat = bench_ticks - bench_put_ticks[(got + i + 1) % BENCH_FIFO_SIZE];
+			lat_sum += lat;
+			lat_max = (lat > lat_max) ? lat : lat_max;
+		}
+
+		got += (uint_t)ret;
+	}
+
+	printf("%-6s %-9s %10u %10.1f %10.2f %10.2f %6u\n", input, mode,
+	       (uint_t)bench_pipe.nr_wakeups, bench_pipe.nr_wakeups * 1024.0 / bench_bytes,
+	       (double)lat_sum * BENCH_TICK_US / got / 1000.0,
+	       (double)lat_max * BENCH_TICK_US / 1000.0, empty);
+}
+
+int main(int argc, char *argv[])
+{
+	uint_t i;
+	static const struct {
+		const char *name;
+		u64_t interval_ns;
+	} inputs[] = {
+		{ "typed", 125000000ull },
+		{ "paste", 86806ull },
+		{ "flood", BENCH_TICK_US * 1000ull },
+	};
+
+	bench_bytes = (argc > 1) ? (uint_t)strtoul(argv[1], NULL, 0) : BENCH_DEFAULT_BYTES;
+	if (bench_bytes == 0)
+		return 1;
+
+	printf("pipe bench: %u bytes, tick %u us\n", bench_bytes, BENCH_TICK_US);
+	printf("input  mode         wakeups  per KB     avg ms     max ms  empty\n");
+	for (i = 0; i < ARRAY_SIZE(inputs); i++) {
+		bench_run("per-byte", inputs[i].name, inputs[i].interval_ns, 1,
+		          PL_PIPE_NO_DELIM, 0);
+		bench_run("shell", inputs[i].name, inputs[i].interval_ns, BENCH_READ_CHARS,
+		          '\r', BENCH_LATENCY_US / BENCH_TICK_US);
+	}
+
+	return 0;
+}
@@ -0,0 +1,225 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host benchmark of the typed ring, elements of 8 bytes go through a ring of
+ * 256 elements, as the samples of a driver to its task:
+ *   ring: pl_sample_ring_push() and pl_sample_ring_pop() of one element.
+ *   ring_n: pl_sample_ring_push_n() and pl_sample_ring_pop_n() of 16 elements.
+ *   kfifo: pl_kfifo_put() and pl_kfifo_get() of the bytes of one element.
+ *
+ * ring_push_one() and ring_pop_one() are kept out of line only to be shown by
+ * "make asm", the loops inline the ring as a driver does.
+ *
+ * usage: ring_bench [elements]
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <types.h>
+#include <lib/string.h>
+#include <kernel/kernel.h>
+#include <kernel/mempool.h>
+#include <kernel/kfifo.h>
+#include <kernel/ring.h>
+
+#define BENCH_DEFAULT_ELEMS     (64000000ull)
+#define BENCH_RING_CAP          (256)
+#define BENCH_BATCH             (16)
+
+pl_mempool_handle_t g_pl_default_mempool;
+
+/*************************************************************************************
+ * Description: stubs of kernel.
+ ************************************************************************************/
+/* a single core MCU only needs the compiler to keep the order */
+void pl_port_cpu_dmb(void)
+{
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+void *pl_mempool_alloc_sized(pl_mempool_handle_t mempool, size_t size)
+{
+	(void)mempool;
+	return malloc(size);
+}
+
+void pl_mempool_free_sized(pl_mempool_handle_t mempool, void *p, size_t size)
+{
+	(void)mempool;
+	(void)size;
+	free(p);
+}
+
+/*************************************************************************************
+ * Description: benchmark.
+ ************************************************************************************/
+struct sample {
+	u16_t chan;
+	u16_t flags;
+	u32_t value;
+};
+
+PL_RING_DEFINE(pl_sample_ring, struct sample)
+
+static struct sample ring_buff[BENCH_RING_CAP];
+static char fifo_buff[BENCH_RING_CAP * sizeof(struct sample)];
+
+bool ring_push_one(struct pl_sample_ring *ring, struct sample val);
+bool ring_pop_one(struct pl_sample_ring *ring, struct sample *val);
+
+__attribute__((noinline)) bool ring_push_one(struct pl_sample_ring *ring,
+                                             struct sample val)
+{
+	return pl_sample_ring_push(ring, val);
+}
+
+__attribute__((noinline)) bool ring_pop_one(struct pl_sample_ring *ring,
+                                            struct sample *val)
+{
+	return pl_sample_ring_pop(ring, val);
+}
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* the producer runs a batch ahead of the consumer, as an interrupt does */
+static u32_t bench_ring(struct pl_sample_ring *ring, uint64_t total)
+{
+	uint64_t i;
+	uint_t j;
+	u32_t sum = 0;
+	struct sample val = { 0 };
+
+	for (i = 0; i < total; i += BENCH_BATCH) {
+		for (j = 0; j < BENCH_BATCH; j++) {
+			val.chan = (u16_t)j;
+			val.value = (u32_t)(i + j);
+			pl_sample_ring_push(ring, val);
+		}
+
+		for (j = 0; j < BENCH_BATCH; j++) {
+			pl_sample_ring_pop(ring, &val);
+			sum += val.value + val.chan;
+		}
+	}
+
+	return sum;
+}
+
+static u32_t bench_ring_n(struct pl_sample_ring *ring, uint64_t total)
+{
+	uint64_t i;
+	uint_t j;
+	u32_t sum = 0;
+	struct sample vals[BENCH_BATCH] = { { 0 } };
+
+	for (i = 0; i < total; i += BENCH_BATCH) {
+		for (j = 0; j < BENCH_BATCH; j++) {
+			vals[j].chan = (u16_t)j;
+			vals[j].value = (u32_t)(i + j);
+		}
+
+		pl_sample_ring_push_n(ring, vals, BENCH_BATCH);
+		pl_sample_ring_pop_n(ring, vals, BENCH_BATCH);
+		for (j = 0; j < BENCH_BATCH; j++)
+			sum += vals[j].value + vals[j].chan;
+	}
+
+	return sum;
+}
+
+static u32_t bench_kfifo(struct pl_kfifo *fifo, uint64_t total)
+{
+	uint64_t i;
+	uint_t j;
+	u32_t sum = 0;
+	struct sample val = { 0 };
+
+	for (i = 0; i < total; i += BENCH_BATCH) {
+		for (j = 0; j < BENCH_BATCH; j++) {
+			val.chan = (u16_t)j;
+			val.value = (u32_t)(i + j);
+			pl_kfifo_put(fifo, (char *)&val, sizeof(val));
+		}
+
+		for (j = 0; j < BENCH_BATCH; j++) {
+			pl_kfifo_get(fifo, (char *)&val, sizeof(val));
+			sum += val.value + val.chan;
+		}
+	}
+
+	return sum;
+}
+
+static void bench_report(const char *name, uint64_t total, uint64_t ns, u32_t sum)
+{
+	printf("%-8s %6.2f ns/elem  %7.1f M elem/s  sum:%08x\n", name,
+	       (double)ns / (double)total, (double)total * 1000.0 / (double)ns,
+	       (unsigned int)sum);
+}
+
+int main(int argc, char *argv[])
+{
+	u32_t sum;
+	uint64_t t0;
+	uint64_t total = BENCH_DEFAULT_ELEMS;
+	struct pl_kfifo fifo;
+	struct pl_sample_ring ring;
+	struct sample val = { 1, 0, 2 };
+
+	if (argc > 1)
+		total = strtoull(argv[1], NULL, 0);
+
+	total -= total % BENCH_BATCH;
+	if (total == 0)
+		return 1;
+
+	pl_sample_ring_init(&ring, ring_buff, BENCH_RING_CAP);
+	if (!ring_push_one(&ring, val) || !ring_pop_one(&ring, &val) || val.value != 2)
+		return 1;
+
+	pl_sample_ring_init(&ring, ring_buff, BENCH_RING_CAP);
+	t0 = bench_now_ns();
+	sum = bench_ring(&ring, total);
+	bench_report("ring", total, bench_now_ns() - t0, sum);
+
+	pl_sample_ring_init(&ring, ring_buff, BENCH_RING_CAP);
+	t0 = bench_now_ns();
+	sum = bench_ring_n(&ring, total);
+	bench_report("ring_n", total, bench_now_ns() - t0, sum);
+
+	pl_kfifo_init(&fifo, fifo_buff, sizeof(fifo_buff));
+	t0 = bench_now_ns();
+	sum = bench_kfifo(&fifo, total);
+	bench_report("kfifo", total, bench_now_ns() - t0, sum);
+
+	return 0;
+}
@@ -0,0 +1,584 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host benchmark of the soft timer queue, the timers have random periods of 1 to
+ * 16384 ticks, as the retransmit timers of protocols:
+ *   start: add every timer to the queue at its reach_cnt.
+ *   cancel: delete every timer from the queue.
+ *   expire: tick the queue, every timer expired is started again with its period,
+ *           ns per tick covers the tick, the expiries and the restarts.
+ * "wheel" is pl_timer_wheel, "list" is the sorted list walked by the systick
+ * handler before it. The timers expired late or early are counted as errors.
+ *
+ * The drift mode runs a 1 kHz reload timer on a 10 us tick, the daemon calls it
+ * 0 to 200 us after it expires and stalls 3.5 ms every 100000 periods:
+ *   restart: the timer is started again from the time its callback returns, as
+ *            the daemon did before.
+ *   periodic: pl_timer_wheel_add_periodic() from the last deadline.
+ * drift is the distance of the last callback from its ideal time, jitter is the
+ * deviation of the intervals between callbacks.
+ *
+ * The latency mode ticks a thread every 100 us as the systick handler, a hard
+ * timer is called in it and a daemon timer by a daemon thread woken by it, both
+ * are reload timers of 4 ticks. The latency is the time from the start of the
+ * tick handler to the callback.
+ *
+ * The coalesce mode runs 200 reload timers on a 100 us tick for 60 s: 20 status
+ * LEDs of 500 ms, 30 housekeeping timers of 1 to 5 s and 150 retry timers of 100
+ * to 400 ms, with random phases. A wakeup is a tick with any expiry, they are
+ * counted with no slack and with a slack of 10% of the period, as well as the
+ * wakeups saved counted as pl_softtimer_update() does.
+ *
+ * usage: stimer_bench [ticks]
+ *        stimer_bench drift [periods]
+ *        stimer_bench latency [expiries]
+ *        stimer_bench coalesce
+ */
+
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <types.h>
+#include <kernel/kernel.h>
+#include <kernel/list.h>
+#include <kernel/softtimer.h>
+#include "../../kernel/timer_wheel.h"
+
+#define BENCH_DEFAULT_TICKS     (200000)
+#define BENCH_PERIOD_MAX        (16384)
+#define BENCH_TIMERS_MAX        (10000)
+#define BENCH_START_OPS         (100000)
+#define DRIFT_DEFAULT_PERIODS   (1000000)
+#define DRIFT_TICK_US           (10)
+#define DRIFT_PERIOD_TICKS      (1000 / DRIFT_TICK_US)
+#define DRIFT_LATENCY_MAX       (20)
+#define DRIFT_STALL_TICKS       (350)
+#define DRIFT_STALL_EVERY       (100000)
+#define LAT_DEFAULT_EXPIRIES    (10000)
+#define LAT_TICK_NS             (100000)
+#define LAT_PERIOD_TICKS        (4)
+#define CO_TIMERS               (200)
+#define CO_TICK_US              (100)
+#define CO_SECONDS              (60)
+#define CO_MS_TICKS(ms)         ((ms) * 1000 / CO_TICK_US)
+
+/*************************************************************************************
+ * Description: the sorted list of soft timers, as it was in the systick handler.
+ ************************************************************************************/
+static void list_queue_add(struct list_node *queue, struct pl_stimer *timer)
+{
+	struct pl_stimer *pos;
+
+	list_for_each_entry(pos, queue, struct pl_stimer, node) {
+		if (timer->reach_cnt < pos->reach_cnt)
+			break;
+	}
+
+	list_add_node_ahead(&pos->node, &timer->node);
+}
+
+static void list_queue_advance(struct list_node *queue, u64_t now,
+                               struct list_node *expired)
+{
+	struct pl_stimer *pos;
+
+	list_for_each_entry(pos, queue, struct pl_stimer, node) {
+		if (pos->reach_cnt > now)
+			break;
+	}
+
+	if (pos->node.prev != queue)
+		list_move_chain_to_node_behind(expired->prev, queue->next, pos->node.prev);
+}
+
+/*************************************************************************************
+ * Description: benchmark.
+ ************************************************************************************/
+struct bench_queue {
+	const char *name;
+	void (*add)(void *queue, struct pl_stimer *timer);
+	void (*advance)(void *queue, u64_t now, struct list_node *expired);
+	void (*init)(void *queue, u64_t clk);
+	void *queue;
+};
+
+static struct pl_stimer timers[BENCH_TIMERS_MAX];
+static struct pl_timer_wheel wheel;
+static struct list_node list_queue;
+static u32_t bench_seed = 0x2545f491;
+
+static void wheel_add(void *queue, struct pl_stimer *timer)
+{
+	pl_timer_wheel_add(queue, timer);
+}
+
+static void wheel_advance(void *queue, u64_t now, struct list_node *expired)
+{
+	pl_timer_wheel_advance(queue, now, expired);
+}
+
+static void wheel_init(void *queue, u64_t clk)
+{
+	pl_timer_wheel_init(queue, clk);
+}
+
+static void list_add(void *queue, struct pl_stimer *timer)
+{
+	list_queue_add(queue, timer);
+}
+
+static void list_advance(void *queue, u64_t now, struct list_node *expired)
+{
+	list_queue_advance(queue, now, expired);
+}
+
+static void list_init_queue(void *queue, u64_t clk)
+{
+	USED(clk);
+	list_init(queue);
+}
+
+static u32_t bench_rand(void)
+{
+	bench_seed ^= bench_seed << 13;
+	bench_seed ^= bench_seed >> 17;
+	bench_seed ^= bench_seed << 5;
+	return bench_seed;
+}
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_arm(struct pl_stimer *timer, u64_t now)
+{
+	timer->reach_cnt = now + timer->timing_cnt;
+}
+
+static void bench_queue(struct bench_queue *q, uint_t nr, u64_t ticks)
+{
+	uint_t i;
+	uint_t round;
+	uint_t rounds;
+	u64_t now = 1;
+	u64_t errors = 0;
+	u64_t expiries = 0;
+	uint64_t t0;
+	uint64_t start_ns = 0;
+	uint64_t cancel_ns = 0;
+	uint64_t expire_ns;
+	struct list_node expired;
+	struct pl_stimer *timer;
+
+	bench_seed = 0x2545f491;
+	for (i = 0; i < nr; i++) {
+		timers[i].timing_cnt = bench_rand() % BENCH_PERIOD_MAX + 1;
+		list_init(&timers[i].node);
+	}
+
+	/* start and cancel all timers, as many times as the operations need */
+	q->init(q->queue, now);
+	rounds = BENCH_START_OPS / nr + 1;
+	for (round = 0; round < rounds; round++) {
+		t0 = bench_now_ns();
+		for (i = 0; i < nr; i++) {
+			bench_arm(&timers[i], now);
+			q->add(q->queue, &timers[i]);
+		}
+
+		start_ns += bench_now_ns() - t0;
+		t0 = bench_now_ns();
+		for (i = 0; i < nr; i++)
+			list_del_node(&timers[i].node);
+
+		cancel_ns += bench_now_ns() - t0;
+	}
+
+	/* tick with all timers running */
+	for (i = 0; i < nr; i++) {
+		bench_arm(&timers[i], now);
+		q->add(q->queue, &timers[i]);
+	}
+
+	list_init(&expired);
+	t0 = bench_now_ns();
+	for (now = 2; now < ticks + 2; now++) {
+		q->advance(q->queue, now, &expired);
+		while (!list_is_empty(&expired)) {
+			timer = container_of(list_del_front_node(&expired), struct pl_stimer, node);
+			errors += (timer->reach_cnt != now);
+			bench_arm(timer, now);
+			q->add(q->queue, timer);
+			++expiries;
+		}
+	}
+
+	expire_ns = bench_now_ns() - t0;
+	printf("%-6s %6u %9.1f %9.1f %9.1f %10.1f %9llu %6llu\n", q->name, nr,
+	       (double)start_ns / (double)(rounds * nr),
+	       (double)cancel_ns / (double)(rounds * nr),
+	       (double)expire_ns / (double)ticks,
+	       expiries ? (double)expire_ns / (double)expiries : 0.0,
+	       (unsigned long long)expiries, (unsigned long long)errors);
+}
+
+static void bench_drift(bool periodic, u64_t periods)
+{
+	u64_t now;
+	u64_t last = 0;
+	u64_t run_at = 0;
+	u64_t prev_call = 0;
+	u64_t calls = 0;
+	u64_t overruns = 0;
+	int64_t dev = 0;
+	int64_t max_dev = 0;
+	double interval;
+	double sum = 0.0;
+	double sum_sq = 0.0;
+	struct pl_stimer timer = { .slack_mask = 0 };
+	struct list_node expired;
+
+	bench_seed = 0x2545f491;
+	list_init(&expired);
+	list_init(&timer.node);
+	pl_timer_wheel_init(&wheel, 1);
+	timer.timing_cnt = DRIFT_PERIOD_TICKS;
+	timer.reach_cnt = DRIFT_PERIOD_TICKS;
+	pl_timer_wheel_add(&wheel, &timer);
+
+	for (now = 1; calls + overruns < periods; now++) {
+		pl_timer_wheel_advance(&wheel, now, &expired);
+		if (!list_is_empty(&expired)) {
+			list_del_front_node(&expired);
+			last = timer.reach_cnt;
+			run_at = now + bench_rand() % (DRIFT_LATENCY_MAX + 1);
+			if ((calls + 1) % DRIFT_STALL_EVERY == 0)
+				run_at += DRIFT_STALL_TICKS;
+		}
+
+		/* the daemon calls the timer and starts it again */
+		if (run_at != now)
+			continue;
+
+		if (calls != 0) {
+			interval = (double)(now - prev_call);
+			sum += interval;
+			sum_sq += interval * interval;
+		}
+
+		++calls;
+		prev_call = now;
+		dev = (int64_t)now - (int64_t)((calls + overruns) * DRIFT_PERIOD_TICKS);
+		if (llabs(dev) > max_dev)
+			max_dev = llabs(dev);
+
+		if (periodic) {
+			overruns += pl_timer_wheel_add_periodic(&wheel, &timer, last, now);
+		} else {
+			timer.reach_cnt = now + timer.timing_cnt;
+			pl_timer_wheel_add(&wheel, &timer);
+		}
+	}
+
+	sum /= (double)(calls - 1);
+	printf("%-8s %8llu %8llu %12.3f %12.3f %10.2f\n", periodic ? "periodic" : "restart",
+	       (unsigned long long)calls, (unsigned long long)overruns,
+	       (double)dev * DRIFT_TICK_US / 1000.0, (double)max_dev * DRIFT_TICK_US / 1000.0,
+	       sqrt(sum_sq / (double)(calls - 1) - sum * sum) * DRIFT_TICK_US);
+}
+
+struct lat_timer {
+	struct pl_stimer timer;
+	uint64_t tick_ns;
+	uint64_t *samples;
+	uint_t nr;
+};
+
+static pthread_mutex_t lat_lock = PTHREAD_MUTEX_INITIALIZER;
+static sem_t lat_daemon_sem;
+static struct list_node lat_daemon_list;
+static volatile bool lat_stop;
+static u64_t lat_now;
+
+/* the reload timers are started again from their last deadline, as the daemon */
+static void lat_call(struct lat_timer *lt, uint64_t tick_ns)
+{
+	u64_t last = lt->timer.reach_cnt;
+
+	lt->samples[lt->nr++] = bench_now_ns() - tick_ns;
+	pthread_mutex_lock(&lat_lock);
+	pl_timer_wheel_add_periodic(&wheel, &lt->timer, last, lat_now);
+	pthread_mutex_unlock(&lat_lock);
+}
+
+static void *lat_daemon(void *arg)
+{
+	struct lat_timer *lt;
+	struct list_node expired;
+
+	USED(arg);
+	list_init(&expired);
+	while (true) {
+		sem_wait(&lat_daemon_sem);
+		if (lat_stop)
+			break;
+
+		pthread_mutex_lock(&lat_lock);
+		if (!list_is_empty(&lat_daemon_list))
+			list_move_chain_to_node_behind(expired.prev, lat_daemon_list.next,
+			                               lat_daemon_list.prev);
+		pthread_mutex_unlock(&lat_lock);
+
+		while (!list_is_empty(&expired)) {
+			lt = container_of(list_del_front_node(&expired), struct lat_timer, timer.node);
+			lat_call(lt, lt->tick_ns);
+		}
+	}
+
+	return NULL;
+}
+
+static int lat_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void lat_report(const char *name, struct lat_timer *lt)
+{
+	qsort(lt->samples, lt->nr, sizeof(uint64_t), lat_cmp);
+	printf("%-7s %8u %10.2f %10.2f %10.2f\n", name, lt->nr,
+	       (double)lt->samples[lt->nr / 2] / 1000.0,
+	       (double)lt->samples[lt->nr * 99 / 100] / 1000.0,
+	       (double)lt->samples[lt->nr - 1] / 1000.0);
+}
+
+static int bench_latency(uint_t expiries)
+{
+	bool wakeup;
+	uint64_t tick_ns;
+	pthread_t daemon;
+	struct timespec next;
+	struct list_node expired;
+	struct lat_timer *lt;
+	struct lat_timer hard = { .nr = 0 };
+	struct lat_timer soft = { .nr = 0 };
+
+	hard.samples = malloc(sizeof(uint64_t) * expiries);
+	soft.samples = malloc(sizeof(uint64_t) * expiries);
+	if (hard.samples == NULL || soft.samples == NULL)
+		return 1;
+
+	list_init(&expired);
+	list_init(&lat_daemon_list);
+	list_init(&hard.timer.node);
+	list_init(&soft.timer.node);
+	sem_init(&lat_daemon_sem, 0, 0);
+	pl_timer_wheel_init(&wheel, 1);
+	hard.timer.timing_cnt = LAT_PERIOD_TICKS;
+	hard.timer.reach_cnt = LAT_PERIOD_TICKS;
+	hard.timer.hard = true;
+	soft.timer.timing_cnt = LAT_PERIOD_TICKS;
+	soft.timer.reach_cnt = LAT_PERIOD_TICKS + LAT_PERIOD_TICKS / 2;
+	soft.timer.hard = false;
+	pl_timer_wheel_add(&wheel, &hard.timer);
+	pl_timer_wheel_add(&wheel, &soft.timer);
+	pthread_create(&daemon, NULL, lat_daemon, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (hard.nr < expiries || soft.nr < expiries) {
+		next.tv_nsec += LAT_TICK_NS;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			++next.tv_sec;
+		}
+
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+		/* the tick handler */
+		wakeup = false;
+		pthread_mutex_lock(&lat_lock);
+		tick_ns = bench_now_ns();
+		pl_timer_wheel_advance(&wheel, ++lat_now, &expired);
+		pthread_mutex_unlock(&lat_lock);
+		while (!list_is_empty(&expired)) {
+			lt = container_of(list_del_front_node(&expired), struct lat_timer, timer.node);
+			if (lt->timer.hard && lt->nr < expiries) {
+				lat_call(lt, tick_ns);
+			} else if (lt->nr < expiries) {
+				lt->tick_ns = tick_ns;
+				pthread_mutex_lock(&lat_lock);
+				list_add_node_at_tail(&lat_daemon_list, &lt->timer.node);
+				pthread_mutex_unlock(&lat_lock);
+				wakeup = true;
+			}
+		}
+
+		if (wakeup)
+			sem_post(&lat_daemon_sem);
+	}
+
+	lat_stop = true;
+	sem_post(&lat_daemon_sem);
+	pthread_join(daemon, NULL);
+
+	printf("stimer latency: tick %u us, period %u ticks (us)\n", LAT_TICK_NS / 1000,
+	       LAT_PERIOD_TICKS);
+	printf("mode       calls        p50        p99        max\n");
+	lat_report("hard", &hard);
+	lat_report("daemon", &soft);
+	free(hard.samples);
+	free(soft.samples);
+	return 0;
+}
+
+static void bench_coalesce(uint_t slack_pct)
+{
+	uint_t i;
+	uint_t nr_expired;
+	uint_t nr_rounded;
+	u64_t now;
+	u64_t late;
+	u64_t max_late = 0;
+	u64_t errors = 0;
+	u64_t wakeups = 0;
+	u64_t expiries = 0;
+	u64_t saved = 0;
+	u64_t ticks = (u64_t)CO_SECONDS * 1000000 / CO_TICK_US;
+	struct list_node expired;
+	struct pl_stimer *timer;
+
+	bench_seed = 0x2545f491;
+	pl_timer_wheel_init(&wheel, 1);
+	for (i = 0; i < CO_TIMERS; i++) {
+		timer = &timers[i];
+		if (i < 20)
+			timer->timing_cnt = CO_MS_TICKS(500);
+		else if (i < 50)
+			timer->timing_cnt = CO_MS_TICKS(1000 + bench_rand() % 4001);
+		else
+			timer->timing_cnt = CO_MS_TICKS(100 + bench_rand() % 301);
+
+		timer->slack_mask = pl_timer_wheel_slack_mask(timer->timing_cnt * slack_pct / 100);
+		timer->reach_cnt = 1 + bench_rand() % timer->timing_cnt;
+		list_init(&timer->node);
+		pl_timer_wheel_add(&wheel, timer);
+	}
+
+	list_init(&expired);
+	for (now = 1; now <= ticks; now++) {
+		pl_timer_wheel_advance(&wheel, now, &expired);
+		if (list_is_empty(&expired))
+			continue;
+
+		++wakeups;
+		nr_expired = 0;
+		nr_rounded = 0;
+		list_for_each_entry(timer, &expired, struct pl_stimer, node) {
+			++nr_expired;
+			if (timer->reach_cnt & timer->slack_mask)
+				++nr_rounded;
+		}
+
+		if (nr_expired > 1)
+			saved += min(nr_rounded, nr_expired - 1);
+
+		while (!list_is_empty(&expired)) {
+			timer = container_of(list_del_front_node(&expired), struct pl_stimer, node);
+			late = now - timer->reach_cnt;
+			max_late = max(max_late, late);
+			errors += (now < timer->reach_cnt || late > timer->slack_mask);
+			pl_timer_wheel_add_periodic(&wheel, timer, timer->reach_cnt, now);
+			++expiries;
+		}
+	}
+
+	printf("%8u%% %10.1f %10.1f %10.1f %12.2f %6llu\n", slack_pct,
+	       (double)expiries / CO_SECONDS, (double)wakeups / CO_SECONDS,
+	       (double)saved / CO_SECONDS, (double)max_late * CO_TICK_US / 1000.0,
+	       (unsigned long long)errors);
+}
+
+int main(int argc, char *argv[])
+{
+	uint_t i;
+	uint_t j;
+	u64_t ticks = BENCH_DEFAULT_TICKS;
+	static const uint_t nr_timers[] = { 10, 1000, 10000 };
+	struct bench_queue queues[] = {
+		{ "wheel", wheel_add, wheel_advance, wheel_init, &wheel },
+		{ "list", list_add, list_advance, list_init_queue, &list_queue },
+	};
+
+	if (argc > 1 && strcmp(argv[1], "latency") == 0) {
+		ticks = (argc > 2) ? strtoull(argv[2], NULL, 0) : LAT_DEFAULT_EXPIRIES;
+		return (ticks == 0) ? 1 : bench_latency((uint_t)ticks);
+	}
+
+	if (argc > 1 && strcmp(argv[1], "coalesce") == 0) {
+		printf("stimer coalesce: %u timers, tick %u us, %u s (per second)\n",
+		       CO_TIMERS, CO_TICK_US, CO_SECONDS);
+		printf("   slack   expiries    wakeups      saved  max late ms errors\n");
+		bench_coalesce(0);
+		bench_coalesce(10);
+		return 0;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "drift") == 0) {
+		ticks = (argc > 2) ? strtoull(argv[2], NULL, 0) : DRIFT_DEFAULT_PERIODS;
+		if (ticks < 2)
+			return 1;
+
+		printf("stimer drift: %llu periods of 1 ms, tick %u us\n",
+		       (unsigned long long)ticks, DRIFT_TICK_US);
+		printf("mode        calls overruns     drift ms  max dev ms  jitter us\n");
+		bench_drift(false, ticks);
+		bench_drift(true, ticks);
+		return 0;
+	}
+
+	if (argc > 1)
+		ticks = strtoull(argv[1], NULL, 0);
+
+	printf("stimer bench: %llu ticks, wheel %u levels of %u slots (ns)\n",
+	       (unsigned long long)ticks, PL_TIMER_WHEEL_LEVELS, PL_TIMER_WHEEL_SLOTS);
+	printf("queue  timers     start    cancel  per tick per expiry  expiries errors\n");
+	for (i = 0; i < ARRAY_SIZE(nr_timers); i++) {
+		for (j = 0; j < ARRAY_SIZE(queues); j++)
+			bench_queue(&queues[j], nr_timers[i], ticks);
+	}
+
+	return 0;
+}
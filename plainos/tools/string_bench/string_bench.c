@@ -0,0 +1,352 @@
+/* MIT License
+
+Copyright (c) 2023 PlainOS
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Host test of lib/string, the pl_ functions are checked against libc on random
+ * lengths, offsets and overlaps, and their throughput is compared with a byte
+ * loop and libc.
+ *
+ * usage: string_bench
+ *        string_bench fuzz [rounds]
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <types.h>
+#include <lib/string.h>
+
+/* keep gcc from turning the byte loops into libc calls */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("no-tree-loop-distribute-patterns")
+#endif
+
+#define BENCH_FUZZ_ROUNDS       (200000)
+#define BENCH_FUZZ_BUF          (4096 + 256)
+#define BENCH_FUZZ_MAX_LEN      (4096 + 64)
+#define BENCH_FUZZ_MAX_OFF      (16)
+#define BENCH_RUN_BYTES         (64ull << 20)
+#define BENCH_RUN_BUF           (8192 + 64)
+
+typedef void *(*bench_copy_t)(void *dest, const void *src, size_t len);
+typedef void *(*bench_set_t)(void *dest, int c, size_t len);
+typedef size_t (*bench_len_t)(const char *str);
+
+static uint64_t rand_state = 0x2545f4914f6cdd1dull;
+static uint8_t fuzz_a[BENCH_FUZZ_BUF];
+static uint8_t fuzz_b[BENCH_FUZZ_BUF];
+static uint8_t fuzz_c[BENCH_FUZZ_BUF];
+static uint8_t run_src[BENCH_RUN_BUF];
+static uint8_t run_dst[BENCH_RUN_BUF];
+
+static uint64_t bench_rand(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return rand_state;
+}
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_sign(int v)
+{
+	return (v > 0) - (v < 0);
+}
+
+static void bench_fill(uint8_t *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t)bench_rand();
+}
+
+/* mostly short, as the kernel uses them, some of them up to 4KB */
+static size_t bench_rand_len(void)
+{
+	uint64_t r = bench_rand();
+
+	if ((r & 7) == 0)
+		return (size_t)((r >> 8) % BENCH_FUZZ_MAX_LEN);
+
+	return (size_t)((r >> 8) % 80);
+}
+
+static size_t bench_rand_off(void)
+{
+	return (size_t)(bench_rand() % BENCH_FUZZ_MAX_OFF);
+}
+
+/*************************************************************************************
+ * Description: fuzz, each function is run on copies of the same random buffers
+ *              with libc, then the whole buffers and results are compared.
+ ************************************************************************************/
+static int bench_fuzz_mem(void)
+{
+	int c;
+	size_t len = bench_rand_len();
+	size_t doff = bench_rand_off();
+	size_t soff = bench_rand_off();
+
+	bench_fill(fuzz_a, sizeof(fuzz_a));
+	bench_fill(fuzz_b, sizeof(fuzz_b));
+	memcpy(fuzz_c, fuzz_b, sizeof(fuzz_c));
+	if (pl_memcpy(fuzz_b + doff, fuzz_a + soff, len) != fuzz_b + doff)
+		return -1;
+	memcpy(fuzz_c + doff, fuzz_a + soff, len);
+	if (memcmp(fuzz_b, fuzz_c, sizeof(fuzz_b)) != 0) {
+		printf("memcpy len:%zu dst+%zu src+%zu\n", len, doff, soff);
+		return -1;
+	}
+
+	c = (int)bench_rand();
+	if (pl_memset(fuzz_b + doff, c, len) != fuzz_b + doff)
+		return -1;
+	memset(fuzz_c + doff, c, len);
+	if (memcmp(fuzz_b, fuzz_c, sizeof(fuzz_b)) != 0) {
+		printf("memset len:%zu dst+%zu c:%d\n", len, doff, c);
+		return -1;
+	}
+
+	/* overlap both ways inside one buffer */
+	soff = bench_rand_off() * 4 + bench_rand_off();
+	doff = bench_rand_off() * 4 + bench_rand_off();
+	len += (len == 0);
+	memcpy(fuzz_b, fuzz_a, sizeof(fuzz_b));
+	memcpy(fuzz_c, fuzz_a, sizeof(fuzz_c));
+	if (pl_memmove(fuzz_b + doff, fuzz_b + soff, len) != fuzz_b + doff)
+		return -1;
+	memmove(fuzz_c + doff, fuzz_c + soff, len);
+	if (memcmp(fuzz_b, fuzz_c, sizeof(fuzz_b)) != 0) {
+		printf("memmove len:%zu dst+%zu src+%zu\n", len, doff, soff);
+		return -1;
+	}
+
+	/* equal, or different at a random byte */
+	doff = bench_rand_off();
+	soff = bench_rand_off();
+	memcpy(fuzz_b + doff, fuzz_a + soff, len);
+	if ((bench_rand() & 1) != 0)
+		fuzz_b[doff + bench_rand() % len] = (uint8_t)bench_rand();
+	if (bench_sign(pl_memcmp(fuzz_b + doff, fuzz_a + soff, len)) !=
+	    bench_sign(memcmp(fuzz_b + doff, fuzz_a + soff, len))) {
+		printf("memcmp len:%zu s1+%zu s2+%zu\n", len, doff, soff);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int bench_fuzz_str(void)
+{
+	size_t i;
+	size_t len = bench_rand_len();
+	size_t off1 = bench_rand_off();
+	size_t off2 = bench_rand_off();
+	char *s1 = (char *)fuzz_a + off1;
+	char *s2 = (char *)fuzz_b + off2;
+
+	for (i = 0; i < len; i++)
+		s1[i] = (char)(1 + bench_rand() % 255);
+	s1[len] = '\0';
+	if (pl_strlen(s1) != len) {
+		printf("strlen len:%zu s+%zu\n", len, off1);
+		return -1;
+	}
+
+	/* the same, a different char, or a shorter string */
+	memcpy(s2, s1, len + 1);
+	if (len != 0 && (bench_rand() & 1) != 0) {
+		i = (size_t)(bench_rand() % len);
+		s2[i] = (char)(bench_rand() % 256);
+	}
+
+	if (bench_sign(pl_strcmp(s1, s2)) != bench_sign(strcmp(s1, s2)) ||
+	    bench_sign(pl_strcmp(s2, s1)) != bench_sign(strcmp(s2, s1))) {
+		printf("strcmp len:%zu s1+%zu s2+%zu\n", len, off1, off2);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int bench_fuzz(size_t rounds)
+{
+	size_t i;
+
+	for (i = 0; i < rounds; i++) {
+		if (bench_fuzz_mem() < 0 || bench_fuzz_str() < 0) {
+			printf("round %zu failed\n", i);
+			return -1;
+		}
+	}
+
+	printf("string fuzz: %zu rounds passed\n", rounds);
+	return 0;
+}
+
+/*************************************************************************************
+ * Description: throughput in MB/s.
+ ************************************************************************************/
+static void *bench_byte_copy(void *dest, const void *src, size_t len)
+{
+	uint8_t *d = dest;
+	const uint8_t *s = src;
+
+	while (len--)
+		*d++ = *s++;
+
+	return dest;
+}
+
+static void *bench_byte_set(void *dest, int c, size_t len)
+{
+	uint8_t *d = dest;
+
+	while (len--)
+		*d++ = (uint8_t)c;
+
+	return dest;
+}
+
+static size_t bench_byte_len(const char *str)
+{
+	const char *p = str;
+
+	while (*p != '\0')
+		p++;
+
+	return (size_t)(p - str);
+}
+
+static uint64_t bench_iters(size_t size)
+{
+	uint64_t iters = BENCH_RUN_BYTES / size;
+
+	return iters > (8ull << 20) ? (8ull << 20) : iters;
+}
+
+static double bench_mbps(size_t size, uint64_t iters, uint64_t ns)
+{
+	return (double)size * (double)iters * 1000.0 / (double)(ns ? ns : 1) / 1.048576;
+}
+
+static double bench_copy(bench_copy_t volatile copy, size_t size, size_t doff,
+                         size_t soff)
+{
+	uint64_t i;
+	uint64_t t;
+	uint64_t iters = bench_iters(size);
+
+	t = bench_now_ns();
+	for (i = 0; i < iters; i++)
+		copy(run_dst + doff, run_src + soff, size);
+
+	return bench_mbps(size, iters, bench_now_ns() - t);
+}
+
+static double bench_set(bench_set_t volatile set, size_t size)
+{
+	uint64_t i;
+	uint64_t t;
+	uint64_t iters = bench_iters(size);
+
+	t = bench_now_ns();
+	for (i = 0; i < iters; i++)
+		set(run_dst, (int)i, size);
+
+	return bench_mbps(size, iters, bench_now_ns() - t);
+}
+
+static double bench_len(bench_len_t volatile len, size_t size)
+{
+	uint64_t i;
+	uint64_t t;
+	uint64_t iters = bench_iters(size);
+	volatile size_t sink = 0;
+
+	memset(run_src, 'a', size - 1);
+	run_src[size - 1] = '\0';
+	t = bench_now_ns();
+	for (i = 0; i < iters; i++)
+		sink += len((const char *)run_src);
+
+	(void)sink;
+	return bench_mbps(size, iters, bench_now_ns() - t);
+}
+
+static const size_t bench_sizes[] = {
+	1, 3, 8, 15, 16, 31, 32, 64, 100, 128, 256, 512, 1000, 1024, 2048, 4096,
+};
+
+static void bench_run(void)
+{
+	size_t i;
+	size_t size;
+
+	printf("%6s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "size",
+	       "cpy_byte", "pl_cpy", "libc_cpy", "pl_cpy+1", "pl_move", "set_byte",
+	       "pl_set", "libc_set", "len_byte", "pl_len", "libc_len");
+
+	bench_fill(run_src, sizeof(run_src));
+	for (i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+		size = bench_sizes[i];
+		printf("%6zu", size);
+		printf(" %8.0f", bench_copy(bench_byte_copy, size, 0, 0));
+		printf(" %8.0f", bench_copy(pl_memcpy, size, 0, 0));
+		printf(" %8.0f", bench_copy(memcpy, size, 0, 0));
+		printf(" %8.0f", bench_copy(pl_memcpy, size, 0, 1));
+		printf(" %8.0f", bench_copy(pl_memmove, size, 0, 0));
+		printf(" %8.0f", bench_set(bench_byte_set, size));
+		printf(" %8.0f", bench_set(pl_memset, size));
+		printf(" %8.0f", bench_set(memset, size));
+		printf(" %8.0f", bench_len(bench_byte_len, size));
+		printf(" %8.0f", bench_len(pl_strlen, size));
+		printf(" %8.0f\n", bench_len(strlen, size));
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	size_t rounds = BENCH_FUZZ_ROUNDS;
+
+	if (argc > 1 && strcmp(argv[1], "fuzz") == 0) {
+		if (argc > 2)
+			rounds = (size_t)strtoul(argv[2], NULL, 0);
+
+		return bench_fuzz(rounds) < 0 ? 1 : 0;
+	}
+
+	printf("string bench: MB/s, +1 is a misaligned source\n");
+	bench_run();
+	return 0;
+}